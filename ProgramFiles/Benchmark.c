@@ -0,0 +1,2064 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         Benchmark.c
+  Description:  Benchmarks for the matrix opaque object interface.
+                Run with the name of a benchmark as the only argument or with no arguments to run all of them.
+*/
+
+
+#define _DEFAULT_SOURCE    // sysconf with _SC_PHYS_PAGES
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Matrix.h"
+#include "MatrixFixed.h"
+#include "MatrixSparse.h"
+
+// the installed memory decides whether benchLarge can touch every entry of its matrix
+#ifdef __linux__
+#define LARGE_PHYS_PAGES
+#include <unistd.h>
+#endif
+
+#define ADD_N 2048                 // size of the matrices the N-ary addition is timed on
+#define ADD_MAX_TERMS 32           // most matrices the N-ary addition is timed on
+#define ALLOC_INLINE_MAX 64        // most entries a pooled matrix header stores, init allocates the entries of a larger copy on every call
+#define ALLOC_TIME 0.2             // seconds each operation is repeated for when counting its allocations
+#define ALLOC_WARMUP 3             // calls of each operation before its allocations are counted, which size the scratch arenas
+#define BANDED_N 1000000           // rows and columns of the tridiagonal system solved
+#define BANDED_DENSE_N 2048        // size of the banded matrix the operations are timed against the dense ones on
+#define BANDED_DENSE_K 3           // diagonals above and below its main diagonal
+#define BANDED_REPS 20             // times each banded matrix-vector product is repeated
+#define CHECK_TOL 1e-9             // largest difference from the reference a result of the benchmarks may have, they're sums of at most a few thousand products of entries near 1
+#define COFACTOR_TIME_LIMIT 2.0    // seconds after which the cofactor expansion is no longer timed
+#define FIXED_ITERS 200000         // calls each 4 x 4 operation is timed over
+#define LARGE_N 46341              // rows and columns of the matrix benchLarge checks, the smallest square matrix with more than 2^31 entries
+#define LARGE_BLOCK 48             // rows and columns of the block at its far corner that the operations are checked on
+#define NAIVE_MULT_MAX_N 1024      // largest size the textbook triple loop is timed for
+#define SIMD_MULT_N 512            // size of the product each instruction set is timed on
+#define SIMD_ELEM_N 1024           // size of the sums, differences and transposes each instruction set is timed on
+#define SPARSE_CHECK_M 70          // rows of the sparse matrices the operations are checked on
+#define SPARSE_CHECK_K 50          // columns of the left factor and rows of the right factor they're checked on
+#define SPARSE_CHECK_N 60          // columns of the right factor they're checked on
+#define SPARSE_CHECK_DENSITY 0.1   // fraction of their entries that aren't 0
+#define SPARSE_N 262144            // rows and columns of the sparse matrix the operations are timed on
+#define SPARSE_ROW_NNZ 8           // entries in each of its rows
+#define SPARSE_DENSE_N 2048        // size of the matrix the sparse operations are timed against the dense ones on
+#define SPARSE_DENSE_DENSITY 0.01  // fraction of its entries that aren't 0
+#define SPARSE_REPS 20             // times each matrix-vector product is repeated
+#define STRUCTURE_N 1024           // size of the matrices the structured operations are timed on
+#define STRUCTURE_POWER 10         // power the diagonal matrix is raised to
+#define SYMMETRIC_M 4096           // rows of the matrix whose Gram matrix is timed
+#define SYMMETRIC_N 1024           // columns of the matrix whose Gram matrix is timed, the size of the Gram matrix
+#define THREADS_MIN_N 1024         // smallest size the thread scaling of the multiplication is timed on
+#define THREADS_MAX_N 4096         // largest size the thread scaling of the multiplication is timed on
+#define VIEW_MIN_N 512             // smallest size the transposed operands are timed on
+#define VIEW_MAX_N 2048            // largest size the transposed operands are timed on
+
+typedef struct benchmark {
+	const char* name;
+	Status (*run)(void);
+} Benchmark;
+
+typedef struct detCheck {
+	const char* name;
+	double entries[9];    // 3 x 3 matrix in row-major order
+	double det;           // exact determinant, 0 if the matrix is singular
+} DetCheck;
+
+typedef struct indexCheck {
+	int rows;
+	int cols;
+} IndexCheck;
+
+typedef enum allocOp { ALLOC_OP_INIT, ALLOC_OP_MULT, ALLOC_OP_ADD, ALLOC_OP_TRANS, ALLOC_OP_POW, ALLOC_OP_DET, ALLOC_OP_INV, ALLOC_OP_SOLVE, ALLOC_OP_COUNT } AllocOp;    // operations benchAlloc counts
+
+
+
+
+/*********** Declarations for helper functions defined in Matrix.c **********/
+ptrdiff_t at2(int rows, int cols, int row, int col);
+size_t getSize(int rows, int cols);
+
+
+
+
+/*********** Declarations for helper functions defined in this file **********/
+/*
+FUNCTION
+  - Name:     benchAdd
+  - Purpose:  Report the memory throughput of the addition operation against the entry-at-a-time loop it used before for 2, 4, ... ADD_MAX_TERMS matrices of size ADD_N x ADD_N.
+              Throughput counts every term read once and the result written once.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the GB/s of both methods and the difference between their results for each number of terms.
+                   A difference above CHECK_TOL is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchAdd(void);
+
+
+/*
+FUNCTION
+  - Name:     benchAlloc
+  - Purpose:  Count the calls to the allocator made by each operation, through counting hooks set with matrix_setAllocator.
+              Each operation reuses its result matrix, so once the scratch arenas have grown during the warm-up calls a call should make no allocations.
+              init copies A into a new matrix and destroys it, which reuses a pooled header and only allocates entries too large to be stored in it.
+              Once a product is split across the pool, its workers are restarted to warm their arenas for its tiles, so this holds with any number of threads.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the allocations of the first call, the allocations per call after the warm-up and the time per call for each operation and size.
+                   An operation that makes any allocation after the warm-up, other than the entries of init, is counted in numFailedChecks.
+                   So is memory from the hooks that isn't aligned as asked, or still allocated once every matrix is destroyed and matrix_releaseCaches has returned.
+                   The default allocator is restored afterwards.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchAlloc(void);
+
+
+/*
+FUNCTION
+  - Name:     benchBanded
+  - Purpose:  Time the solve and matrix-vector product of a BANDED_N x BANDED_N tridiagonal matrix and report the residual of the solution,
+              then time the product, solve and determinant of a BANDED_DENSE_N x BANDED_DENSE_N matrix with BANDED_DENSE_K diagonals on each side against the dense operations,
+              then run the determinant and solve on the 3 x 3 matrices checked by benchDet.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time of each operation, the residual, the difference between the banded and dense results and the result of each check.
+                   A check that fails, or a residual or difference above CHECK_TOL, is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchBanded(void);
+
+
+/*
+FUNCTION
+  - Name:     benchDet
+  - Purpose:  Compare the determinant operation against cofactor expansion for n = 2..2000 and report the crossover,
+              then check that the determinant, inverse, solve and factorization tell singular 3 x 3 matrices from nonsingular ones whose rows or columns have very different scales.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time of both methods for each size and the result of each check. A check that fails is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchDet(void);
+
+
+/*
+FUNCTION
+  - Name:     benchFixed
+  - Purpose:  Report the latency of each 4 x 4 operation through the matrix opaque object interface, reusing the result, against the Mat4 value type.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the nanoseconds per call of both and the speedup for each operation.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchFixed(void);
+
+
+/*
+FUNCTION
+  - Name:     benchLarge
+  - Purpose:  Check the index arithmetic of the shapes in indexChecks, which have more entries than an int can index, through at2 and getSize without allocating them.
+              Then check that a LARGE_N x LARGE_N matrix is indexed correctly. The block at its far corner, past index 2^31, is filled and multiplied, added, inverted and transposed through views and compared with the same operations on a copy of it.
+              Only the pages that are written take memory, so this part runs wherever the matrix can be mapped.
+              If the machine has the memory for every entry twice over the whole matrix is also added to itself and transposed in place.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure, or the matrix itself couldn't be allocated.
+  - Summary:       Prints the size and last index of each shape, the difference of each check of the matrix, 0 if the entries match, and the time of the operations on the whole matrix.
+                   Prints that the checks of the matrix were skipped if it couldn't be allocated. A check that fails is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure after the matrix was allocated.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchLarge(void);
+
+
+/*
+FUNCTION
+  - Name:     benchMult
+  - Purpose:  Report the GFLOP/s of the multiplication operation against a textbook triple loop for square sizes 64..4096.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the GFLOP/s of both methods for each size.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchMult(void);
+
+
+/*
+FUNCTION
+  - Name:     benchSimd
+  - Purpose:  Time the multiplication, addition, subtraction and transpose kernels of every instruction set the CPU supports and check them against the scalar kernels.
+              Addition, subtraction and transpose must match the scalar result exactly.
+              Multiplication must be within the rounding error bound 2 n^2 eps of the scalar result for entries in [-1, 1].
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time and the difference from the scalar result of each kernel for each instruction set.
+                   An instruction set whose kernels don't match is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchSimd(void);
+
+
+/*
+FUNCTION
+  - Name:     benchSparse
+  - Purpose:  Check the sparse operations against the dense operations on small matrices for every pair of formats, then time them.
+              The matrix-vector product, the change of format, the transpose and the product of a SPARSE_N x SPARSE_N matrix with SPARSE_ROW_NNZ random entries in each row are timed,
+              and the matrix-vector product and the product of a SPARSE_DENSE_N x SPARSE_DENSE_N matrix with SPARSE_DENSE_DENSITY of its entries nonzero are timed against the dense operations.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the difference of each check, 0 up to rounding if the results match, and the time of each operation.
+                   A check whose difference is above CHECK_TOL, or above 0 for results without rounding, is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchSparse(void);
+
+
+/*
+FUNCTION
+  - Name:     benchStructure
+  - Purpose:  Time the operations that take a shortcut for the shape of a STRUCTURE_N x STRUCTURE_N matrix against the general algorithm:
+              the determinant of an upper triangular matrix, the inverse and power of a diagonal matrix, and the product of a permutation or diagonal matrix with a general matrix.
+              The general algorithm runs on the same matrix with a single entry of 1e-300 added outside of its shape, which changes the result by far less than rounding.
+              Then check that inverting 3 x 3 diagonal matrices with tiny, huge and 0 entries fails exactly when inverting them from their factors does.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time of both methods and the difference between their results for each operation, and the result of each check.
+                   A check that fails, or a difference above CHECK_TOL, is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchStructure(void);
+
+
+/*
+FUNCTION
+  - Name:     benchSymmetric
+  - Purpose:  Time the Gram matrix A^T A of a random SYMMETRIC_M x SYMMETRIC_N matrix against transposing A and multiplying,
+              then time solving a system with its Cholesky factorization against the LU solve of the dense Gram matrix.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time of both methods, the difference between their results and the memory each result takes.
+                   A difference above CHECK_TOL, or a matrix that isn't found positive definite and invertible, is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchSymmetric(void);
+
+
+/*
+FUNCTION
+  - Name:     benchThreads
+  - Purpose:  Report the GFLOP/s and speedup over one thread of the multiplication operation for 1, 2, 4, ... threads up to the default number of threads.
+              Square sizes from THREADS_MIN_N to THREADS_MAX_N are timed.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the GFLOP/s and speedup for each size and number of threads.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchThreads(void);
+
+
+/*
+FUNCTION
+  - Name:     benchView
+  - Purpose:  Compare A^T B and A^T + B computed from a copy of the transpose made with matrix_opTrans against a view of it made with matrix_viewTrans,
+              and A11 + B11 for the top left quarters computed from copies made with matrix_getEntry against views of them made with matrix_view.
+              Square sizes from VIEW_MIN_N to VIEW_MAX_N are timed, including the time to make the copies or the views.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Prints the time of both methods and the difference between their results for each size.
+                   A difference above CHECK_TOL is counted in numFailedChecks.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The benchmark stops early.
+  - Return value:  FAILURE
+*/
+static Status benchView(void);
+
+
+/*
+FUNCTION
+  - Name:     checkResult
+  - Purpose:  Count a check of a benchmark in numFailedChecks if it failed.
+PRECONDITION
+  - passed
+      Purpose:       Whether the result of the check is right.
+      Restrictions:  TRUE or FALSE
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Adds 1 to numFailedChecks if the check failed.
+  - Return value:  "ok" if it passed and "FAILED" otherwise, for the result column of the table.
+Failure
+  - N/A
+*/
+static const char* checkResult(Boolean passed);
+
+
+/*
+FUNCTION
+  - Name:     cofactorDet
+  - Purpose:  Reference determinant using recursive cofactor expansion along the first row with a new allocation for every minor.
+              This is the algorithm the determinant operation used before it was factored with LU.
+PRECONDITION
+  - entries
+      Purpose:       Entries of the matrix in row-major order.
+      Restrictions:  Array of size n * n.
+  - n
+      Purpose:       Rows and columns of the matrix.
+      Restrictions:  Any positive integer.
+  - pMem
+      Purpose:       Indicate if memory allocation fails.
+      Restrictions:  Not NULL and set to SUCCESS before the call.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns the determinant.
+  - Return value:  The determinant.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The status pMem points to is set to FAILURE.
+  - Return value:  0
+*/
+static double cofactorDet(const double* entries, int n, Status* pMem);
+
+
+/*
+FUNCTION
+  - Name:     countingAlloc, countingFree
+  - Purpose:  Allocator hooks that forward to aligned_alloc and free, count every allocation in numAllocs and the memory still allocated in numLiveAllocs.
+              There is no realloc hook, since realloc doesn't keep the alignment.
+PRECONDITION
+  - ptr
+      Purpose:       Memory to free.
+      Restrictions:  Memory from countingAlloc or NULL.
+  - size
+      Purpose:       Bytes to allocate.
+      Restrictions:  Any positive multiple of alignment.
+  - alignment
+      Purpose:       Alignment of the memory.
+      Restrictions:  Any power of 2 supported by aligned_alloc.
+  - userdata
+      Purpose:       Required by matrix_setAllocator.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Same as aligned_alloc and free.
+  - Return value:  Same as aligned_alloc.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Same as aligned_alloc.
+  - Return value:  NULL
+*/
+static void* countingAlloc(size_t size, size_t alignment, void* userdata);
+static void countingFree(void* ptr, void* userdata);
+
+
+/*
+FUNCTION
+  - Name:     fillRandom
+  - Purpose:  Fill an array with random entries in the range [-1, 1].
+PRECONDITION
+  - entries
+      Purpose:       Array to fill.
+      Restrictions:  Array of size size.
+  - size
+      Purpose:       Size of the array.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Fills the array.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void fillRandom(double* entries, int size);
+
+
+/*
+FUNCTION
+  - Name:     maxAbsDiff
+  - Purpose:  Find the largest magnitude of the difference between the entries of two matrices with the same dimensions.
+PRECONDITION
+  - hMx1, hMx2
+      Purpose:       Matrices to compare.
+      Restrictions:  Handles to valid matrix objects with rows x cols entries.
+  - rows, cols
+      Purpose:       Dimensions of the matrices.
+      Restrictions:  Any positive integers.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the largest difference.
+  - Return value:  The largest magnitude of the difference.
+Failure
+  - N/A
+*/
+static double maxAbsDiff(MATRIX hMx1, MATRIX hMx2, int rows, int cols);
+
+
+/*
+FUNCTION
+  - Name:     naiveAdd
+  - Purpose:  Reference N-ary addition that visits every term for one entry before moving to the next, like the addition operation did before it was streamed.
+PRECONDITION
+  - terms
+      Purpose:       Entries of the matrices being added.
+      Restrictions:  Array of numTerms arrays of size size.
+  - numTerms
+      Purpose:       Number of matrices.
+      Restrictions:  Any positive integer.
+  - res
+      Purpose:       Store the sum.
+      Restrictions:  Array of size size.
+  - size
+      Purpose:       Entries in each matrix.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the sum.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void naiveAdd(double** terms, int numTerms, double* res, int size);
+
+
+/*
+FUNCTION
+  - Name:     naiveMult
+  - Purpose:  Reference multiplication using the i-j-k triple loop the multiplication operation used before it was blocked.
+PRECONDITION
+  - a, b
+      Purpose:       Entries of the n x n matrices being multiplied in row-major order.
+      Restrictions:  Arrays of size n * n.
+  - c
+      Purpose:       Store the product.
+      Restrictions:  Array of size n * n.
+  - n
+      Purpose:       Rows and columns of the matrices.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the product.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void naiveMult(const double* a, const double* b, double* c, int n);
+
+
+/*
+FUNCTION
+  - Name:     now
+  - Purpose:  Get the current wall clock time in seconds.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the current time.
+  - Return value:  Time in seconds.
+Failure
+  - N/A
+*/
+static double now(void);
+
+
+/*
+FUNCTION
+  - Name:     randomMatrix
+  - Purpose:  Create a matrix with random entries in the range [-1, 1].
+PRECONDITION
+  - rows
+      Purpose:       Rows of the matrix.
+      Restrictions:  Any positive integer.
+  - cols
+      Purpose:       Columns of the matrix.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Creates the matrix.
+  - Return value:  Handle to a valid matrix object.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MATRIX randomMatrix(int rows, int cols);
+
+
+/*
+FUNCTION
+  - Name:     randomSparseMatrix
+  - Purpose:  Create a matrix where each entry is random in [-1, 1] with a given probability and 0 otherwise.
+PRECONDITION
+  - rows, cols
+      Purpose:       Dimensions of the matrix.
+      Restrictions:  Any positive integers.
+  - density
+      Purpose:       Probability that an entry isn't 0.
+      Restrictions:  Any number in [0, 1].
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Creates the matrix.
+  - Return value:  Handle to a valid matrix object.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MATRIX randomSparseMatrix(int rows, int cols, double density);
+
+
+/*
+FUNCTION
+  - Name:     runAllocOp
+  - Purpose:  Run one of the operations counted by benchAlloc.
+PRECONDITION
+  - op
+      Purpose:       Operation to run.
+      Restrictions:  Any AllocOp other than ALLOC_OP_COUNT.
+  - hMxA, hMxB
+      Purpose:       Operands. Only hMxA is used by the operations on one matrix.
+      Restrictions:  Handles to valid square matrix objects of the same size, hMxA invertible.
+  - phMxRes
+      Purpose:       Result, reused between calls.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Runs the operation.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure or hMxA isn't invertible.
+  - Summary:       The operation fails.
+  - Return value:  FAILURE
+*/
+static Status runAllocOp(AllocOp op, MATRIX hMxA, MATRIX hMxB, MATRIX* phMxRes);
+
+
+static long numAllocs = 0;                     // allocations made through the counting hooks
+static atomic_long numLiveAllocs = 0;          // memory from the counting hooks that hasn't been freed, workers allocate and free too
+static atomic_long numMisalignedAllocs = 0;    // memory from the counting hooks that doesn't start on a multiple of the alignment asked for
+static int numFailedChecks = 0;                // checks of the benchmarks whose result was wrong, which makes the program exit with 1
+static const DetCheck detChecks[] = {    // singular matrices and nonsingular ones whose rows or columns have very different scales, checked by benchDet and benchBanded
+	{ "large first row", { 1e20, 1e20, 0, 1, 2, 0, 0, 0, 1 }, 1e20 },
+	{ "large last column", { 1, 0, 1e16, 0, 1, 0, 0, 1, 1 }, 1 },
+	{ "small first column", { 1e-20, 1, 0, 0, 1, 0, 0, 0, 1 }, 1e-20 },
+	{ "singular 1..9", { 1, 2, 3, 4, 5, 6, 7, 8, 9 }, 0 },
+	{ "singular scaled row", { 1e20, 2e20, 3e20, 4, 5, 6, 5, 7, 9 }, 0 },
+};
+
+
+static const IndexCheck indexChecks[] = {    // shapes with more than 2^31 entries whose index arithmetic benchLarge checks without allocating them
+	{ LARGE_N, LARGE_N },
+	{ 3, 1000000000 },
+	{ INT_MAX, 2 },
+	{ INT_MAX, INT_MAX },
+};
+
+
+static const double diagonalChecks[] = { 1, 1e-300, DBL_TRUE_MIN, -DBL_MIN, 1e300, 0 };    // middle entry of the 3 x 3 diagonal matrices benchStructure inverts
+
+
+static const Benchmark benchmarks[] = {
+	{ "add", benchAdd },
+	{ "alloc", benchAlloc },
+	{ "banded", benchBanded },
+	{ "det", benchDet },
+	{ "fixed", benchFixed },
+	{ "large", benchLarge },
+	{ "mult", benchMult },
+	{ "simd", benchSimd },
+	{ "sparse", benchSparse },
+	{ "structure", benchStructure },
+	{ "symmetric", benchSymmetric },
+	{ "threads", benchThreads },
+	{ "view", benchView },
+};
+static const int benchmarksSize = sizeof(benchmarks) / sizeof(*benchmarks);
+
+
+
+
+int main(int argc, char** argv)
+{
+	Boolean found = FALSE;
+
+	srand(1);
+	for (int i = 0; i < benchmarksSize; ++i) {
+		if (argc < 2 || !strcmp(argv[1], benchmarks[i].name)) {
+			found = TRUE;
+			if (!benchmarks[i].run()) {
+				printf("Memory allocation failure. Exiting the benchmark.\n");
+				exit(1);
+			}
+		}
+	}
+
+	if (!found) {
+		printf("Unknown benchmark \"%s\". Available benchmarks:", argv[1]);
+		for (int i = 0; i < benchmarksSize; ++i)
+			printf(" %s", benchmarks[i].name);
+		printf("\n");
+		return 1;
+	}
+	if (numFailedChecks) {
+		printf("%d check%s failed.\n", numFailedChecks, (numFailedChecks == 1) ? "" : "s");
+		return 1;
+	}
+
+	return 0;
+}
+
+
+
+
+/***** Helper functions used only in this file *****/
+static Status benchAdd(void) {
+	MATRIX hMxs[ADD_MAX_TERMS] = { NULL };
+	MATRIX hMxRes = NULL;
+	double* terms[ADD_MAX_TERMS] = { NULL };
+	double* res;
+	double start, bytes, streamedTime, naiveTime;
+	double entry, diff;
+	int size = ADD_N * ADD_N;
+	Status mem = SUCCESS;
+
+	// the raw arrays for the reference loop share the entries of the matrices
+	if (!(res = malloc(sizeof(*res) * size)))
+		return FAILURE;
+	for (int i = 0; mem && i < ADD_MAX_TERMS; ++i) {
+		if (!(hMxs[i] = randomMatrix(ADD_N, ADD_N)) || !(terms[i] = malloc(sizeof(*terms[i]) * size)))
+			mem = FAILURE;
+		else {
+			for (int j = 0; j < size; ++j)
+				matrix_getEntry(hMxs[i], j / ADD_N, j % ADD_N, &terms[i][j]);
+		}
+	}
+
+	// fault in both results so the first timing doesn't include it
+	if (mem) {
+		mem = matrix_opAdd(hMxs, 2, &hMxRes);
+		naiveAdd(terms, 2, res, size);
+	}
+
+	printf("N-ary addition of %d x %d matrices: streamed vs. entry at a time (GB/s)\n", ADD_N, ADD_N);
+	printf("%6s %16s %16s %12s %8s\n", "terms", "entry at a time", "streamed", "difference", "check");
+	for (int numTerms = 2; mem && numTerms <= ADD_MAX_TERMS; numTerms *= 2) {
+		bytes = (numTerms + 1.0) * size * sizeof(double);
+		start = now();
+		mem = matrix_opAdd(hMxs, numTerms, &hMxRes);
+		streamedTime = now() - start;
+		start = now();
+		naiveAdd(terms, numTerms, res, size);
+		naiveTime = now() - start;
+		diff = 0;
+		for (int j = 0; mem && j < size; ++j) {
+			matrix_getEntry(hMxRes, j / ADD_N, j % ADD_N, &entry);
+			diff = fmax(diff, fabs(entry - res[j]));
+		}
+		if (mem)
+			printf("%6d %16.2f %16.2f %12g %8s\n", numTerms, bytes / naiveTime * 1e-9, bytes / streamedTime * 1e-9, diff, checkResult(diff <= CHECK_TOL));
+	}
+	printf("\n");
+
+	for (int i = 0; i < ADD_MAX_TERMS; ++i) {
+		matrix_destroy(&hMxs[i]);
+		free(terms[i]);
+	}
+	matrix_destroy(&hMxRes);
+	free(res);
+
+	return mem;
+}
+
+
+static Status benchAlloc(void) {
+	static const int sizes[] = { 4, 16, 64, 256 };
+	static const char* const opNames[ALLOC_OP_COUNT] = { "init", "mult", "add", "trans", "pow", "det", "inv", "solve" };
+	MATRIX hMxA, hMxB, hMxRes;
+	double start, time;
+	long firstAllocs, expectedAllocs, calls;
+	Status mem = SUCCESS;
+
+	matrix_setAllocator(countingAlloc, NULL, countingFree, NULL);
+
+	printf("Allocations per call with a reused result (after %d warm-up calls)\n", ALLOC_WARMUP);
+	printf("%6s %6s %12s %14s %12s %8s\n", "op", "n", "first call", "per call", "us per call", "check");
+	for (int i = 0; mem && i < (int)(sizeof(sizes) / sizeof(*sizes)); ++i) {
+		hMxA = randomMatrix(sizes[i], sizes[i]);
+		hMxB = randomMatrix(sizes[i], sizes[i]);
+		if (!hMxA || !hMxB)
+			mem = FAILURE;
+
+		for (AllocOp op = 0; mem && op < ALLOC_OP_COUNT; ++op) {
+			hMxRes = NULL;
+			numAllocs = 0;
+			mem = runAllocOp(op, hMxA, hMxB, &hMxRes);
+			firstAllocs = numAllocs;
+			for (int j = 1; mem && j < ALLOC_WARMUP; ++j)
+				mem = runAllocOp(op, hMxA, hMxB, &hMxRes);
+
+			numAllocs = 0;
+			calls = 0;
+			start = now();
+			do {
+				mem = runAllocOp(op, hMxA, hMxB, &hMxRes);
+				++calls;
+			} while (mem && (time = now() - start) < ALLOC_TIME);
+			expectedAllocs = (op == ALLOC_OP_INIT && sizes[i] * sizes[i] > ALLOC_INLINE_MAX) ? calls : 0;
+			if (mem) {
+				numFailedChecks += numAllocs != expectedAllocs;
+				printf("%6s %6d %12ld %14.3f %12.2f %8s\n", opNames[op], sizes[i], firstAllocs, (double)numAllocs / calls, time / calls * 1e6,
+				       (numAllocs == expectedAllocs) ? "ok" : "FAILED");
+			}
+			matrix_destroy(&hMxRes);
+		}
+
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+	}
+
+	// with every matrix destroyed, returning the arenas and pooled headers must leave nothing allocated, so a bump allocator could be reset here
+	matrix_releaseCaches();
+	if (mem) {
+		numFailedChecks += numLiveAllocs != 0 || numMisalignedAllocs != 0;
+		printf("%ld allocations still live after matrix_releaseCaches, %ld misaligned: %s\n", (long)numLiveAllocs, (long)numMisalignedAllocs,
+		       (numLiveAllocs == 0 && numMisalignedAllocs == 0) ? "ok" : "FAILED");
+	}
+	printf("\n");
+
+	matrix_setAllocator(NULL, NULL, NULL, NULL);
+
+	return mem;
+}
+
+
+static Status benchBanded(void) {
+	static const char* const opNames[] = { "A x", "solve", "det" };
+	MATRIX_BANDED hBd = NULL;
+	MATRIX hMxA = NULL, hMxB, hMxX = NULL, hMxAx = NULL, hMxExpected = NULL;
+	double dets[2];               // determinants of the banded and dense matrix
+	double start, bandedTime, denseTime;
+	double solveTime, multTime;
+	Boolean isInvertible;
+	Status mem;
+	int n = BANDED_N;
+
+
+	// a tridiagonal system with random entries, where nothing keeps the pivots away from 0 except the pivoting
+	hBd = matrix_bandedInit(n, 1, 1);
+	hMxB = randomMatrix(n, 1);
+	mem = hBd && hMxB;
+	for (int i = 0; mem && i < n; ++i) {
+		for (int j = (i > 0) ? i - 1 : 0; j <= i + 1 && j < n; ++j)
+			matrix_bandedSetEntry(hBd, i, j, 2.0 * rand() / RAND_MAX - 1.0);
+	}
+	if (mem) {
+		start = now();
+		mem = matrix_bandedSolve(hBd, hMxB, &isInvertible, &hMxX) || isInvertible;
+		solveTime = now() - start;
+	}
+	if (mem && !isInvertible) {
+		start = now();
+		for (int rep = 0; mem && rep < BANDED_REPS; ++rep)
+			mem = matrix_bandedMult(hBd, hMxX, &hMxAx);
+		multTime = (now() - start) / BANDED_REPS;
+		if (mem) {
+			printf("%d x %d tridiagonal matrix A\n", n, n);
+			double residual = maxAbsDiff(hMxAx, hMxB, n, 1);
+			printf("%10s %10s %12s %8s\n", "operation", "time (ms)", "residual", "check");
+			printf("%10s %10.2f %12g %8s\n", "solve", solveTime * 1e3, residual, checkResult(residual <= CHECK_TOL));
+			printf("%10s %10.2f\n", "A x", multTime * 1e3);
+		}
+	}
+	else if (mem)
+		printf("%d x %d tridiagonal matrix A is invertible\n", n, n);
+	printf("\n");
+	matrix_bandedDestroy(&hBd);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxX);
+	matrix_destroy(&hMxAx);
+
+	// the same operations on a banded matrix small enough to store densely
+	n = BANDED_DENSE_N;
+	hMxA = randomMatrix(n, n);
+	hMxB = randomMatrix(n, 1);
+	mem = mem && hMxA && hMxB && (hBd = matrix_bandedInitDense(hMxA, BANDED_DENSE_K, BANDED_DENSE_K)) && matrix_bandedToDense(hBd, &hMxA);
+	if (mem) {
+		printf("%d x %d matrix A with %d diagonals on each side: banded vs. dense (ms)\n", n, n, BANDED_DENSE_K);
+		printf("%6s %10s %10s %9s %12s %8s\n", "op", "banded", "dense", "speedup", "difference", "check");
+	}
+	for (int op = 0; mem && op < (int)(sizeof(opNames) / sizeof(*opNames)); ++op) {
+		int reps = op ? 1 : BANDED_REPS;
+		for (int pass = 0; mem && pass < 2; ++pass) {
+			MATRIX* phMxOut = pass ? &hMxExpected : &hMxX;
+			start = now();
+			for (int rep = 0; mem && rep < reps; ++rep) {
+				switch (op) {
+				case 0: mem = pass ? matrix_opMult(hMxA, hMxB, phMxOut) : matrix_bandedMult(hBd, hMxB, phMxOut); break;
+				case 1: mem = pass ? matrix_opSolve(hMxA, hMxB, &isInvertible, phMxOut) : matrix_bandedSolve(hBd, hMxB, &isInvertible, phMxOut); break;
+				default: dets[pass] = pass ? matrix_opDet(hMxA, &mem) : matrix_bandedDet(hBd, &mem); break;
+				}
+			}
+			if (pass)
+				denseTime = (now() - start) / reps;
+			else
+				bandedTime = (now() - start) / reps;
+		}
+		if (mem) {
+			double diff = (op < 2) ? maxAbsDiff(hMxX, hMxExpected, n, 1) : fabs(dets[0] - dets[1]) / fabs(dets[1]);
+			printf("%6s %10.3f %10.2f %9.1f %12g %8s\n", opNames[op], bandedTime * 1e3, denseTime * 1e3, denseTime / bandedTime, diff, checkResult(diff <= CHECK_TOL));
+		}
+	}
+	printf("\n");
+	matrix_bandedDestroy(&hBd);
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+
+	// the banded factorization must tell the same matrices apart as the dense one, with every entry of the 3 x 3 matrix in the band
+	if (mem) {
+		printf("Singular matrix checks with 2 diagonals on each side\n");
+		printf("%20s %12s %12s %8s\n", "matrix", "det", "expected", "result");
+		mem = (hMxA = matrix_initDims(3, 3)) && (hMxB = matrix_initDims(3, 1));
+	}
+	for (int c = 0; mem && c < (int)(sizeof(detChecks) / sizeof(*detChecks)); ++c) {
+		Boolean singular = detChecks[c].det == 0;
+		Boolean passed;
+		Status solveStatus;
+		mem = matrix_newMatrix(hMxA, detChecks[c].entries, 3, 3) && (hBd = matrix_bandedInitDense(hMxA, 2, 2));
+		if (!mem)
+			break;
+		dets[0] = matrix_bandedDet(hBd, &mem);
+		solveStatus = matrix_bandedSolve(hBd, hMxB, &isInvertible, &hMxX);
+		matrix_bandedDestroy(&hBd);
+
+		passed = mem && fabs(dets[0] - detChecks[c].det) <= 1e-12 * fabs(detChecks[c].det) && isInvertible == singular && solveStatus == !singular;
+		numFailedChecks += !passed;
+		printf("%20s %12g %12g %8s\n", detChecks[c].name, dets[0], detChecks[c].det, passed ? "ok" : "FAILED");
+	}
+	printf("\n");
+
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxX);
+	matrix_destroy(&hMxExpected);
+
+	return mem;
+}
+
+
+static Status benchDet(void) {
+	static const int sizes[] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 16, 32, 64, 128, 256, 512, 1000, 2000 };
+	MATRIX hMx, hMxB = NULL, hMxRes = NULL;
+	MATRIX_FACTOR hFac;
+	double* entries;
+	double start, luTime, cofTime = 0;
+	double luDet, cofDet = 0, factorDet;
+	int reps;
+	int crossover = 0;
+	Boolean timeCofactor = TRUE;
+	Boolean invSingular, factorInvSingular, solveSingular, factorSolveSingular, passed;
+	Status invStatus, factorInvStatus, solveStatus, factorSolveStatus;
+	Status mem;
+
+	printf("Determinant: LU with partial pivoting vs. cofactor expansion\n");
+	printf("%6s %16s %16s %14s\n", "n", "cofactor (s)", "LU (s)", "rel. diff");
+	for (int s = 0; s < (int)(sizeof(sizes) / sizeof(*sizes)); ++s) {
+		int n = sizes[s];
+		if (!(hMx = randomMatrix(n, n)))
+			return FAILURE;
+		if (!(entries = malloc(sizeof(*entries) * n * n))) {
+			matrix_destroy(&hMx);
+			return FAILURE;
+		}
+		for (int i = 0; i < n; ++i) {
+			for (int j = 0; j < n; ++j)
+				matrix_getEntry(hMx, i, j, &entries[i * n + j]);
+		}
+
+		// repeat small sizes so the timer has something to measure
+		reps = n <= 64 ? 1000 : 1;
+		start = now();
+		for (int r = 0; r < reps; ++r) {
+			luDet = matrix_opDet(hMx, &mem);
+			if (!mem) {
+				matrix_destroy(&hMx);
+				free(entries);
+				return FAILURE;
+			}
+		}
+		luTime = (now() - start) / reps;
+
+		if (timeCofactor) {
+			reps = n <= 6 ? 1000 : 1;
+			start = now();
+			for (int r = 0; r < reps; ++r) {
+				mem = SUCCESS;
+				cofDet = cofactorDet(entries, n, &mem);
+				if (!mem) {
+					matrix_destroy(&hMx);
+					free(entries);
+					return FAILURE;
+				}
+			}
+			cofTime = (now() - start) / reps;
+			if (!crossover && cofTime > luTime)
+				crossover = n;
+			printf("%6d %16.3e %16.3e %14.2e\n", n, cofTime, luTime, cofDet != 0 ? (luDet - cofDet) / cofDet : luDet);
+			if (cofTime * (n + 1) > COFACTOR_TIME_LIMIT)
+				timeCofactor = FALSE;
+		}
+		else
+			printf("%6d %16s %16.3e %14s\n", n, "-", luTime, "-");
+
+		matrix_destroy(&hMx);
+		free(entries);
+	}
+	if (crossover)
+		printf("LU is faster from n = %d\n\n", crossover);
+	else
+		printf("No crossover in the measured range\n\n");
+
+	// a matrix is singular only if its determinant is 0, however the scales of its rows and columns differ
+	printf("Singular matrix checks\n");
+	printf("%20s %12s %12s %12s %8s\n", "matrix", "det", "expected", "factorDet", "result");
+	mem = (hMx = matrix_initDims(3, 3)) && (hMxB = matrix_initDims(3, 1));
+	for (int c = 0; mem && c < (int)(sizeof(detChecks) / sizeof(*detChecks)); ++c) {
+		Boolean singular = detChecks[c].det == 0;
+		mem = matrix_newMatrix(hMx, detChecks[c].entries, 3, 3) && (hFac = matrix_factorize(hMx));
+		if (!mem)
+			break;
+		luDet = matrix_opDet(hMx, &mem);
+		factorDet = matrix_factorDet(hFac);
+		invStatus = matrix_opInv(hMx, &invSingular, &hMxRes);
+		factorInvStatus = matrix_factorInv(hFac, &factorInvSingular, &hMxRes);
+		solveStatus = matrix_opSolve(hMx, hMxB, &solveSingular, &hMxRes);
+		factorSolveStatus = matrix_factorSolve(hFac, hMxB, &factorSolveSingular, &hMxRes);
+		matrix_factorDestroy(&hFac);
+
+		// a singular matrix fails to be inverted or solved with the flag set, which is the only reason a 3 x 3 inverse or solve can fail
+		passed = mem && fabs(luDet - detChecks[c].det) <= 1e-12 * fabs(detChecks[c].det) && fabs(factorDet - detChecks[c].det) <= 1e-12 * fabs(detChecks[c].det)
+		         && invSingular == singular && invStatus == !singular && factorInvSingular == singular && factorInvStatus == !singular
+		         && solveSingular == singular && solveStatus == !singular && factorSolveSingular == singular && factorSolveStatus == !singular;
+		numFailedChecks += !passed;
+		printf("%20s %12g %12g %12g %8s\n", detChecks[c].name, luDet, detChecks[c].det, factorDet, passed ? "ok" : "FAILED");
+	}
+	printf("\n");
+	matrix_destroy(&hMx);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxRes);
+
+	return mem;
+}
+
+
+static Status benchFixed(void) {
+	static const char* const opNames[] = { "mult", "trans", "pow", "det", "inv" };
+	Mat4 a, b, res;
+	const Mat4* volatile pA = &a;    // the operands are read through volatile pointers so the inlined operations can't be hoisted out of the loops
+	const Mat4* volatile pB = &b;
+	MATRIX hMxA = NULL, hMxB = NULL, hMxRes = NULL;
+	Boolean isInvertible;
+	double start, matrixTime, fixedTime;
+	double sum = 0;    // a different entry of each result is added to it and it is printed, so no part of the calls can be optimized out
+	Status mem = SUCCESS;
+
+	fillRandom(&a.m[0][0], 16);
+	fillRandom(&b.m[0][0], 16);
+	if (!mat4_toMatrix(&a, &hMxA) || !mat4_toMatrix(&b, &hMxB))
+		mem = FAILURE;
+
+	printf("4 x 4 operations: matrix object vs. Mat4 (ns per call)\n");
+	printf("%6s %14s %10s %9s\n", "op", "matrix object", "Mat4", "speedup");
+	for (int op = 0; mem && op < (int)(sizeof(opNames) / sizeof(*opNames)); ++op) {
+		start = now();
+		for (int i = 0; mem && i < FIXED_ITERS; ++i) {
+			switch (op) {
+			case 0: mem = matrix_opMult(hMxA, hMxB, &hMxRes); break;
+			case 1: mem = matrix_opTrans(hMxA, &hMxRes); break;
+			case 2: mem = matrix_opPow(hMxA, 5, &hMxRes); break;
+			case 3: sum += matrix_opDet(hMxA, &mem); break;
+			default: mem = matrix_opInv(hMxA, &isInvertible, &hMxRes); break;
+			}
+		}
+		matrixTime = now() - start;
+
+		// a loop for each operation, so the code inlined into it is only that operation
+		start = now();
+		switch (op) {
+		case 0:
+			for (int i = 0; i < FIXED_ITERS; ++i) {
+				res = mat4_opMult(pA, pB);
+				sum += res.m[i & 3][(i >> 2) & 3];
+			}
+			break;
+		case 1:
+			for (int i = 0; i < FIXED_ITERS; ++i) {
+				res = mat4_opTrans(pA);
+				sum += res.m[i & 3][(i >> 2) & 3];
+			}
+			break;
+		case 2:
+			for (int i = 0; i < FIXED_ITERS; ++i) {
+				res = mat4_opPow(pA, 5);
+				sum += res.m[i & 3][(i >> 2) & 3];
+			}
+			break;
+		case 3:
+			for (int i = 0; i < FIXED_ITERS; ++i)
+				sum += mat4_opDet(pA);
+			break;
+		default:
+			for (int i = 0; i < FIXED_ITERS; ++i) {
+				mat4_opInv(pA, &res);
+				sum += res.m[i & 3][(i >> 2) & 3];
+			}
+			break;
+		}
+		fixedTime = now() - start;
+
+		if (mem)
+			printf("%6s %14.1f %10.1f %9.1f\n", opNames[op], matrixTime / FIXED_ITERS * 1e9, fixedTime / FIXED_ITERS * 1e9, matrixTime / fixedTime);
+	}
+	printf("(checksum %g)\n\n", sum);
+
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxRes);
+
+	return mem;
+}
+
+
+static Status benchLarge(void) {
+	MATRIX hMxs[2];               // operands of the additions
+	MATRIX hMx, hMxBlock, hMxCorner = NULL, hMxTrans = NULL, hMxTransCorner = NULL;
+	MATRIX hMxRes = NULL, hMxExpected = NULL;
+	int start = LARGE_N - LARGE_BLOCK;    // first row and column of the block at the far corner
+	size_t size = (size_t)LARGE_N * LARGE_N;
+	double physBytes = 0;         // installed memory, 0 if it's unknown
+	double entry, expected, diff;
+	double startTime, elapsed;
+	Boolean isInvertible, passed;
+	Status mem;
+
+
+	// the index arithmetic needs no memory, so it's checked even where the matrix below can't be mapped
+	printf("Index arithmetic of shapes with more than 2^31 entries\n");
+	printf("%23s %20s %20s %8s\n", "shape", "size", "last index", "check");
+	for (int c = 0; c < (int)(sizeof(indexChecks) / sizeof(*indexChecks)); ++c) {
+		int rows = indexChecks[c].rows;
+		int cols = indexChecks[c].cols;
+		unsigned long long expectedSize = (unsigned long long)rows * (unsigned long long)cols;
+		ptrdiff_t last = at2(rows, cols, rows - 1, cols - 1);
+		passed = getSize(rows, cols) == expectedSize && last == (ptrdiff_t)(expectedSize - 1) && at2(rows, cols, rows - 1, 0) == (ptrdiff_t)(expectedSize - cols)
+		         && at2(rows, cols, rows, 0) == -1 && at2(rows, cols, 0, cols) == -1;
+		printf("%10d x %10d %20zu %20td %8s\n", rows, cols, getSize(rows, cols), last, checkResult(passed));
+	}
+	printf("\n");
+
+	printf("%d x %d matrix, %zu entries (%.1f GB)\n", LARGE_N, LARGE_N, size, size * sizeof(double) / 1e9);
+	if (!(hMx = matrix_initDims(LARGE_N, LARGE_N))) {
+		printf("Skipped, the matrix couldn't be allocated.\n\n");
+		return SUCCESS;
+	}
+	printf("%22s %12s %10s %8s\n", "check", "difference", "time (s)", "result");
+
+	// the last entry, whose index is past 2^31, getEntry gives 0 if it's out of bounds
+	matrix_setEntry(hMx, LARGE_N - 1, LARGE_N - 1, 1.5);
+	matrix_getEntry(hMx, LARGE_N - 1, LARGE_N - 1, &entry);
+	diff = fabs((double)matrix_getSize(hMx) - (double)size);
+	printf("%22s %12g %10s %8s\n", "size", diff, "", checkResult(matrix_getSize(hMx) == size));
+	diff = fabs(entry - 1.5);
+	printf("%22s %12g %10s %8s\n", "last entry", diff, "", checkResult(diff == 0));
+
+	// operations on the block at the far corner against the same operations on a copy of it that's small enough for int indices
+	hMxBlock = randomMatrix(LARGE_BLOCK, LARGE_BLOCK);
+	hMxCorner = matrix_view(hMx, start, LARGE_BLOCK, start, LARGE_BLOCK);
+	mem = hMxBlock && hMxCorner && matrix_copy(&hMxCorner, hMxBlock);
+	if (mem) {
+		diff = maxAbsDiff(hMxCorner, hMxBlock, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "copy into view", diff, "", checkResult(diff == 0));
+	}
+	if (mem && (mem = matrix_opMult(hMxCorner, hMxCorner, &hMxRes) && matrix_opMult(hMxBlock, hMxBlock, &hMxExpected))) {
+		diff = maxAbsDiff(hMxRes, hMxExpected, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "mult", diff, "", checkResult(diff <= CHECK_TOL));
+	}
+	if (mem) {
+		hMxs[0] = hMxs[1] = hMxCorner;
+		mem = matrix_opAdd(hMxs, 2, &hMxRes);
+		hMxs[0] = hMxs[1] = hMxBlock;
+		mem = mem && matrix_opAdd(hMxs, 2, &hMxExpected);
+	}
+	if (mem) {
+		diff = maxAbsDiff(hMxRes, hMxExpected, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "add", diff, "", checkResult(diff == 0));
+	}
+	if (mem && (mem = matrix_opInv(hMxCorner, &isInvertible, &hMxRes) && matrix_opInv(hMxBlock, &isInvertible, &hMxExpected))) {
+		diff = maxAbsDiff(hMxRes, hMxExpected, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "inv", diff, "", checkResult(diff <= CHECK_TOL));
+	}
+	if (mem) {
+		hMxTrans = matrix_viewTrans(hMx);
+		hMxTransCorner = hMxTrans ? matrix_view(hMxTrans, start, LARGE_BLOCK, start, LARGE_BLOCK) : NULL;
+		mem = hMxTransCorner && matrix_opTrans(hMxBlock, &hMxExpected);
+	}
+	if (mem) {
+		diff = maxAbsDiff(hMxTransCorner, hMxExpected, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "trans view", diff, "", checkResult(diff == 0));
+	}
+	if (mem && (mem = matrix_opTransInPlace(hMxCorner))) {
+		diff = maxAbsDiff(hMxCorner, hMxExpected, LARGE_BLOCK, LARGE_BLOCK);
+		printf("%22s %12g %10s %8s\n", "trans in place of view", diff, "", checkResult(diff == 0));
+	}
+
+	// the whole matrix, which needs memory for every entry of it and of the sum
+#ifdef LARGE_PHYS_PAGES
+	physBytes = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+#endif
+	if (mem && physBytes < 2.0 * size * sizeof(double))
+		printf("Operations on the whole matrix skipped, they need %.1f GB of memory.\n", 2.0 * size * sizeof(double) / 1e9);
+	else if (mem) {
+		hMxs[0] = hMxs[1] = hMx;
+		startTime = now();
+		if ((mem = matrix_opAdd(hMxs, 2, &hMxRes))) {
+			elapsed = now() - startTime;
+			matrix_getEntry(hMxRes, 0, 0, &diff);
+			diff = fabs(diff);
+			for (int i = 0; i < LARGE_BLOCK; ++i) {
+				for (int j = 0; j < LARGE_BLOCK; ++j) {
+					matrix_getEntry(hMxRes, start + i, start + j, &entry);
+					matrix_getEntry(hMxCorner, i, j, &expected);
+					diff = fmax(diff, fabs(entry - 2 * expected));
+				}
+			}
+			printf("%22s %12g %10.2f %8s\n", "add whole matrix", diff, elapsed, checkResult(diff == 0));
+		}
+		matrix_destroy(&hMxRes);
+
+		// the block at the far corner is transposed back to how it was copied in
+		startTime = now();
+		if (mem && (mem = matrix_opTransInPlace(hMx))) {
+			elapsed = now() - startTime;
+			diff = maxAbsDiff(hMxCorner, hMxBlock, LARGE_BLOCK, LARGE_BLOCK);
+			printf("%22s %12g %10.2f %8s\n", "trans whole in place", diff, elapsed, checkResult(diff == 0));
+		}
+	}
+	printf("\n");
+
+	matrix_destroy(&hMxCorner);
+	matrix_destroy(&hMxTransCorner);
+	matrix_destroy(&hMxTrans);
+	matrix_destroy(&hMx);
+	matrix_destroy(&hMxBlock);
+	matrix_destroy(&hMxRes);
+	matrix_destroy(&hMxExpected);
+
+	return mem;
+}
+
+
+static Status benchMult(void) {
+	MATRIX hMx1, hMx2, hMxRes = NULL;
+	double *a, *b, *c;
+	double start, flops, blockedTime, naiveTime;
+	int reps;
+
+	printf("Multiplication: blocked kernel vs. textbook triple loop (GFLOP/s)\n");
+	printf("%6s %16s %16s\n", "n", "triple loop", "blocked");
+	for (int n = 64; n <= 4096; n *= 2) {
+		flops = 2.0 * n * n * n;
+		if (!(hMx1 = randomMatrix(n, n)))
+			return FAILURE;
+		if (!(hMx2 = randomMatrix(n, n))) {
+			matrix_destroy(&hMx1);
+			return FAILURE;
+		}
+
+		// repeat small sizes so the timer has something to measure
+		reps = n <= 256 ? 20 : 1;
+		start = now();
+		for (int r = 0; r < reps; ++r) {
+			if (!matrix_opMult(hMx1, hMx2, &hMxRes)) {
+				matrix_destroy(&hMx1);
+				matrix_destroy(&hMx2);
+				return FAILURE;
+			}
+		}
+		blockedTime = (now() - start) / reps;
+
+		if (n <= NAIVE_MULT_MAX_N) {
+			a = malloc(sizeof(*a) * n * n);
+			b = malloc(sizeof(*b) * n * n);
+			c = malloc(sizeof(*c) * n * n);
+			if (!a || !b || !c) {
+				free(a);
+				free(b);
+				free(c);
+				matrix_destroy(&hMx1);
+				matrix_destroy(&hMx2);
+				matrix_destroy(&hMxRes);
+				return FAILURE;
+			}
+			fillRandom(a, n * n);
+			fillRandom(b, n * n);
+			start = now();
+			for (int r = 0; r < reps; ++r)
+				naiveMult(a, b, c, n);
+			naiveTime = (now() - start) / reps;
+			printf("%6d %16.2f %16.2f\n", n, flops / naiveTime * 1e-9, flops / blockedTime * 1e-9);
+			free(a);
+			free(b);
+			free(c);
+		}
+		else
+			printf("%6d %16s %16.2f\n", n, "-", flops / blockedTime * 1e-9);
+
+		matrix_destroy(&hMx1);
+		matrix_destroy(&hMx2);
+	}
+	matrix_destroy(&hMxRes);
+	printf("\n");
+
+	return SUCCESS;
+}
+
+
+static Status benchSimd(void) {
+	static const char* levelNames[] = { "scalar", "SSE2", "AVX2+FMA", "AVX-512" };
+	MATRIX hMxsMult[2] = { NULL, NULL };                // factors of the product
+	MATRIX hMxsElem[2] = { NULL, NULL };                // terms of the sum and difference
+	MATRIX hMxsRef[4] = { NULL, NULL, NULL, NULL };     // scalar product, sum, difference and transpose
+	MATRIX hMxsRes[4] = { NULL, NULL, NULL, NULL };     // product, sum, difference and transpose for the instruction set being timed
+	double times[4];
+	double diffs[4];
+	double start;
+	double multTol = 2.0 * SIMD_MULT_N * SIMD_MULT_N * DBL_EPSILON;
+	SimdLevel detected = matrix_getSimdLevel();
+	Status mem = SUCCESS;
+
+	hMxsMult[0] = randomMatrix(SIMD_MULT_N, SIMD_MULT_N);
+	hMxsMult[1] = randomMatrix(SIMD_MULT_N, SIMD_MULT_N);
+	hMxsElem[0] = randomMatrix(SIMD_ELEM_N, SIMD_ELEM_N);
+	hMxsElem[1] = randomMatrix(SIMD_ELEM_N, SIMD_ELEM_N);
+	if (!hMxsMult[0] || !hMxsMult[1] || !hMxsElem[0] || !hMxsElem[1])
+		mem = FAILURE;
+
+	printf("SIMD kernels: time (ms) and max difference from the scalar kernels, detected %s\n", levelNames[detected]);
+	printf("%-10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "level", "mult", "diff", "add", "diff", "sub", "diff", "trans", "diff");
+	for (int level = SIMD_SCALAR; mem && level <= SIMD_AVX512; ++level) {
+		if (!matrix_setSimdLevel(level)) {
+			printf("%-10s %10s\n", levelNames[level], "unsupported");
+			continue;
+		}
+
+		start = now();
+		mem = matrix_opMult(hMxsMult[0], hMxsMult[1], &hMxsRes[0]);
+		times[0] = now() - start;
+		start = now();
+		mem = mem && matrix_opAdd(hMxsElem, 2, &hMxsRes[1]);
+		times[1] = now() - start;
+		start = now();
+		mem = mem && matrix_opSub(hMxsElem, 2, &hMxsRes[2]);
+		times[2] = now() - start;
+		start = now();
+		mem = mem && matrix_opTrans(hMxsElem[0], &hMxsRes[3]);
+		times[3] = now() - start;
+		if (!mem)
+			break;
+
+		// the scalar results are the reference for the other instruction sets
+		if (level == SIMD_SCALAR) {
+			for (int i = 0; i < 4; ++i) {
+				hMxsRef[i] = hMxsRes[i];
+				hMxsRes[i] = NULL;
+			}
+		}
+		diffs[0] = maxAbsDiff(hMxsRef[0], level == SIMD_SCALAR ? hMxsRef[0] : hMxsRes[0], SIMD_MULT_N, SIMD_MULT_N);
+		for (int i = 1; i < 4; ++i)
+			diffs[i] = maxAbsDiff(hMxsRef[i], level == SIMD_SCALAR ? hMxsRef[i] : hMxsRes[i], SIMD_ELEM_N, SIMD_ELEM_N);
+
+		printf("%-10s", levelNames[level]);
+		for (int i = 0; i < 4; ++i)
+			printf(" %10.2f %10.1e", times[i] * 1e3, diffs[i]);
+		printf("  %s\n", checkResult(diffs[0] <= multTol && !diffs[1] && !diffs[2] && !diffs[3]));
+	}
+	matrix_setSimdLevel(detected);
+	printf("\n");
+
+	for (int i = 0; i < 2; ++i) {
+		matrix_destroy(&hMxsMult[i]);
+		matrix_destroy(&hMxsElem[i]);
+	}
+	for (int i = 0; i < 4; ++i) {
+		matrix_destroy(&hMxsRef[i]);
+		matrix_destroy(&hMxsRes[i]);
+	}
+
+	return mem;
+}
+
+
+static Status benchSparse(void) {
+	static const char* const formatNames[] = { "CSR", "CSC" };
+	MATRIX hMxs[2];               // operands of the dense additions and subtractions
+	MATRIX hMxA, hMxB, hMxC, hMxX = NULL;
+	MATRIX hMxDense = NULL, hMxExpected = NULL;
+	MATRIX_SPARSE hSpA = NULL, hSpB = NULL, hSpC = NULL, hSpRes = NULL;
+	SparseFormat formatA, formatB;
+	int* rowIdx = NULL;
+	int* colIdx = NULL;
+	double* values = NULL;
+	size_t nnz = 0;
+	double diffs[6];
+	double entry, start, sparseTime, denseTime;
+	Status mem;
+
+
+	// every operation against the dense one for each pair of formats of the operands
+	hMxA = randomSparseMatrix(SPARSE_CHECK_M, SPARSE_CHECK_K, SPARSE_CHECK_DENSITY);
+	hMxB = randomSparseMatrix(SPARSE_CHECK_M, SPARSE_CHECK_K, SPARSE_CHECK_DENSITY);
+	hMxC = randomSparseMatrix(SPARSE_CHECK_K, SPARSE_CHECK_N, SPARSE_CHECK_DENSITY);
+	mem = hMxA && hMxB && hMxC;
+	hMxs[0] = hMxA;
+	hMxs[1] = hMxB;
+	printf("Sparse operations vs. dense operations, A and B %d x %d, C %d x %d (difference)\n", SPARSE_CHECK_M, SPARSE_CHECK_K, SPARSE_CHECK_K, SPARSE_CHECK_N);
+	printf("%8s %8s %8s %8s %8s %10s %8s %8s\n", "formats", "toDense", "A + B", "A - B", "A^T", "A C dense", "A C", "check");
+	for (int f = 0; mem && f < 4; ++f) {
+		formatA = (f / 2) ? SPARSE_CSC : SPARSE_CSR;
+		formatB = (f % 2) ? SPARSE_CSC : SPARSE_CSR;
+		mem = (hSpA = matrixSparse_initDense(hMxA, formatA)) && (hSpB = matrixSparse_initDense(hMxB, formatB)) && (hSpC = matrixSparse_initDense(hMxC, formatB));
+		if (mem && (mem = matrixSparse_toDense(hSpA, &hMxDense)))
+			diffs[0] = maxAbsDiff(hMxDense, hMxA, SPARSE_CHECK_M, SPARSE_CHECK_K);
+		if (mem && (mem = matrixSparse_opAdd(hSpA, hSpB, &hSpRes) && matrixSparse_toDense(hSpRes, &hMxDense) && matrix_opAdd(hMxs, 2, &hMxExpected)))
+			diffs[1] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_CHECK_M, SPARSE_CHECK_K);
+		if (mem && (mem = matrixSparse_opSub(hSpA, hSpB, &hSpRes) && matrixSparse_toDense(hSpRes, &hMxDense) && matrix_opSub(hMxs, 2, &hMxExpected)))
+			diffs[2] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_CHECK_M, SPARSE_CHECK_K);
+		if (mem && (mem = matrixSparse_opTrans(hSpA, &hSpRes) && matrixSparse_toDense(hSpRes, &hMxDense) && matrix_opTrans(hMxA, &hMxExpected)))
+			diffs[3] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_CHECK_K, SPARSE_CHECK_M);
+		if (mem && (mem = matrixSparse_opMultDense(hSpA, hMxC, &hMxDense) && matrix_opMult(hMxA, hMxC, &hMxExpected)))
+			diffs[4] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_CHECK_M, SPARSE_CHECK_N);
+		if (mem && (mem = matrixSparse_opMult(hSpA, hSpC, &hSpRes) && matrixSparse_toDense(hSpRes, &hMxDense)))
+			diffs[5] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_CHECK_M, SPARSE_CHECK_N);
+		if (mem)
+			printf("%4s %3s %8g %8g %8g %8g %10g %8g %8s\n", formatNames[formatA], formatNames[formatB], diffs[0], diffs[1], diffs[2], diffs[3], diffs[4], diffs[5],
+			       checkResult(!diffs[0] && !diffs[1] && !diffs[2] && !diffs[3] && diffs[4] <= CHECK_TOL && diffs[5] <= CHECK_TOL));
+		matrixSparse_destroy(&hSpA);
+		matrixSparse_destroy(&hSpB);
+		matrixSparse_destroy(&hSpC);
+		matrixSparse_destroy(&hSpRes);
+	}
+
+	// triplets for every entry of A split into two halves and listed backwards, which have to be sorted and summed, and a change of format
+	for (int i = 0; i < SPARSE_CHECK_M; ++i) {
+		for (int j = 0; j < SPARSE_CHECK_K; ++j) {
+			matrix_getEntry(hMxA, i, j, &entry);
+			nnz += 2 * (entry != 0);
+		}
+	}
+	mem = mem && (rowIdx = malloc(sizeof(*rowIdx) * nnz)) && (colIdx = malloc(sizeof(*colIdx) * nnz)) && (values = malloc(sizeof(*values) * nnz));
+	for (int i = 0, k = (int)nnz; mem && i < SPARSE_CHECK_M; ++i) {
+		for (int j = 0; j < SPARSE_CHECK_K; ++j) {
+			matrix_getEntry(hMxA, i, j, &entry);
+			for (int half = 0; entry != 0 && half < 2; ++half) {
+				rowIdx[--k] = i;
+				colIdx[k] = j;
+				values[k] = entry / 2;
+			}
+		}
+	}
+	for (int f = 0; mem && f < 2; ++f) {
+		formatA = f ? SPARSE_CSC : SPARSE_CSR;
+		formatB = f ? SPARSE_CSR : SPARSE_CSC;
+		if ((mem = (hSpA = matrixSparse_initTriplets(rowIdx, colIdx, values, nnz, SPARSE_CHECK_M, SPARSE_CHECK_K, formatA)) && matrixSparse_toDense(hSpA, &hMxDense)))
+			diffs[0] = maxAbsDiff(hMxDense, hMxA, SPARSE_CHECK_M, SPARSE_CHECK_K);
+		if (mem && (mem = matrixSparse_setFormat(hSpA, formatB) && matrixSparse_toDense(hSpA, &hMxDense)))
+			diffs[1] = maxAbsDiff(hMxDense, hMxA, SPARSE_CHECK_M, SPARSE_CHECK_K);
+		if (mem)
+			printf("%s triplets %g, then %s %g, %zu of %zu triplets stored: %s\n", formatNames[formatA], diffs[0], formatNames[formatB], diffs[1], matrixSparse_getNnz(hSpA), nnz,
+			       checkResult(diffs[0] <= CHECK_TOL && diffs[1] <= CHECK_TOL && 2 * matrixSparse_getNnz(hSpA) == nnz));
+		matrixSparse_destroy(&hSpA);
+	}
+	free(rowIdx);
+	free(colIdx);
+	free(values);
+	rowIdx = colIdx = NULL;
+	values = NULL;
+	printf("\n");
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxC);
+
+	// a matrix with the same number of random entries in each row, like the adjacency matrix of a graph
+	nnz = (size_t)SPARSE_N * SPARSE_ROW_NNZ;
+	mem = mem && (rowIdx = malloc(sizeof(*rowIdx) * nnz)) && (colIdx = malloc(sizeof(*colIdx) * nnz)) && (values = malloc(sizeof(*values) * nnz));
+	for (size_t k = 0; mem && k < nnz; ++k) {
+		rowIdx[k] = (int)(k / SPARSE_ROW_NNZ);
+		colIdx[k] = rand() % SPARSE_N;
+		values[k] = 2.0 * rand() / RAND_MAX - 1.0;
+	}
+	if (mem) {
+		printf("%d x %d sparse matrix A with %d random entries in each row\n", SPARSE_N, SPARSE_N, SPARSE_ROW_NNZ);
+		printf("%16s %10s %12s\n", "operation", "time (ms)", "entries");
+		start = now();
+		mem = (hSpA = matrixSparse_initTriplets(rowIdx, colIdx, values, nnz, SPARSE_N, SPARSE_N, SPARSE_CSR)) != NULL;
+		if (mem)
+			printf("%16s %10.2f %12zu\n", "initTriplets", (now() - start) * 1e3, matrixSparse_getNnz(hSpA));
+	}
+	free(rowIdx);
+	free(colIdx);
+	free(values);
+	if (mem && (mem = (hMxX = randomMatrix(SPARSE_N, 1)) != NULL)) {
+		start = now();
+		for (int rep = 0; mem && rep < SPARSE_REPS; ++rep)
+			mem = matrixSparse_opMultDense(hSpA, hMxX, &hMxDense);
+		if (mem)
+			printf("%16s %10.2f %12d\n", "A x", (now() - start) / SPARSE_REPS * 1e3, SPARSE_N);
+	}
+	if (mem) {
+		start = now();
+		if ((mem = matrixSparse_setFormat(hSpA, SPARSE_CSC)))
+			printf("%16s %10.2f %12zu\n", "setFormat CSC", (now() - start) * 1e3, matrixSparse_getNnz(hSpA));
+		start = now();
+		if (mem && (mem = matrixSparse_setFormat(hSpA, SPARSE_CSR)))
+			printf("%16s %10.2f %12zu\n", "setFormat CSR", (now() - start) * 1e3, matrixSparse_getNnz(hSpA));
+	}
+	if (mem) {
+		start = now();
+		if ((mem = matrixSparse_opTrans(hSpA, &hSpRes)))
+			printf("%16s %10.2f %12zu\n", "A^T", (now() - start) * 1e3, matrixSparse_getNnz(hSpRes));
+		start = now();
+		if (mem && (mem = matrixSparse_opAdd(hSpA, hSpRes, &hSpRes)))
+			printf("%16s %10.2f %12zu\n", "A + A^T", (now() - start) * 1e3, matrixSparse_getNnz(hSpRes));
+		matrixSparse_destroy(&hSpRes);
+	}
+	if (mem) {
+		start = now();
+		if ((mem = matrixSparse_opMult(hSpA, hSpA, &hSpRes)))
+			printf("%16s %10.2f %12zu\n", "A A", (now() - start) * 1e3, matrixSparse_getNnz(hSpRes));
+		matrixSparse_destroy(&hSpRes);
+	}
+	matrixSparse_destroy(&hSpA);
+	matrix_destroy(&hMxX);
+	matrix_destroy(&hMxDense);
+	printf("\n");
+
+	// the same operations on a matrix small enough to store densely
+	hMxA = randomSparseMatrix(SPARSE_DENSE_N, SPARSE_DENSE_N, SPARSE_DENSE_DENSITY);
+	hMxX = randomMatrix(SPARSE_DENSE_N, 1);
+	mem = mem && hMxA && hMxX && (hSpA = matrixSparse_initDense(hMxA, SPARSE_CSR));
+	if (mem) {
+		printf("%d x %d matrix A with %zu entries that aren't 0: sparse vs. dense (ms)\n", SPARSE_DENSE_N, SPARSE_DENSE_N, matrixSparse_getNnz(hSpA));
+		printf("%6s %10s %10s %9s %12s %8s\n", "op", "sparse", "dense", "speedup", "difference", "check");
+		start = now();
+		for (int rep = 0; mem && rep < SPARSE_REPS; ++rep)
+			mem = matrixSparse_opMultDense(hSpA, hMxX, &hMxDense);
+		sparseTime = (now() - start) / SPARSE_REPS;
+		start = now();
+		for (int rep = 0; mem && rep < SPARSE_REPS; ++rep)
+			mem = matrix_opMult(hMxA, hMxX, &hMxExpected);
+		denseTime = (now() - start) / SPARSE_REPS;
+		if (mem) {
+			diffs[0] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_DENSE_N, 1);
+			printf("%6s %10.3f %10.3f %9.1f %12g %8s\n", "A x", sparseTime * 1e3, denseTime * 1e3, denseTime / sparseTime, diffs[0], checkResult(diffs[0] <= CHECK_TOL));
+		}
+	}
+	if (mem) {
+		start = now();
+		mem = matrixSparse_opMult(hSpA, hSpA, &hSpRes) && matrixSparse_toDense(hSpRes, &hMxDense);
+		sparseTime = now() - start;
+		start = now();
+		mem = mem && matrix_opMult(hMxA, hMxA, &hMxExpected);
+		denseTime = now() - start;
+		if (mem) {
+			diffs[0] = maxAbsDiff(hMxDense, hMxExpected, SPARSE_DENSE_N, SPARSE_DENSE_N);
+			printf("%6s %10.3f %10.3f %9.1f %12g %8s\n", "A A", sparseTime * 1e3, denseTime * 1e3, denseTime / sparseTime, diffs[0], checkResult(diffs[0] <= CHECK_TOL));
+		}
+	}
+	printf("\n");
+
+	matrixSparse_destroy(&hSpA);
+	matrixSparse_destroy(&hSpRes);
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxX);
+	matrix_destroy(&hMxDense);
+	matrix_destroy(&hMxExpected);
+
+	return mem;
+}
+
+
+static Status benchStructure(void) {
+	static const char* const opNames[] = { "det upper", "inv diag", "pow diag", "perm x B", "diag x B" };
+	MATRIX hMxUpper, hMxDiag, hMxPerm, hMxB, hMxGeneral = NULL;
+	MATRIX hMxRes = NULL, hMxExpected = NULL;
+	double det, expectedDet = 0;
+	double start, structuredTime, generalTime, diff;
+	Boolean isInvertible;
+	Status mem;
+	int n = STRUCTURE_N;
+
+
+	// a well conditioned upper triangular matrix, a diagonal matrix and a random permutation
+	hMxUpper = randomMatrix(n, n);
+	hMxDiag = matrix_initDims(n, n);
+	hMxPerm = matrix_initDims(n, n);
+	hMxB = randomMatrix(n, n);
+	mem = hMxUpper && hMxDiag && hMxPerm && hMxB;
+	for (int i = 0; mem && i < n; ++i) {
+		for (int j = 0; j < i; ++j)
+			matrix_setEntry(hMxUpper, i, j, 0);
+		matrix_setEntry(hMxUpper, i, i, 1 + 0.01 * rand() / RAND_MAX);
+		matrix_setEntry(hMxDiag, i, i, 0.5 + 1.0 * rand() / RAND_MAX);
+	}
+	for (int i = 0; mem && i < n; ++i)
+		matrix_setEntry(hMxPerm, i, (int)((long long)i * 7919 % n), 1);    // 7919 is prime, so i -> 7919 i mod n is a permutation for n a power of 2
+
+	printf("Structured %d x %d operations: general vs. shortcut for the shape (ms)\n", n, n);
+	printf("%10s %10s %10s %9s %12s %8s\n", "op", "general", "shortcut", "speedup", "difference", "check");
+	for (int op = 0; mem && op < (int)(sizeof(opNames) / sizeof(*opNames)); ++op) {
+		MATRIX hMx = (op == 0) ? hMxUpper : (op == 3) ? hMxPerm : hMxDiag;
+
+		// the general matrix is the same one with an entry below the diagonal, which rules out every shape
+		mem = matrix_copy(&hMxGeneral, hMx) && matrix_setEntry(hMxGeneral, n - 1, 0, 1e-300);
+		for (int pass = 0; mem && pass < 2; ++pass) {
+			MATRIX hMxOp = pass ? hMx : hMxGeneral;
+			MATRIX* phMxOut = pass ? &hMxRes : &hMxExpected;
+			start = now();
+			switch (op) {
+			case 0: det = matrix_opDet(hMxOp, &mem); break;
+			case 1: mem = matrix_opInv(hMxOp, &isInvertible, phMxOut); break;
+			case 2: mem = matrix_opPow(hMxOp, STRUCTURE_POWER, phMxOut); break;
+			default: mem = matrix_opMult(hMxOp, hMxB, phMxOut); break;
+			}
+			if (pass)
+				structuredTime = now() - start;
+			else {
+				generalTime = now() - start;
+				expectedDet = det;
+			}
+		}
+		if (mem) {
+			diff = op ? maxAbsDiff(hMxRes, hMxExpected, n, n) : fabs(det - expectedDet) / fabs(expectedDet);
+			printf("%10s %10.2f %10.3f %9.1f %12g %8s\n", opNames[op], generalTime * 1e3, structuredTime * 1e3, generalTime / structuredTime, diff, checkResult(diff <= CHECK_TOL));
+		}
+	}
+	printf("\n");
+
+	// the inverse of a diagonal matrix must fail exactly when factoring it does, however small its entries
+	if (mem) {
+		printf("Diagonal inverse checks: shortcut vs. factorization\n");
+		printf("%14s %12s %12s %8s\n", "middle entry", "shortcut", "factors", "result");
+		matrix_destroy(&hMxDiag);
+		if (!(hMxDiag = matrix_initDims(3, 3)))
+			mem = FAILURE;
+	}
+	for (int c = 0; mem && c < (int)(sizeof(diagonalChecks) / sizeof(*diagonalChecks)); ++c) {
+		MATRIX_FACTOR hFac;
+		Boolean factorIsInvertible;
+		Status invStatus, factorInvStatus;
+		for (int i = 0; i < 3; ++i)
+			matrix_setEntry(hMxDiag, i, i, (i == 1) ? diagonalChecks[c] : 1);
+		if (!(hFac = matrix_factorize(hMxDiag))) {
+			mem = FAILURE;
+			break;
+		}
+		invStatus = matrix_opInv(hMxDiag, &isInvertible, &hMxRes);
+		factorInvStatus = matrix_factorInv(hFac, &factorIsInvertible, &hMxExpected);
+		matrix_factorDestroy(&hFac);
+		printf("%14g %12s %12s %8s\n", diagonalChecks[c], isInvertible ? "singular" : "invertible", factorIsInvertible ? "singular" : "invertible",
+		       checkResult(invStatus == factorInvStatus && isInvertible == factorIsInvertible));
+	}
+	printf("\n");
+
+	matrix_destroy(&hMxUpper);
+	matrix_destroy(&hMxDiag);
+	matrix_destroy(&hMxPerm);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxGeneral);
+	matrix_destroy(&hMxRes);
+	matrix_destroy(&hMxExpected);
+
+	return mem;
+}
+
+
+static Status benchSymmetric(void) {
+	MATRIX_SYMMETRIC hSym = NULL;
+	MATRIX hMxA, hMxB, hMxT = NULL, hMxDense = NULL, hMxGram = NULL, hMxX = NULL, hMxExpected = NULL;
+	double start, symTime, denseTime, diff;
+	Boolean isPosDef, isInvertible;
+	Status mem;
+	int m = SYMMETRIC_M, n = SYMMETRIC_N;
+
+
+	hMxA = randomMatrix(m, n);
+	hMxB = randomMatrix(n, 1);
+	mem = hMxA && hMxB;
+	if (mem) {
+		printf("Gram matrix A^T A of a %d x %d matrix A and solving A^T A x = b: symmetric vs. dense (ms)\n", m, n);
+		printf("%10s %10s %10s %9s %12s %8s\n", "op", "symmetric", "dense", "speedup", "difference", "check");
+	}
+
+	// the Gram matrix directly into packed storage against the transpose times A
+	if (mem) {
+		start = now();
+		mem = matrix_opGram(hMxA, &hSym);
+		symTime = now() - start;
+		start = now();
+		mem = mem && matrix_opTrans(hMxA, &hMxT) && matrix_opMult(hMxT, hMxA, &hMxDense);
+		denseTime = now() - start;
+		if (mem && (mem = matrix_symmetricToDense(hSym, &hMxGram))) {
+			diff = maxAbsDiff(hMxGram, hMxDense, n, n);
+			printf("%10s %10.2f %10.2f %9.1f %12g %8s\n", "A^T A", symTime * 1e3, denseTime * 1e3, denseTime / symTime, diff, checkResult(diff <= CHECK_TOL));
+		}
+	}
+
+	// Cholesky against LU on the same positive definite matrix
+	if (mem) {
+		start = now();
+		mem = matrix_symmetricSolve(hSym, hMxB, &isPosDef, &hMxX);
+		symTime = now() - start;
+		start = now();
+		mem = mem && matrix_opSolve(hMxDense, hMxB, &isInvertible, &hMxExpected);
+		denseTime = now() - start;
+		if (mem) {
+			diff = maxAbsDiff(hMxX, hMxExpected, n, 1);
+			printf("%10s %10.2f %10.2f %9.1f %12g %8s\n", "solve", symTime * 1e3, denseTime * 1e3, denseTime / symTime, diff,
+			       checkResult(isPosDef && !isInvertible && diff <= CHECK_TOL));
+		}
+	}
+	if (mem)
+		printf("%10s %9.1fM %9.1fM\n", "memory", n * (n + 1) / 2 * sizeof(double) / 1e6, (double)n * n * sizeof(double) / 1e6);
+	printf("\n");
+
+	matrix_symmetricDestroy(&hSym);
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxT);
+	matrix_destroy(&hMxDense);
+	matrix_destroy(&hMxGram);
+	matrix_destroy(&hMxX);
+	matrix_destroy(&hMxExpected);
+
+	return mem;
+}
+
+
+static Status benchThreads(void) {
+	MATRIX hMx1, hMx2, hMxRes = NULL;
+	double start, flops, time, oneThreadTime = 0;
+	int maxThreads = matrix_getNumThreads();
+	Status mem = SUCCESS;
+
+	printf("Multiplication thread scaling: GFLOP/s (speedup over 1 thread), up to %d threads\n", maxThreads);
+	printf("%6s %8s %10s %9s\n", "n", "threads", "GFLOP/s", "speedup");
+	for (int n = THREADS_MIN_N; mem && n <= THREADS_MAX_N; n *= 2) {
+		flops = 2.0 * n * n * n;
+		hMx1 = randomMatrix(n, n);
+		hMx2 = randomMatrix(n, n);
+		if (!hMx1 || !hMx2)
+			mem = FAILURE;
+
+		// double the threads each time and finish with the default number if it isn't a power of 2
+		for (int threads = 1; mem; threads *= 2) {
+			if (threads > maxThreads)
+				threads = maxThreads;
+			matrix_setNumThreads(threads);
+			start = now();
+			mem = matrix_opMult(hMx1, hMx2, &hMxRes);
+			time = now() - start;
+			if (threads == 1)
+				oneThreadTime = time;
+			printf("%6d %8d %10.2f %9.2f\n", n, threads, flops / time * 1e-9, oneThreadTime / time);
+			if (threads == maxThreads)
+				break;
+		}
+
+		matrix_destroy(&hMx1);
+		matrix_destroy(&hMx2);
+	}
+	matrix_setNumThreads(maxThreads);
+	matrix_destroy(&hMxRes);
+	printf("\n");
+
+	return mem;
+}
+
+
+static Status benchView(void) {
+	MATRIX hMxs[2] = { NULL };    // operands of the addition
+	MATRIX hMxA, hMxB, hMxTrans = NULL, hMxView, hMxBlocks[2];
+	MATRIX hMxCopyRes = NULL, hMxViewRes = NULL;
+	double start, copyTime, viewTime;
+	double entry, diff;
+	Status mem = SUCCESS;
+
+	printf("Transposes and blocks: copy with matrix_opTrans or matrix_getEntry vs. view with matrix_viewTrans or matrix_view (ms)\n");
+	printf("%6s %10s %10s %10s %12s %8s\n", "n", "operation", "copy", "view", "difference", "check");
+	for (int n = VIEW_MIN_N; mem && n <= VIEW_MAX_N; n *= 2) {
+		hMxA = randomMatrix(n, n);
+		hMxB = randomMatrix(n, n);
+		if (!hMxA || !hMxB)
+			mem = FAILURE;
+
+		// A^T B
+		if (mem) {
+			start = now();
+			mem = matrix_opTrans(hMxA, &hMxTrans) && matrix_opMult(hMxTrans, hMxB, &hMxCopyRes);
+			copyTime = now() - start;
+		}
+		if (mem) {
+			start = now();
+			mem = (hMxView = matrix_viewTrans(hMxA)) && matrix_opMult(hMxView, hMxB, &hMxViewRes);
+			viewTime = now() - start;
+			matrix_destroy(&hMxView);
+		}
+		if (mem) {
+			diff = maxAbsDiff(hMxCopyRes, hMxViewRes, n, n);
+			printf("%6d %10s %10.2f %10.2f %12g %8s\n", n, "A^T B", copyTime * 1e3, viewTime * 1e3, diff, checkResult(diff <= CHECK_TOL));
+		}
+
+		// A^T + B
+		if (mem) {
+			start = now();
+			mem = matrix_opTrans(hMxA, &hMxTrans);
+			hMxs[0] = hMxTrans;
+			hMxs[1] = hMxB;
+			mem = mem && matrix_opAdd(hMxs, 2, &hMxCopyRes);
+			copyTime = now() - start;
+		}
+		if (mem) {
+			start = now();
+			mem = (hMxView = matrix_viewTrans(hMxA)) != NULL;
+			hMxs[0] = hMxView;
+			mem = mem && matrix_opAdd(hMxs, 2, &hMxViewRes);
+			viewTime = now() - start;
+			matrix_destroy(&hMxView);
+		}
+		if (mem) {
+			diff = maxAbsDiff(hMxCopyRes, hMxViewRes, n, n);
+			printf("%6d %10s %10.2f %10.2f %12g %8s\n", n, "A^T + B", copyTime * 1e3, viewTime * 1e3, diff, checkResult(diff <= CHECK_TOL));
+		}
+
+		// A11 + B11, copying the blocks an entry at a time like a caller without views has to
+		if (mem) {
+			start = now();
+			hMxBlocks[0] = matrix_initDims(n / 2, n / 2);
+			hMxBlocks[1] = matrix_initDims(n / 2, n / 2);
+			mem = hMxBlocks[0] && hMxBlocks[1];
+			for (int i = 0; mem && i < n / 2; ++i) {
+				for (int j = 0; j < n / 2; ++j) {
+					matrix_getEntry(hMxA, i, j, &entry);
+					matrix_setEntry(hMxBlocks[0], i, j, entry);
+					matrix_getEntry(hMxB, i, j, &entry);
+					matrix_setEntry(hMxBlocks[1], i, j, entry);
+				}
+			}
+			mem = mem && matrix_opAdd(hMxBlocks, 2, &hMxCopyRes);
+			copyTime = now() - start;
+			matrix_destroy(&hMxBlocks[0]);
+			matrix_destroy(&hMxBlocks[1]);
+		}
+		if (mem) {
+			start = now();
+			hMxBlocks[0] = matrix_view(hMxA, 0, n / 2, 0, n / 2);
+			hMxBlocks[1] = matrix_view(hMxB, 0, n / 2, 0, n / 2);
+			mem = hMxBlocks[0] && hMxBlocks[1] && matrix_opAdd(hMxBlocks, 2, &hMxViewRes);
+			viewTime = now() - start;
+			matrix_destroy(&hMxBlocks[0]);
+			matrix_destroy(&hMxBlocks[1]);
+		}
+		if (mem) {
+			diff = maxAbsDiff(hMxCopyRes, hMxViewRes, n / 2, n / 2);
+			printf("%6d %10s %10.2f %10.2f %12g %8s\n", n, "A11 + B11", copyTime * 1e3, viewTime * 1e3, diff, checkResult(diff <= CHECK_TOL));
+		}
+
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+		matrix_destroy(&hMxTrans);
+	}
+	matrix_destroy(&hMxCopyRes);
+	matrix_destroy(&hMxViewRes);
+	printf("\n");
+
+	return mem;
+}
+
+
+static const char* checkResult(Boolean passed) {
+	numFailedChecks += !passed;
+	return passed ? "ok" : "FAILED";
+}
+
+
+static double cofactorDet(const double* entries, int n, Status* pMem) {
+	double* sub;
+	double sum = 0;
+
+	if (n == 1)
+		return entries[0];
+	if (n == 2)
+		return entries[0] * entries[3] - entries[1] * entries[2];
+
+	for (int col = 0; col < n; ++col) {
+		if (!(sub = malloc(sizeof(*sub) * (n - 1) * (n - 1)))) {
+			*pMem = FAILURE;
+			return 0;
+		}
+		for (int row = 1, subIdx = 0; row < n; ++row) {
+			for (int _col = 0; _col < n; ++_col) {
+				if (_col != col)
+					sub[subIdx++] = entries[row * n + _col];
+			}
+		}
+		if (col % 2 == 0)
+			sum += entries[col] * cofactorDet(sub, n - 1, pMem);
+		else
+			sum -= entries[col] * cofactorDet(sub, n - 1, pMem);
+		free(sub);
+	}
+
+	return sum;
+}
+
+
+static void* countingAlloc(size_t size, size_t alignment, void* userdata) {
+	void* ptr;
+	(void)userdata;
+
+	++numAllocs;
+	if ((ptr = aligned_alloc(alignment, size))) {
+		++numLiveAllocs;
+		numMisalignedAllocs += (uintptr_t)ptr % alignment != 0;
+	}
+
+	return ptr;
+}
+
+
+static void countingFree(void* ptr, void* userdata) {
+	(void)userdata;
+	numLiveAllocs -= ptr != NULL;
+	free(ptr);
+}
+
+
+static void fillRandom(double* entries, int size) {
+	for (int i = 0; i < size; ++i)
+		entries[i] = 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+
+static double maxAbsDiff(MATRIX hMx1, MATRIX hMx2, int rows, int cols) {
+	double entry1, entry2;
+	double diff = 0;
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			matrix_getEntry(hMx1, i, j, &entry1);
+			matrix_getEntry(hMx2, i, j, &entry2);
+			diff = fmax(diff, fabs(entry1 - entry2));
+		}
+	}
+
+	return diff;
+}
+
+
+static void naiveAdd(double** terms, int numTerms, double* res, int size) {
+	for (int i = 0; i < size; ++i) {
+		double sum = 0;
+		for (int t = 0; t < numTerms; ++t)
+			sum += terms[t][i];
+		res[i] = sum;
+	}
+}
+
+
+static void naiveMult(const double* a, const double* b, double* c, int n) {
+	for (int i = 0; i < n; ++i) {
+		for (int j = 0; j < n; ++j) {
+			double sum = 0;
+			for (int p = 0; p < n; ++p)
+				sum += a[i * n + p] * b[p * n + j];
+			c[i * n + j] = sum;
+		}
+	}
+}
+
+
+static double now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static MATRIX randomMatrix(int rows, int cols) {
+	MATRIX hMx;
+	double* entries;
+
+	if (!(hMx = matrix_initDims(rows, cols)))
+		return NULL;
+	if (!(entries = malloc(sizeof(*entries) * rows * cols))) {
+		matrix_destroy(&hMx);
+		return NULL;
+	}
+	fillRandom(entries, rows * cols);
+	if (!matrix_newMatrix(hMx, entries, rows, cols))
+		matrix_destroy(&hMx);
+	free(entries);
+
+	return hMx;
+}
+
+
+static MATRIX randomSparseMatrix(int rows, int cols, double density) {
+	MATRIX hMx;
+
+	if (!(hMx = matrix_initDims(rows, cols)))
+		return NULL;
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j)
+			matrix_setEntry(hMx, i, j, (rand() < density * RAND_MAX) ? 2.0 * rand() / RAND_MAX - 1.0 : 0);
+	}
+
+	return hMx;
+}
+
+
+static Status runAllocOp(AllocOp op, MATRIX hMxA, MATRIX hMxB, MATRIX* phMxRes) {
+	MATRIX hMxs[2] = { hMxA, hMxB };
+	MATRIX hMx;
+	Boolean isInvertible;
+	Status mem = SUCCESS;
+
+	switch (op) {
+	case ALLOC_OP_INIT:
+		mem = (hMx = matrix_initCopy(hMxA)) != NULL;
+		matrix_destroy(&hMx);
+		return mem;
+	case ALLOC_OP_MULT:
+		return matrix_opMult(hMxA, hMxB, phMxRes);
+	case ALLOC_OP_ADD:
+		return matrix_opAdd(hMxs, 2, phMxRes);
+	case ALLOC_OP_TRANS:
+		return matrix_opTrans(hMxA, phMxRes);
+	case ALLOC_OP_POW:
+		return matrix_opPow(hMxA, 5, phMxRes);
+	case ALLOC_OP_DET:
+		matrix_opDet(hMxA, &mem);
+		return mem;
+	case ALLOC_OP_INV:
+		return matrix_opInv(hMxA, &isInvertible, phMxRes);
+	case ALLOC_OP_SOLVE:
+		return matrix_opSolve(hMxA, hMxB, &isInvertible, phMxRes);
+	default:
+		return FAILURE;
+	}
+}
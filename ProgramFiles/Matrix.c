@@ -6,20 +6,152 @@
 */
 
 
+#define _DEFAULT_SOURCE    // mmap with MAP_ANONYMOUS and madvise
+
 #include <math.h>
 #include <ctype.h>
+#include <float.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "Matrix.h"
+#include "MatrixInternal.h"
+#include "ThreadPool.h"
+
+// large arrays of entries are mapped directly and backed by transparent huge pages where the kernel supports them
+#ifdef __linux__
+#define ENTRIES_MMAP
+#include <sys/mman.h>
+#endif
+
+// x86 kernels are compiled for their instruction set with target attributes and selected at run time, so the Makefile needs no -m flags
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define SOLVE_PANEL_BYTES (256 * 1024)    // target size of the panel of right-hand side columns solved at once so it stays in L2
+
+// allocation of the arrays of entries
+#define ENTRIES_ALIGN 64                                   // alignment in bytes of every array, a cache line and an AVX-512 register
+#define ENTRIES_HUGE_PAGE (2 * 1024 * 1024)                // size in bytes of a transparent huge page
+#define ENTRIES_HUGE_PAGE_MIN_BYTES (4 * 1024 * 1024)      // smallest array that is mapped with mmap and backed by huge pages
+#define SCRATCH_MIN_BYTES (64 * 1024)                      // smallest block of a scratch arena
+#define SCRATCH_MAX_BYTES (16 * 1024 * 1024)               // largest block of a scratch arena, the temporaries of bigger operations are freed when they return
+
+// pooling of small matrices
+#define POOL_CLASSES 6          // size classes of matrix headers, see poolClassSizes
+#define POOL_MAX_FREE 256       // most headers of each size class kept on the free list of a thread
+
+// splitting of the addition and subtraction into chunks and across threads
+#define ELEMWISE_CHUNK 2048                     // entries of the result summed over every term at once, 16 KB so the partial sum stays in L1
+#define ELEMWISE_PARALLEL_MIN_SIZE (1 << 16)    // smallest result worth waking the workers for
+#define ELEMWISE_TASKS_PER_THREAD 4             // ranges of the result per thread so uneven threads balance out
+#define ELEMWISE_TILE (8 * 1024)                // entries of the tiles used instead of chunks when an operand is a view whose entries aren't contiguous, 64 KB so each stays in L2
+#define ELEMWISE_TILE_COLS 128                  // widest tile, which keeps the tile tall enough that a transposed view is read in long runs too
+
+// blocking of the matrix multiplication kernel
+#define GEMM_MR 4       // rows of the register tile computed by the micro-kernel
+#define GEMM_NR 8       // columns of the register tile computed by the micro-kernel
+#define GEMM_KC 256     // depth of the packed panels, sized so a GEMM_KC x GEMM_NR sliver of B stays in L1
+#define GEMM_MC 96      // rows of the packed block of A, sized to stay in L2 (multiple of GEMM_MR)
+#define GEMM_NC 2048    // columns of the packed panel of B, sized to stay in L3 (multiple of GEMM_NR)
+
+// splitting of the matrix multiplication across threads
+#define GEMM_PARALLEL_MIN_WORK (128.0 * 128 * 128)    // smallest m * n * k worth waking the workers for
+#define GEMM_TILES_PER_THREAD 2                       // tiles of the product per thread so uneven threads balance out
+#define GEMM_SCRATCH_BYTES (sizeof(double) * (GEMM_MC * GEMM_KC + GEMM_KC * GEMM_NC))    // packing buffers of the largest product, the most a worker's scratch block is warmed to
+
+#define TRANS_BLOCK 4   // rows and columns of the tile transposed by transBlock
+#define TRANS_LEAF 32   // largest rows and columns transRecursive transposes without splitting, so the source and destination blocks stay in L1
+
+// shapes of a square matrix found by findStructure, ORed together, so the identity is diagonal and a permutation
+#define STRUCTURE_LOWER 1                                        // every entry above the diagonal is 0
+#define STRUCTURE_UPPER 2                                        // every entry below the diagonal is 0
+#define STRUCTURE_DIAGONAL (STRUCTURE_LOWER | STRUCTURE_UPPER)   // every entry off the diagonal is 0
+#define STRUCTURE_PERMUTATION 4                                  // every row and column has a single entry that is 1 and the rest are 0
 
 typedef struct matrix {
 	double* entries;    // 1D array implementation fo 2D matrix
 	int rows;           // total rows
 	int cols;           // total columns
+	ptrdiff_t rowStride;    // distance in the array from an entry to the one below it, cols unless the matrix is a view
+	ptrdiff_t colStride;    // distance in the array from an entry to the one to its right, 1 unless the matrix is a view
+	struct matrix* owner;    // matrix that owns the entries of a view, NULL if the matrix owns its entries
+	size_t capacity;    // entries the array can hold, which can be more than rows * cols after the matrix shrinks or if they're inline, 0 for a view
 	int maxLength;      // max width of a number out of the entire array i.e -425.73 has a width of 7 (5 numbers, '.', and '-')
+	Boolean maxLengthIsDirty;    // the entries changed since maxLength was calculated, it's recalculated when the matrix is printed
+	int structure;      // STRUCTURE_ flags of the shapes the entries have, 0 for a general or rectangular matrix
+	Boolean structureIsDirty;    // the entries changed since structure was found, it's found again by the next operation that uses it
+	int sizeClass;      // index in poolClassSizes of the entries the header has room for after it
+	_Alignas(ENTRIES_ALIGN) double inlineEntries[];    // entries of a small matrix, stored in the same allocation as the header and padded to start on an ENTRIES_ALIGN boundary like any other array
 } Matrix;
 
+typedef struct matrixFactor {
+	double* lu;         // LU factorization with the multipliers of L below the diagonal and U on and above it, followed by scratch space
+	int* piv;           // row swapped with each row during the factorization
+	int n;              // rows and columns of the factored matrix
+	int sign;           // sign of the row permutation, 0 if the matrix is singular
+} MatrixFactor;
+
+typedef struct elemwiseJob {
+	MATRIX* hMxs;                 // terms of the sum or difference
+	int hMxsSize;
+	void (*op)(int n, const double* x, const double* y, double* z);    // vecAdd or vecSub kernel
+	Matrix* pMxRes;               // result
+	ptrdiff_t size;               // size of the result
+	ptrdiff_t taskSize;           // entries of the result computed by each task, a multiple of ELEMWISE_CHUNK, or rows if it's computed in tiles, a multiple of tileRows
+	int tileRows, tileCols;       // size of the tiles if an operand isn't contiguous, 0 otherwise
+} ElemwiseJob;
+
+typedef struct gemmJob {
+	int m, n, k;                  // arguments of gemm for the whole product
+	const double* a;
+	ptrdiff_t rsa, csa;
+	const double* b;
+	ptrdiff_t rsb, csb;
+	double* c;
+	ptrdiff_t rsc, csc;
+	int tileRows, tileCols;       // size of the tile of C computed by each task, multiples of GEMM_MR and GEMM_NR
+	int gridCols;                 // tiles across a row of C
+} GemmJob;
+
+typedef struct allocator {
+	MatrixAllocFn allocFn;        // hooks set with matrix_setAllocator, allocFn and freeFn are NULL for the default allocator
+	MatrixReallocFn reallocFn;
+	MatrixFreeFn freeFn;
+	void* userdata;
+} Allocator;
+
+typedef struct scratchChunk {
+	struct scratchChunk* next;    // chunk allocated before it
+	size_t mark;                  // top of the arena when it was allocated, it's freed when the arena is released to or below it
+	size_t count;                 // entries it was allocated with, including the header padded to ENTRIES_ALIGN
+} ScratchChunk;
+
+typedef struct scratch {
+	double* block;                // memory handed out from the bottom up, NULL until the arena is first released empty
+	size_t size;                  // bytes in block
+	size_t top;                   // bytes handed out, more than size once requests spill into chunks
+	size_t peak;                  // most bytes handed out at once, the next block holds at least this many up to SCRATCH_MAX_BYTES
+	ScratchChunk* chunks;         // requests that didn't fit in block, newest first
+	Matrix* freeMatrices[POOL_CLASSES];    // destroyed matrix headers of each size class, linked through owner
+	int numFreeMatrices[POOL_CLASSES];
+	struct scratch* prev;         // arenas of the other threads, so matrix_setAllocator can free them
+	struct scratch* next;
+} Scratch;    // memory each thread keeps between operations
+
+typedef struct simdKernels {
+	SimdLevel level;
+	void (*gemmMicroKernel)(int kc, const double* restrict a, const double* restrict b, double* restrict ab);
+	void (*transBlock)(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd);
+	void (*vecAdd)(int n, const double* x, const double* y, double* z);
+	void (*vecSub)(int n, const double* x, const double* y, double* z);
+} SimdKernels;
+
 
 
 
@@ -38,18 +170,22 @@ PRECONDITION
   - cols
       Purpose:       New columns.
       Restrictions:  Any positive integer.
+  - zero
+      Purpose:       Whether the entries are set to 0.
+      Restrictions:  FALSE only if the caller overwrites every entry, which saves a pass over the memory.
 POSTCONDITION
 Success
   - Reason:        No memory allocation failure.
   - Summary:       Adjusts the dimensions of a matrix with a given amount of rows and columns.
                    If the matrix doesn't exist it is created first.
 		   If the matrix exists, its dimensions are adjusted.
-                   The values of all the entries are set to 0.
+                   A view keeps its entries in its owner, so its dimensions must already be the same.
+                   If zero is TRUE the values of all the entries are set to 0, otherwise they are left uninitialized.
   - Return value:  SUCCESS
   - ppMx:          If it is a pointer to a pointer to a valid matrix object, the matrix's dimensions are adjusted.
                    If is is pointer to a NULL pointer, a new matrix is created with those dimensions and the pointer it points to stores the address of the new matrix.
 Failure
-  - Reason:        Memory allocation failure.
+  - Reason:        Memory allocation failure, or the matrix is a view and its dimensions are different.
   - Summary:       Doesn't adjust the dimensions of a matrix and nothing of signifiance happens.
                    If the matrix doesn't exist it is created first.
 		   If the matrix exists, its dimensions are adjusted.
@@ -58,7 +194,59 @@ Failure
   - ppMx:          If it was a pointer to a pointer to a valid matrix object, the state of the matrix before the function call is preserved.
                    If is was pointer to a NULL pointer, the pointer remains NULL.
 */
-static Status adjustMatrixDims(Matrix** ppMx, int rows, int cols);
+static Status adjustMatrixDims(Matrix** ppMx, int rows, int cols, Boolean zero);
+
+
+/*
+FUNCTION
+  - Name:     allocEntries
+  - Purpose:  Allocate an array of entries aligned to ENTRIES_ALIGN bytes so SIMD loads and stores never straddle cache lines.
+              Arrays of at least ENTRIES_HUGE_PAGE_MIN_BYTES are mapped with mmap starting on a huge page boundary and marked with MADV_HUGEPAGE,
+              so a matrix of several GB takes one TLB entry per 2 MB instead of per 4 KB.
+              If hooks are set with matrix_setAllocator the array comes from them instead.
+              Every array must be freed with freeEntries and the same count.
+PRECONDITION
+  - count
+      Purpose:       Entries in the array.
+      Restrictions:  Any positive integer.
+  - zero
+      Purpose:       Whether the entries are set to 0.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the array.
+  - Return value:  The array.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static double* allocEntries(size_t count, Boolean zero);
+
+
+/*
+FUNCTION
+  - Name:     allocMatrix
+  - Purpose:  Allocate a matrix header with room after it for the entries of a small matrix, so the matrix takes one allocation instead of two.
+              The header comes from the smallest size class that holds the entries, or the class without inline entries if none does,
+              and is taken from the free list of the calling thread when one was destroyed before.
+              It is allocated with allocEntries, so the inline entries start on an ENTRIES_ALIGN boundary like any other array.
+PRECONDITION
+  - size
+      Purpose:       Entries to store inline, 0 for a view or a large matrix.
+      Restrictions:  Any integer >= 0.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the header and sets its size class. The other fields are unset.
+  - Return value:  Pointer to the header.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static Matrix* allocMatrix(size_t size);
 
 
 /*
@@ -89,7 +277,7 @@ Failure
   - Summary:       Returns a special value to indicate out of bounds.
   - Return value:  -1
 */
-static int at(Matrix* pMx, int row, int col);
+static ptrdiff_t at(Matrix* pMx, int row, int col);
 
 
 /*
@@ -124,7 +312,7 @@ Failure
   - Summary:       Returns a special value to indicate out of bounds.
   - Return value:  -1
 */
-int at2(int rows, int cols, int row, int col);
+ptrdiff_t at2(int rows, int cols, int row, int col);
 
 
 /*
@@ -150,904 +338,3557 @@ static int calcEntryLength(double entry);
 
 /*
 FUNCTION
-  - Name:     getSize
-  - Purpose:  Calculate the size of the 1D array of entries using the number of rows and columns in the 2D matrix.
+  - Name:     copyEntries
+  - Purpose:  Copy an array of entries into another where either may be laid out with any strides, e.g. a view, a transposed view or a matrix that owns its entries.
+              Rows that are contiguous in both are copied with memcpy and a block that is transposed between them is copied with transRecursive so neither side is read a column at a time.
 PRECONDITION
-  - rows
-      Purpose:       Rows of the matrix.
-      Restrictions:  Any positive integer.
-  - cols
-      Purpose:       Columns of the matrix
-      Restrictions:  Any positive integer.
+  - rows, cols
+      Purpose:       Dimensions of the entries.
+      Restrictions:  Any positive integers.
+  - src, rss, css
+      Purpose:       Entries to copy, where entry (i, j) is src[i * rss + j * css].
+      Restrictions:  Not NULL.
+  - dst, rsd, csd
+      Purpose:       Store the entries, where entry (i, j) is dst[i * rsd + j * csd].
+      Restrictions:  Not NULL and doesn't overlap src.
 POSTCONDITION
 Success
   - Reason:        All cases.
-  - Summary:       Calculates and returns the size of the 1D array of entries using the number of rows and columns in the 2D matrix.
-  - Return value:  Returns the number as described above.
+  - Summary:       Copies the entries.
+  - Return value:  N/A
 Failure
   - N/A
 */
-static int getSize(int rows, int cols);
+static void copyEntries(int rows, int cols, const double* src, ptrdiff_t rss, ptrdiff_t css, double* dst, ptrdiff_t rsd, ptrdiff_t csd);
 
 
 /*
 FUNCTION
-  - Name:     opAdjugate
-  - Purpose:  Perform the matrix adjugate operation.
-              The adjugate of a matrix is the matrix that is the transpose of the matrix of its cofactors.
-	      Used in the matrix inverse operation.
+  - Name:     copyMaxLength
+  - Purpose:  Carry the max length of a matrix over to a matrix with the same entries.
 PRECONDITION
-  - pMx
-      Purpose:       Matrix to calculate the adjugate of.
+  - pMxDest
+      Purpose:       Matrix with the same entries as pMxSrc.
       Restrictions:  Pointer to a valid matrix object.
-                     The rows equal the columns.
-  - ppMxRes
-      Purpose:       Store the result matrix that is the adjugate.
-      Restrictions:  Pointer to a pointer to a valid matrix object or pointer to a NULL pointer.
+  - pMxSrc
+      Purpose:       Matrix to take the max length from.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Copies the max length if neither matrix is a view, otherwise marks the max length of pMxDest out of date.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void copyMaxLength(Matrix* pMxDest, const Matrix* pMxSrc);
+
+
+/*
+FUNCTION
+  - Name:     copyStructure
+  - Purpose:  Carry the structure of a matrix over to a matrix with the same entries.
+PRECONDITION
+  - pMxDest
+      Purpose:       Matrix with the same entries as pMxSrc.
+      Restrictions:  Pointer to a valid matrix object.
+  - pMxSrc
+      Purpose:       Matrix to take the structure from.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Copies the structure if neither matrix is a view, otherwise marks the structure of pMxDest out of date.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void copyStructure(Matrix* pMxDest, const Matrix* pMxSrc);
+
+
+/*
+FUNCTION
+  - Name:     cpuSimdLevel
+  - Purpose:  Detect the best instruction set that both the CPU and this build of the kernels support.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Queries the CPU with cpuid on x86. Other architectures only have the scalar kernels.
+  - Return value:  The best supported SimdLevel.
+Failure
+  - N/A
+*/
+static SimdLevel cpuSimdLevel(void);
+
+
+/*
+FUNCTION
+  - Name:     elemwise
+  - Purpose:  Combine any number of arrays of entries elementwise from left to right, i.e. x0 op x1 op x2 ..., for the addition and subtraction operations.
+              The result is computed a chunk of ELEMWISE_CHUNK entries at a time so the partial result stays in cache while each term streams through it once,
+              and large results are split into ranges of chunks that the thread pool computes at the same time.
+              If any operand is a view whose entries aren't contiguous, the chunks are 2D tiles of about ELEMWISE_TILE entries instead, and each term's tile is copied first with copyEntries
+              into a buffer from the scratch arena of the thread computing it.
+              A transposed view is then read a block at a time instead of one entry per page.
+              The order of the operations for each entry is the same as combining one entry at a time.
+PRECONDITION
+  - hMxs
+      Purpose:       Terms to combine.
+      Restrictions:  Array of handles to valid matrix objects with the dimensions of the result.
+  - hMxsSize
+      Purpose:       Number of terms.
+      Restrictions:  Any positive integer.
+  - op
+      Purpose:       Kernel that combines two arrays elementwise.
+      Restrictions:  The vecAdd or vecSub kernel of an instruction set.
+  - pMxRes
+      Purpose:       Store the result.
+      Restrictions:  Pointer to a valid matrix object whose entries don't overlap the terms.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the result.
+  - Return value:  SUCCESS
+  - pMxRes:        Stores the result.
+Failure
+  - Reason:        Memory allocation failure of the tile buffers.
+  - Summary:       The result is incomplete.
+  - Return value:  FAILURE
+*/
+static Status elemwise(MATRIX* hMxs, int hMxsSize, void (*op)(int n, const double* x, const double* y, double* z), Matrix* pMxRes);
+
+
+/*
+FUNCTION
+  - Name:     elemwiseTask
+  - Purpose:  Thread pool task that computes one range of the result of elemwise.
+PRECONDITION
+  - arg
+      Purpose:       The result being computed.
+      Restrictions:  Pointer to an ElemwiseJob.
+  - taskIdx
+      Purpose:       Index of the range.
+      Restrictions:  Any integer >= 0 less than the number of ranges.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the range.
+  - Return value:  SUCCESS
+Failure
+  - N/A
+*/
+static Status elemwiseTask(void* arg, int taskIdx);
+
+
+/*
+FUNCTION
+  - Name:     elemwiseTileTask
+  - Purpose:  Thread pool task that computes one band of rows of the result of elemwise a tile at a time, for operands that aren't all contiguous.
+              The tile buffers come from the scratch arena of the calling thread instead of its stack, which is small for some threads.
+PRECONDITION
+  - arg
+      Purpose:       The result being computed.
+      Restrictions:  Pointer to an ElemwiseJob with tiles.
+  - taskIdx
+      Purpose:       Index of the band.
+      Restrictions:  Any integer >= 0 less than the number of bands.
 POSTCONDITION
 Success
   - Reason:        No memory allocation failure.
-  - Summary:       Performs the matrix adjugate operation and stores the result that is the adjugate in the result matrix.
-  - Return value:  SUCCESS.
-  - pMx:           The state of the matrix before the function call is preserved.
-  - ppMx:          The pointer it points to stores the result matrix that is the adjugate.
-                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
-                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+  - Summary:       Calculates the band.
+  - Return value:  SUCCESS
 Failure
   - Reason:        Memory allocation failure.
-  - Summary:       The adjugate operation is not performed and nothing of significance happens.
-  - Return value:  FAILURE.
-  - pMx:           The state of the matrix before the function call is preserved.
-  - ppMxRes:       If it was a pointer to a handle to a valid matrix object before the function call, the state of the matrix before the function call is not guaranteed to be preserved.
-                   If it was a pointer to a NULL handle before the function call, the handle is not guaranteed to still be NULL.
+  - Summary:       The band isn't calculated.
+  - Return value:  FAILURE
 */
-static Status opAdjugate(Matrix* pMx, Matrix** ppMxRes);
+static Status elemwiseTileTask(void* arg, int taskIdx);
 
 
 /*
 FUNCTION
-  - Name:     opDet
-  - Purpose:  Perform the matrix determinant operation.
-              Recursive helper function used in matrix_opDet.
+  - Name:     factorizeScratch
+  - Purpose:  Factor a matrix like matrix_factorize, but with the factors in the scratch arena of the calling thread
+              so an operation that only needs the factorization while it runs allocates nothing.
 PRECONDITION
   - pMx
-      Purpose:       Matrix to calculate the determinant of.
-      Restrictions:  Pointer to a valid matrix object.
-                     The rows equal the columns.
-  - pMem
-      Purpose:       Indicate if memory allocation fails.
-      Restrictions:  Not NULL.
+      Purpose:       Matrix to factor.
+      Restrictions:  Pointer to a valid square matrix.
+  - pFac
+      Purpose:       Store the factorization.
+      Restrictions:  Pointer to a MatrixFactor. It's valid until the scratch arena is released below the mark taken before the call.
 POSTCONDITION
 Success
   - Reason:        No memory allocation failure.
-  - Summary:       Performs the matrix determinant operation and returns the result.
-  - Return value:  Result of the determinant operation.
-  - hMx:           The state of the matrix before the function call is preserved.
-  - pMem:          The Boolean it points to is set to SUCCESS.
+  - Summary:       Factors the matrix.
+  - Return value:  SUCCESS
 Failure
   - Reason:        Memory allocation failure.
-  - Summary:       The determinant operation is not performed and nothing of significance happens.
-  - Return value:  0
-  - hMx:           The state of the matrix before the function call is preserved.
-  - pMem:          The Boolean it points to is set to FAILURE.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
 */
-static double opDet(Matrix* pMx, Status* pMem);
+static Status factorizeScratch(Matrix* pMx, MatrixFactor* pFac);
 
 
 /*
 FUNCTION
-  - Name:     opDet2x2
-  - Purpose:  Perform the matrix determinant operation for a 2 x 2 matrix.
-              Recursive helper function to deal with the base case used in opDet.
+  - Name:     findStructure
+  - Purpose:  Find which of the STRUCTURE_ shapes a matrix has by reading its rows until every shape is ruled out.
+              A general matrix is ruled out after about one row, so only the matrices that have a shape are read in full.
+              A permutation also needs the columns of its 1s to be distinct, which is checked with a flag per column from the scratch arena.
 PRECONDITION
-  - a11
-      Purpose:       Entry in row 1 column 1.
-      Restrictions:  N/A
-  - a12
-      Purpose:       Entry in row 1 column 2.
-      Restrictions:  N/A
-  - a21
-      Purpose:       Entry in row 2 column 1.
-      Restrictions:  N/A
-  - a22
-      Purpose:       Entry in row 2 column 2.
-      Restrictions:  N/A
+  - pMx
+      Purpose:       Matrix to classify.
+      Restrictions:  Pointer to a valid matrix object.
 POSTCONDITION
 Success
-  - Reason:        All cases
-  - Summary:       Performs the matrix determinant operation for a 2 x 2 matrix and returns the result.
-  - Return value:  Result of the 2 x 2 determinant operation.
+  - Reason:        All cases.
+  - Summary:       Returns the shapes of the matrix, none if it isn't square.
+  - Return value:  STRUCTURE_ flags ORed together, 0 for a general matrix.
 Failure
   - N/A
 */
-static double opDet2x2(double a11, double a12, double a21, double a22);
+static int findStructure(Matrix* pMx);
 
 
 /*
 FUNCTION
-  - Name:     removeTrailingZeroes
-  - Purpose:  Remove trailing zeroes from a string representation of an entry which is a floating point number.
+  - Name:     freeEntries
+  - Purpose:  Free an array of entries allocated with allocEntries.
 PRECONDITION
-  - entryStr
-      Purpose:       String representation of the entry to remove the trailing zeroes from.
-      Restrictions:  Any valid string.
+  - entries
+      Purpose:       Array to free.
+      Restrictions:  Array allocated with allocEntries, or NULL.
+  - count
+      Purpose:       Entries in the array.
+      Restrictions:  The count it was allocated with, which decides how it was allocated.
 POSTCONDITION
 Success
   - Reason:        All cases.
-  - Summary:       Removes trailing zeroes from the string representation of an entry.
+  - Summary:       Frees the array.
   - Return value:  N/A
 Failure
   - N/A
 */
-static void removeTrailingZeroes(char* entryStr);
+static void freeEntries(double* entries, size_t count);
 
 
+/*
+FUNCTION
+  - Name:     freeMatrix
+  - Purpose:  Free a matrix header allocated with allocMatrix, putting it on the free list of its size class for the calling thread unless the list is full.
+PRECONDITION
+  - pMx
+      Purpose:       Header to free.
+      Restrictions:  Pointer to a header from allocMatrix whose entries, if they aren't inline, are already freed.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Frees the header.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void freeMatrix(Matrix* pMx);
 
 
-/********** Definitions for matrix interface functions declared in Matrix.h **********/
-Boolean matrix_canBeAdd(MATRIX hMx1, MATRIX hMx2) {
-	Matrix* pMx1 = hMx1;
-	Matrix* pMx2 = hMx2;
-	return (pMx1->rows == pMx2->rows && pMx1->cols == pMx2->cols);
-}
+/*
+FUNCTION
+  - Name:     gemm
+  - Purpose:  Multiply two arrays of entries with cache blocking and store the product in a third.
+              Panels of A and B are packed into contiguous buffers sized for the L2 and L3 caches and the product of each GEMM_MR x GEMM_NR tile is computed in registers by gemmMicroKernel.
+              The strides let any of the three be read or written in row-major or column-major order, or as a view of a larger matrix, without copying it first.
+PRECONDITION
+  - m
+      Purpose:       Rows of A and C.
+      Restrictions:  Any positive integer.
+  - n
+      Purpose:       Columns of B and C.
+      Restrictions:  Any positive integer.
+  - k
+      Purpose:       Columns of A and rows of B.
+      Restrictions:  Any positive integer.
+  - a, rsa, csa
+      Purpose:       A, where entry (i, p) is a[i * rsa + p * csa].
+      Restrictions:  Not NULL.
+  - b, rsb, csb
+      Purpose:       B, where entry (p, j) is b[p * rsb + j * csb].
+      Restrictions:  Not NULL.
+  - c, rsc, csc
+      Purpose:       Store C = A B, where entry (i, j) is c[i * rsc + j * csc].
+      Restrictions:  Not NULL and doesn't overlap A or B.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the product.
+  - Return value:  SUCCESS
+  - c:             Stores the product. Its previous contents are ignored.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The product isn't calculated.
+  - Return value:  FAILURE
+  - c:             The state of the entries before the function call is preserved.
+*/
+static Status gemm(int m, int n, int k, const double* a, ptrdiff_t rsa, ptrdiff_t csa, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* c, ptrdiff_t rsc, ptrdiff_t csc);
 
 
-Boolean matrix_canBeInv(MATRIX hMx, Status* pMem) {
-	double det = matrix_opDet(hMx, pMem);
-	return (*pMem) ? det != 0 : FALSE;
-}
+/*
+FUNCTION
+  - Name:     gemmMicroKernel, gemmMicroKernelSse2, gemmMicroKernelAvx2, gemmMicroKernelAvx512
+  - Purpose:  Multiply a packed GEMM_MR x kc sliver of A by a packed kc x GEMM_NR sliver of B.
+              The SSE2, AVX2 and AVX-512 versions keep the tile in vector registers, the AVX2 and AVX-512 ones with fused multiply-add.
+PRECONDITION
+  - kc
+      Purpose:       Depth of the slivers.
+      Restrictions:  Any positive integer.
+  - a
+      Purpose:       Packed sliver of A with GEMM_MR entries for each step of the depth.
+      Restrictions:  Array of size GEMM_MR * kc.
+  - b
+      Purpose:       Packed sliver of B with GEMM_NR entries for each step of the depth.
+      Restrictions:  Array of size GEMM_NR * kc.
+  - ab
+      Purpose:       Store the GEMM_MR x GEMM_NR product in row-major order.
+      Restrictions:  Array of size GEMM_MR * GEMM_NR.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the product of the slivers.
+  - Return value:  N/A
+  - ab:            Stores the product.
+Failure
+  - N/A
+*/
+static void gemmMicroKernel(int kc, const double* restrict a, const double* restrict b, double* restrict ab);
+#ifdef SIMD_X86
+static void gemmMicroKernelSse2(int kc, const double* restrict a, const double* restrict b, double* restrict ab);
+static void gemmMicroKernelAvx2(int kc, const double* restrict a, const double* restrict b, double* restrict ab);
+static void gemmMicroKernelAvx512(int kc, const double* restrict a, const double* restrict b, double* restrict ab);
+#endif
 
 
-Boolean matrix_canBeMult(MATRIX hMx1, MATRIX hMx2) {
-	Matrix* pMx1 = hMx1;
-	Matrix* pMx2 = hMx2;
-	return pMx1->cols == pMx2->rows;
-}
+/*
+FUNCTION
+  - Name:     gemmPackA
+  - Purpose:  Pack an mc x kc block of A into slivers of GEMM_MR rows so the micro-kernel reads it contiguously.
+              Rows past the end of the block are padded with 0.
+PRECONDITION
+  - mc, kc
+      Purpose:       Rows and columns of the block.
+      Restrictions:  Any positive integers.
+  - a, rsa, csa
+      Purpose:       Block of A, where entry (i, p) is a[i * rsa + p * csa].
+      Restrictions:  Not NULL.
+  - packed
+      Purpose:       Store the packed block.
+      Restrictions:  Array of size kc times mc rounded up to a multiple of GEMM_MR.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Packs the block.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void gemmPackA(int mc, int kc, const double* a, ptrdiff_t rsa, ptrdiff_t csa, double* packed);
 
 
-Boolean matrix_canBeSub(MATRIX hMx1, MATRIX hMx2) {
-	Matrix* pMx1 = hMx1;
-	Matrix* pMx2 = hMx2;
-	return (pMx1->rows == pMx2->rows && pMx1->cols == pMx2->cols);
-}
+/*
+FUNCTION
+  - Name:     gemmPackB
+  - Purpose:  Pack a kc x nc panel of B into slivers of GEMM_NR columns so the micro-kernel reads it contiguously.
+              Columns past the end of the panel are padded with 0.
+PRECONDITION
+  - kc, nc
+      Purpose:       Rows and columns of the panel.
+      Restrictions:  Any positive integers.
+  - b, rsb, csb
+      Purpose:       Panel of B, where entry (p, j) is b[p * rsb + j * csb].
+      Restrictions:  Not NULL.
+  - packed
+      Purpose:       Store the packed panel.
+      Restrictions:  Array of size kc times nc rounded up to a multiple of GEMM_NR.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Packs the panel.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void gemmPackB(int kc, int nc, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* packed);
 
 
-Status matrix_copy(MATRIX* phMxDest, MATRIX hMxSrc) {
-	Matrix* pMxSrc = hMxSrc;
-	Matrix* pMxDest = *phMxDest;
-	double* entries;
+/*
+FUNCTION
+  - Name:     gemmScratchBytes
+  - Purpose:  Calculate the bytes of the scratch arena gemm takes for its packing buffers.
+PRECONDITION
+  - m, n, k
+      Purpose:       Dimensions of the product, as passed to gemm.
+      Restrictions:  Any positive integers.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Sizes the buffers like gemm, each rounded up to ENTRIES_ALIGN like scratchAlloc.
+  - Return value:  The bytes, at most GEMM_SCRATCH_BYTES.
+Failure
+  - N/A
+*/
+static size_t gemmScratchBytes(int m, int n, int k);
 
-	// destination matrix doesn't exist, create new matrix
-	if (!(*phMxDest)) {
-		if (!(*phMxDest = matrix_initDims(pMxSrc->rows, pMxSrc->cols)))
-			return FAILURE;
-		pMxDest = *phMxDest;
-	}
-	// destination matrix exists
-	else {
-		// resize if necessary
-		if (getSize(pMxDest->rows, pMxDest->cols) < getSize(pMxSrc->rows, pMxSrc->cols)) {
-			if (!(entries = calloc(getSize(pMxSrc->rows, pMxSrc->cols), sizeof(*entries))))
-				return FAILURE;
-			free(pMxDest->entries);
-			pMxDest->entries = entries;
-		}
-		pMxDest->rows = pMxSrc->rows;
-		pMxDest->cols = pMxSrc->cols;
-	}
-	
-	// in either case, set the max length and copy the entries
-	pMxDest->maxLength = pMxSrc->maxLength;
-	int size = getSize(pMxSrc->rows, pMxSrc->cols);
-	for (int i = 0; i < size; ++i)
-		pMxDest->entries[i] = pMxSrc->entries[i];
-	
-	return SUCCESS;
-}
 
+/*
+FUNCTION
+  - Name:     gemmTask
+  - Purpose:  Thread pool task that computes one tile of the product with gemm.
+PRECONDITION
+  - arg
+      Purpose:       The product being computed.
+      Restrictions:  Pointer to a GemmJob.
+  - taskIdx
+      Purpose:       Index of the tile in row-major order.
+      Restrictions:  Any integer >= 0 less than the number of tiles.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the tile.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The tile isn't calculated.
+  - Return value:  FAILURE
+*/
+static Status gemmTask(void* arg, int taskIdx);
 
-Status matrix_destroy(MATRIX* phMx) {
+
+/*
+FUNCTION
+  - Name:     getMaxLength
+  - Purpose:  Get the max width of an entry of a matrix, recalculating it with calcEntryLength only if the entries changed since it was last calculated.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix to get the max width of.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the max width and caches it in the matrix.
+  - Return value:  The max width of an entry.
+Failure
+  - N/A
+*/
+static int getMaxLength(Matrix* pMx);
+
+
+/*
+FUNCTION
+  - Name:     getScratch
+  - Purpose:  Get the scratch arena of the calling thread, creating it on first use.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns the arena.
+  - Return value:  Pointer to the arena.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static Scratch* getScratch(void);
+
+
+/*
+FUNCTION
+  - Name:     getSimdKernels
+  - Purpose:  Get the kernels for the selected instruction set, selecting the best one the CPU supports on first use.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the kernels.
+  - Return value:  Pointer to an entry of simdKernelsTable.
+Failure
+  - N/A
+*/
+static const SimdKernels* getSimdKernels(void);
+
+
+/*
+FUNCTION
+  - Name:     initMatrix
+  - Purpose:  Initialize a new matrix with a given amount of rows and columns, either with every entry 0 like matrix_initDims or with the entries uninitialized.
+PRECONDITION
+  - rows
+      Purpose:       Rows of the new matrix.
+      Restrictions:  Any positive integer.
+  - cols
+      Purpose:       Columns of the new matrix.
+      Restrictions:  Any positive integer.
+  - zero
+      Purpose:       Whether the entries are set to 0.
+      Restrictions:  FALSE only if the caller overwrites every entry before the matrix is used.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Initializes and returns a new matrix with the given amount of rows and columns.
+  - Return value:  Pointer to the new matrix.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Doesn't initialize and return a new matrix and nothing of significance happens.
+  - Return value:  NULL
+*/
+static Matrix* initMatrix(int rows, int cols, Boolean zero);
+
+
+/*
+FUNCTION
+  - Name:     initScratchKey
+  - Purpose:  Create the key of the scratch arena of each thread, which frees the arena when its thread exits.
+              Run once through pthread_once.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Creates scratchKey.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void initScratchKey(void);
+
+
+/*
+FUNCTION
+  - Name:     initSimdKernels
+  - Purpose:  Select the kernels for the best instruction set the CPU supports.
+              Run once through pthread_once so operations started at the same time on different threads agree.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Sets pSimdKernels.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void initSimdKernels(void);
+
+
+/*
+FUNCTION
+  - Name:     getSize
+  - Purpose:  Calculate the size of the 1D array of entries using the number of rows and columns in the 2D matrix.
+PRECONDITION
+  - rows
+      Purpose:       Rows of the matrix.
+      Restrictions:  Any positive integer.
+  - cols
+      Purpose:       Columns of the matrix
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates and returns the size of the 1D array of entries using the number of rows and columns in the 2D matrix.
+  - Return value:  Returns the number as described above.
+Failure
+  - N/A
+*/
+size_t getSize(int rows, int cols);
+
+
+/*
+FUNCTION
+  - Name:     getStructure
+  - Purpose:  Get the shapes of a matrix, finding them with findStructure only if the entries changed since they were last found.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix to get the shapes of.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the shapes and caches them in the matrix.
+  - Return value:  STRUCTURE_ flags ORed together, 0 for a general matrix.
+Failure
+  - N/A
+*/
+static int getStructure(Matrix* pMx);
+
+
+/*
+FUNCTION
+  - Name:     headerCount
+  - Purpose:  Get the size of a matrix header of a size class in doubles, the count allocMatrix allocates it with through allocEntries.
+PRECONDITION
+  - sizeClass
+      Purpose:       Size class of the header.
+      Restrictions:  Any integer >= 0 less than POOL_CLASSES.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Adds the inline entries of the class to the header, whose size is a multiple of ENTRIES_ALIGN.
+  - Return value:  The size in doubles.
+Failure
+  - N/A
+*/
+static size_t headerCount(int sizeClass);
+
+
+/*
+FUNCTION
+  - Name:     isContiguous
+  - Purpose:  Check if the entries of a matrix are laid out one after another in row-major order, like a matrix that owns its entries.
+              Views of whole rows and transposed views of single rows or columns are contiguous too.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix to check.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Checks the strides of the matrix.
+  - Return value:  TRUE if entry (i, j) is entries[i * cols + j], FALSE otherwise.
+Failure
+  - N/A
+*/
+static Boolean isContiguous(const Matrix* pMx);
+
+
+/*
+FUNCTION
+  - Name:     isPivotZero
+  - Purpose:  Check if a pivot of an LU factorization is 0 or reduced to rounding noise, which makes the matrix singular.
+              Every test of whether a dense matrix is invertible goes through it, so a shortcut can't call a matrix singular that the factorization would invert or the reverse.
+PRECONDITION
+  - pivot
+      Purpose:       Magnitude of the pivot.
+      Restrictions:  Any nonnegative number.
+  - colMax, rowMax
+      Purpose:       Largest magnitude originally in the column of the pivot and in the row it came from.
+      Restrictions:  Any nonnegative numbers.
+  - n
+      Purpose:       Rows and columns of the matrix, the number of operations whose rounding error the pivot can hold.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Compares the pivot with n rounding errors of the smaller of the two scales.
+  - Return value:  TRUE if the pivot is treated as 0, FALSE otherwise.
+Failure
+  - N/A
+*/
+static Boolean isPivotZero(double pivot, double colMax, double rowMax, ptrdiff_t n);
+
+
+/*
+FUNCTION
+  - Name:     luDecompose
+  - Purpose:  Perform an in-place LU factorization with partial pivoting of a square array of entries.
+              On return the strictly lower part of the array holds the multipliers of L (its unit diagonal is implied) and the upper part holds U.
+PRECONDITION
+  - lu
+      Purpose:       Entries to factor in row-major order.
+      Restrictions:  Array of size n * n.
+  - n
+      Purpose:       Rows and columns of the entries.
+      Restrictions:  Any positive integer.
+  - piv
+      Purpose:       Store the row swapped with each row during the factorization.
+      Restrictions:  Array of size n or NULL if the pivots aren't needed.
+  - scale
+      Purpose:       Scratch space for the largest magnitude of each original column followed by that of each original row.
+      Restrictions:  Array of size 2 * n.
+POSTCONDITION
+Success
+  - Reason:        The entries are not singular.
+  - Summary:       Factors the entries in place.
+                   A pivot is treated as 0 if its magnitude is within rounding error of both the largest entry originally in its column
+                   and the largest entry originally in the row it came from. Scaling a row or a column of a nonsingular matrix therefore can't make it look singular,
+                   while the rounding noise left by eliminating a singular matrix is still recognized.
+  - Return value:  The sign of the row permutation (1 or -1).
+  - lu:            Stores L and U as described above.
+  - piv:           If not NULL, piv[k] is the row that was swapped with row k.
+Failure
+  - Reason:        The entries are singular.
+  - Summary:       The factorization stops at the first zero pivot.
+  - Return value:  0
+  - lu:            Partially factored.
+  - piv:           Partially filled.
+*/
+static int luDecompose(double* lu, ptrdiff_t n, int* piv, double* scale);
+
+
+/*
+FUNCTION
+  - Name:     luSolve
+  - Purpose:  Solve A X = B in place for a matrix A factored by luDecompose and any number of right-hand side columns.
+              The columns of the right-hand side are split into panels small enough to stay in cache.
+              Within a panel the rows are permuted and then forward and back substitution are done a whole panel row at a time so every access is contiguous.
+PRECONDITION
+  - lu
+      Purpose:       LU factorization of A.
+      Restrictions:  Array of size n * n filled by a successful call to luDecompose.
+  - piv
+      Purpose:       Row swaps of the factorization.
+      Restrictions:  Array of size n filled by the same call to luDecompose.
+  - n
+      Purpose:       Rows and columns of A.
+      Restrictions:  Any positive integer.
+  - x
+      Purpose:       Holds B on entry and X on return, in row-major order.
+      Restrictions:  Array of size n * nrhs.
+  - nrhs
+      Purpose:       Columns of B.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Solves the system and overwrites B with the solution.
+  - Return value:  N/A
+  - x:             Stores X.
+Failure
+  - N/A
+*/
+static void luSolve(const double* lu, const int* piv, ptrdiff_t n, double* x, ptrdiff_t nrhs);
+
+
+/*
+FUNCTION
+  - Name:     markDirty
+  - Purpose:  Mark the max length and structure of a matrix out of date after its entries change, along with those of its owner if it's a view.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix whose entries changed.
+      Restrictions:  Pointer to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       The max length is recalculated the next time either matrix is printed and the structure the next time an operation uses it.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void markDirty(Matrix* pMx);
+
+
+/*
+FUNCTION
+  - Name:     multDiagonal
+  - Purpose:  Multiply by a diagonal matrix, which scales each row of the other factor if the diagonal matrix is on the left and each column if it's on the right.
+PRECONDITION
+  - pMxDiag
+      Purpose:       Diagonal factor.
+      Restrictions:  Pointer to a valid matrix object with the shape STRUCTURE_DIAGONAL.
+  - pMx
+      Purpose:       Other factor.
+      Restrictions:  Pointer to a valid matrix object whose rows (left) or columns (right) equal the size of pMxDiag.
+  - left
+      Purpose:       Whether pMxDiag is the left factor.
+      Restrictions:  TRUE or FALSE.
+  - pMxRes
+      Purpose:       Product.
+      Restrictions:  Pointer to a valid matrix object with the dimensions of pMx that isn't either factor.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Stores the product in O(rows * cols) instead of O(n * rows * cols).
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void multDiagonal(const Matrix* pMxDiag, const Matrix* pMx, Boolean left, Matrix* pMxRes);
+
+
+/*
+FUNCTION
+  - Name:     multPermutation
+  - Purpose:  Multiply by a permutation matrix, which gathers the rows of the other factor if the permutation is on the left and its columns if it's on the right.
+              Row i of P B is the row of B whose index is the column of the 1 in row i of P, and column j of A P is the column of A whose index is the row of the 1 in column j of P.
+PRECONDITION
+  - pMxPerm
+      Purpose:       Permutation factor.
+      Restrictions:  Pointer to a valid matrix object with the shape STRUCTURE_PERMUTATION.
+  - pMx
+      Purpose:       Other factor.
+      Restrictions:  Pointer to a valid matrix object whose rows (left) or columns (right) equal the size of pMxPerm.
+  - left
+      Purpose:       Whether pMxPerm is the left factor.
+      Restrictions:  TRUE or FALSE.
+  - pMxRes
+      Purpose:       Product.
+      Restrictions:  Pointer to a valid matrix object with the dimensions of pMx that isn't either factor.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Stores the product in O(n^2 + rows * cols) instead of O(n * rows * cols) without a single multiplication.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void multPermutation(const Matrix* pMxPerm, const Matrix* pMx, Boolean left, Matrix* pMxRes);
+
+
+/*
+FUNCTION
+  - Name:     opDet2x2
+  - Purpose:  Perform the matrix determinant operation for a 2 x 2 matrix.
+              Helper function to deal with the 2 x 2 case directly in matrix_opDet without factoring.
+PRECONDITION
+  - a11
+      Purpose:       Entry in row 1 column 1.
+      Restrictions:  N/A
+  - a12
+      Purpose:       Entry in row 1 column 2.
+      Restrictions:  N/A
+  - a21
+      Purpose:       Entry in row 2 column 1.
+      Restrictions:  N/A
+  - a22
+      Purpose:       Entry in row 2 column 2.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        All cases
+  - Summary:       Performs the matrix determinant operation for a 2 x 2 matrix and returns the result.
+  - Return value:  Result of the 2 x 2 determinant operation.
+Failure
+  - N/A
+*/
+static double opDet2x2(double a11, double a12, double a21, double a22);
+
+
+/*
+FUNCTION
+  - Name:     opPowDiagonal
+  - Purpose:  Raise a diagonal matrix to a power, or invert it for the power -1, by raising each entry of the diagonal on its own.
+              The entries are squared in the same order as the exponentiation by squaring of matrix_opPow, so the result is the same.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix to raise to the power.
+      Restrictions:  Pointer to a valid matrix object with the shape STRUCTURE_DIAGONAL, and no entry of the diagonal 0 for the power -1.
+  - power
+      Purpose:       Power to raise the matrix to.
+      Restrictions:  Any positive integer or -1.
+  - ppMxRes
+      Purpose:       Store the result.
+      Restrictions:  Pointer to a pointer to a valid matrix object or NULL, which can be pMx.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Stores the result in O(n) operations, plus O(n^2) to zero the result.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+static Status opPowDiagonal(Matrix* pMx, int power, Matrix** ppMxRes);
+
+
+/*
+FUNCTION
+  - Name:     reallocEntries
+  - Purpose:  Change the size of an array of entries allocated with allocEntries, keeping the entries that fit in both.
+PRECONDITION
+  - entries
+      Purpose:       Array to resize.
+      Restrictions:  Array allocated with allocEntries.
+  - count
+      Purpose:       Entries in the array.
+      Restrictions:  The count it was allocated with.
+  - newCount
+      Purpose:       Entries in the resized array.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the new array, copies the entries and frees the old array.
+  - Return value:  The new array.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The old array is preserved.
+  - Return value:  NULL
+*/
+static double* reallocEntries(double* entries, size_t count, size_t newCount);
+
+
+/*
+FUNCTION
+  - Name:     releaseEntries
+  - Purpose:  Free the array of entries of a matrix that owns them, unless they're stored inline in its header.
+PRECONDITION
+  - pMx
+      Purpose:       Matrix whose entries are freed.
+      Restrictions:  Pointer to a valid matrix that isn't a view.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Frees the entries. The caller points the matrix at new entries or frees the header.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void releaseEntries(Matrix* pMx);
+
+
+/*
+FUNCTION
+  - Name:     removeTrailingZeroes
+  - Purpose:  Remove trailing zeroes from a string representation of an entry which is a floating point number.
+PRECONDITION
+  - entryStr
+      Purpose:       String representation of the entry to remove the trailing zeroes from.
+      Restrictions:  Any valid string.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Removes trailing zeroes from the string representation of an entry.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void removeTrailingZeroes(char* entryStr);
+
+
+/*
+FUNCTION
+  - Name:     scratchAlloc
+  - Purpose:  Allocate temporary memory from the scratch arena of the calling thread.
+              Operations take a mark with scratchMark on entry, allocate their temporaries with scratchAlloc and release them all at once with scratchRelease on exit.
+              Requests are carved from one block, so once the block has grown to what the operations of the thread need, they make no allocations at all.
+              A request that doesn't fit is allocated on its own until the arena is next released empty, and the block then grows to hold everything needed at once.
+PRECONDITION
+  - bytes
+      Purpose:       Bytes to allocate.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the memory, aligned to ENTRIES_ALIGN bytes. Its contents are unspecified.
+  - Return value:  The memory.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static void* scratchAlloc(size_t bytes);
+
+
+/*
+FUNCTION
+  - Name:     scratchDestroy
+  - Purpose:  Free a scratch arena when its thread exits.
+PRECONDITION
+  - arg
+      Purpose:       Arena to free.
+      Restrictions:  Pointer to a Scratch stored under scratchKey.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Unlinks the arena from scratchList and frees it, its block and its free headers.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void scratchDestroy(void* arg);
+
+
+/*
+FUNCTION
+  - Name:     scratchFreeBlocks
+  - Purpose:  Free the block of a scratch arena and the matrix headers on its free lists, when its thread exits or before the allocator they came from changes.
+              Must only be called while its thread isn't running an operation.
+PRECONDITION
+  - pScr
+      Purpose:       Arena to free the memory of.
+      Restrictions:  Pointer to an empty arena.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       The arena has no block and no free headers. It allocates a new block the next time it's released empty.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void scratchFreeBlocks(Scratch* pScr);
+
+
+/*
+FUNCTION
+  - Name:     scratchMark
+  - Purpose:  Get the top of the scratch arena of the calling thread, to release everything allocated after it with scratchRelease.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the mark.
+  - Return value:  The mark, 0 if the arena is empty or can't be created.
+Failure
+  - N/A
+*/
+static size_t scratchMark(void);
+
+
+/*
+FUNCTION
+  - Name:     scratchRelease
+  - Purpose:  Release everything allocated from the scratch arena of the calling thread since a mark was taken.
+              When the arena becomes empty and the operations needed more than its block, the block is replaced by one at least twice its size that holds all of it,
+              up to SCRATCH_MAX_BYTES. Whatever an operation needs past that comes from chunks that are freed here, so a single large operation
+              doesn't leave its temporaries resident in every thread that ran it.
+PRECONDITION
+  - mark
+      Purpose:       Top to release the arena to.
+      Restrictions:  A mark from scratchMark on the calling thread that hasn't been released past yet.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Releases the memory.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void scratchRelease(size_t mark);
+
+
+/*
+FUNCTION
+  - Name:     scratchWarm
+  - Purpose:  Give the scratch arena of the calling thread a block of at least scratchWarmBytes, enough for the packing buffers of the largest tile of a product split across the pool so far.
+              Once a product has been split across the pool, each worker runs it when it starts, so a worker that takes its first tile long after the others doesn't allocate then.
+              A program that never multiplies matrices large enough to split has its workers warm nothing.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       The arena has the block unless the allocation failed, in which case it grows on first use as usual.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void scratchWarm(void);
+
+
+/*
+FUNCTION
+  - Name:     transBlock, transBlockSse2, transBlockAvx2
+  - Purpose:  Transpose a TRANS_BLOCK x TRANS_BLOCK tile of entries.
+              The SSE2 version swaps 2 x 2 blocks in registers and the AVX2 version shuffles the whole tile in registers.
+PRECONDITION
+  - src, lds
+      Purpose:       Tile to transpose, where entry (i, j) is src[i * lds + j].
+      Restrictions:  Not NULL.
+  - dst, ldd
+      Purpose:       Store the transposed tile, where entry (j, i) is dst[j * ldd + i].
+      Restrictions:  Not NULL and doesn't overlap src.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Transposes the tile.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void transBlock(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd);
+#ifdef SIMD_X86
+static void transBlockSse2(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd);
+static void transBlockAvx2(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd);
+#endif
+
+
+/*
+FUNCTION
+  - Name:     transCyclesInPlace
+  - Purpose:  Transpose a rectangular array of entries in place by following the cycles of the permutation.
+              The entry at index k moves to index k * rows mod (size - 1), except the first and last entries which stay put.
+              A bitset marks the entries already moved, so the only extra memory is one bit per entry.
+PRECONDITION
+  - entries
+      Purpose:       Entries to transpose, rows x cols in row-major order.
+      Restrictions:  Array of size rows * cols.
+  - rows, cols
+      Purpose:       Dimensions of the entries before the transpose.
+      Restrictions:  Any positive integers.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Transposes the entries.
+  - Return value:  SUCCESS
+  - entries:       Stores the cols x rows transpose in row-major order.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The entries aren't transposed.
+  - Return value:  FAILURE
+  - entries:       The state of the entries before the function call is preserved.
+*/
+static Status transCyclesInPlace(double* entries, int rows, int cols);
+
+
+/*
+FUNCTION
+  - Name:     transRecursive
+  - Purpose:  Transpose an array of entries into another with a cache-oblivious recursion.
+              The longer side is halved until the block is at most TRANS_LEAF x TRANS_LEAF, which is then transposed a TRANS_BLOCK x TRANS_BLOCK tile at a time.
+              Every level of the cache then sees blocks that fit in it without tuning for its size.
+PRECONDITION
+  - src, lds
+      Purpose:       Block to transpose, where entry (i, j) is src[i * lds + j].
+      Restrictions:  Not NULL.
+  - dst, ldd
+      Purpose:       Store the transposed block, where entry (j, i) is dst[j * ldd + i].
+      Restrictions:  Not NULL and doesn't overlap src.
+  - rows, cols
+      Purpose:       Dimensions of the block.
+      Restrictions:  Any positive integers.
+  - kernel
+      Purpose:       Transpose a TRANS_BLOCK x TRANS_BLOCK tile.
+      Restrictions:  The transBlock kernel of an instruction set.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Transposes the block.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void transRecursive(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd, int rows, int cols, void (*kernel)(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd));
+
+
+/*
+FUNCTION
+  - Name:     transSquareInPlace
+  - Purpose:  Transpose a square array of entries in place.
+              The array is split into TRANS_LEAF x TRANS_LEAF blocks and each block above the diagonal is swapped with its mirror below it so both stay in L1.
+PRECONDITION
+  - entries, rs, cs
+      Purpose:       Entries to transpose, where entry (i, j) is entries[i * rs + j * cs].
+      Restrictions:  Not NULL.
+  - n
+      Purpose:       Rows and columns of the entries.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Transposes the entries.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void transSquareInPlace(double* entries, int n, ptrdiff_t rs, ptrdiff_t cs);
+
+
+/*
+FUNCTION
+  - Name:     vecAdd, vecAddSse2, vecAddAvx2, vecAddAvx512
+  - Purpose:  Add two arrays of entries elementwise.
+PRECONDITION
+  - n
+      Purpose:       Size of the arrays.
+      Restrictions:  Any integer >= 0.
+  - x, y
+      Purpose:       Arrays being added.
+      Restrictions:  Arrays of size n.
+  - z
+      Purpose:       Store x + y.
+      Restrictions:  Array of size n. May be x or y but must not partially overlap them.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the sum. Every version rounds exactly like the scalar one.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void vecAdd(int n, const double* x, const double* y, double* z);
+#ifdef SIMD_X86
+static void vecAddSse2(int n, const double* x, const double* y, double* z);
+static void vecAddAvx2(int n, const double* x, const double* y, double* z);
+static void vecAddAvx512(int n, const double* x, const double* y, double* z);
+#endif
+
+
+/*
+FUNCTION
+  - Name:     vecSub, vecSubSse2, vecSubAvx2, vecSubAvx512
+  - Purpose:  Subtract two arrays of entries elementwise.
+PRECONDITION
+  - n
+      Purpose:       Size of the arrays.
+      Restrictions:  Any integer >= 0.
+  - x, y
+      Purpose:       Arrays being subtracted.
+      Restrictions:  Arrays of size n.
+  - z
+      Purpose:       Store x - y.
+      Restrictions:  Array of size n. May be x or y but must not partially overlap them.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the difference. Every version rounds exactly like the scalar one.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void vecSub(int n, const double* x, const double* y, double* z);
+#ifdef SIMD_X86
+static void vecSubSse2(int n, const double* x, const double* y, double* z);
+static void vecSubAvx2(int n, const double* x, const double* y, double* z);
+static void vecSubAvx512(int n, const double* x, const double* y, double* z);
+#endif
+
+
+// kernels for each instruction set, indexed by SimdLevel
+static const SimdKernels simdKernelsTable[] = {
+	{ SIMD_SCALAR, gemmMicroKernel, transBlock, vecAdd, vecSub },
+#ifdef SIMD_X86
+	{ SIMD_SSE2, gemmMicroKernelSse2, transBlockSse2, vecAddSse2, vecSubSse2 },
+	{ SIMD_AVX2, gemmMicroKernelAvx2, transBlockAvx2, vecAddAvx2, vecSubAvx2 },
+	{ SIMD_AVX512, gemmMicroKernelAvx512, transBlockAvx2, vecAddAvx512, vecSubAvx512 },
+#endif
+};
+static const SimdKernels* pSimdKernels = NULL;    // kernels in use, NULL until first use
+static Allocator allocator = { NULL, NULL, NULL, NULL };    // allocator every allocation of the library goes through
+static Scratch* scratchList = NULL;                         // scratch arenas of all threads
+static pthread_mutex_t scratchLock = PTHREAD_MUTEX_INITIALIZER;    // guards scratchList and scratchWarmBytes
+static pthread_key_t scratchKey;                            // scratch arena of the calling thread
+static pthread_once_t scratchKeyOnce = PTHREAD_ONCE_INIT;
+static const size_t poolClassSizes[POOL_CLASSES] = { 0, 4, 9, 16, 36, 64 };    // entries stored inline by the headers of each size class, up to 8 x 8
+static pthread_once_t simdKernelsOnce = PTHREAD_ONCE_INIT;
+static size_t scratchWarmBytes = 0;                         // block the workers warm their scratch arenas to when they start, 0 until a product is split across them
+
+
+
+
+/********** Definitions for matrix interface functions declared in Matrix.h **********/
+void* matrix_alloc(size_t size) {
+	size_t align = _Alignof(max_align_t);
+	return allocator.allocFn ? allocator.allocFn((size + align - 1) / align * align, align, allocator.userdata) : malloc(size);
+}
+
+
+Boolean matrix_canBeAdd(MATRIX hMx1, MATRIX hMx2) {
+	Matrix* pMx1 = hMx1;
+	Matrix* pMx2 = hMx2;
+	return (pMx1->rows == pMx2->rows && pMx1->cols == pMx2->cols);
+}
+
+
+Boolean matrix_canBeInv(MATRIX hMx, Status* pMem) {
+	MatrixFactor fac;
+	size_t mark = scratchMark();
+
+	*pMem = factorizeScratch(hMx, &fac);
+	scratchRelease(mark);
+
+	return *pMem && fac.sign != 0;
+}
+
+
+Boolean matrix_canBeMult(MATRIX hMx1, MATRIX hMx2) {
+	Matrix* pMx1 = hMx1;
+	Matrix* pMx2 = hMx2;
+	return pMx1->cols == pMx2->rows;
+}
+
+
+Boolean matrix_canBeSub(MATRIX hMx1, MATRIX hMx2) {
+	Matrix* pMx1 = hMx1;
+	Matrix* pMx2 = hMx2;
+	return (pMx1->rows == pMx2->rows && pMx1->cols == pMx2->cols);
+}
+
+
+Status matrix_copy(MATRIX* phMxDest, MATRIX hMxSrc) {
+	Matrix* pMxSrc = hMxSrc;
+	Matrix* pMxDest = *phMxDest;
+	double* entries;
+
+	// destination matrix doesn't exist, create new matrix
+	if (!(*phMxDest)) {
+		if (!(*phMxDest = initMatrix(pMxSrc->rows, pMxSrc->cols, FALSE)))
+			return FAILURE;
+		pMxDest = *phMxDest;
+	}
+	// destination matrix is a view, the entries are copied into its owner so the dimensions can't change
+	else if (pMxDest->owner) {
+		if (pMxDest->rows != pMxSrc->rows || pMxDest->cols != pMxSrc->cols)
+			return FAILURE;
+	}
+	// destination matrix exists
+	else {
+		// resize if the array can't hold the entries
+		if (pMxDest->capacity < getSize(pMxSrc->rows, pMxSrc->cols)) {
+			if (!(entries = allocEntries(getSize(pMxSrc->rows, pMxSrc->cols), FALSE)))
+				return FAILURE;
+			releaseEntries(pMxDest);
+			pMxDest->entries = entries;
+			pMxDest->capacity = getSize(pMxSrc->rows, pMxSrc->cols);
+		}
+		pMxDest->rows = pMxSrc->rows;
+		pMxDest->cols = pMxSrc->cols;
+		pMxDest->rowStride = pMxSrc->cols;
+	}
+	
+	// in any case, set the max length and structure and copy the entries
+	copyMaxLength(pMxDest, pMxSrc);
+	copyStructure(pMxDest, pMxSrc);
+	copyEntries(pMxSrc->rows, pMxSrc->cols, pMxSrc->entries, pMxSrc->rowStride, pMxSrc->colStride, pMxDest->entries, pMxDest->rowStride, pMxDest->colStride);
+	
+	return SUCCESS;
+}
+
+
+Status matrix_destroy(MATRIX* phMx) {
 	Matrix* pMx = *phMx;
 	if (pMx) {
-		free(pMx->entries);
-		free(pMx);
+		if (!pMx->owner)
+			releaseEntries(pMx);
+		freeMatrix(pMx);
 		*phMx = NULL;
 		return SUCCESS;
 	}
-	return FAILURE;
+	return FAILURE;
+}
+
+
+Boolean matrix_factorCanBeInv(MATRIX_FACTOR hFac) {
+	MatrixFactor* pFac = hFac;
+	return pFac->sign != 0;
+}
+
+
+Status matrix_factorDestroy(MATRIX_FACTOR* phFac) {
+	MatrixFactor* pFac = *phFac;
+	if (pFac) {
+		freeEntries(pFac->lu, getSize(pFac->n, pFac->n) + 2 * pFac->n);
+		matrix_free(pFac->piv);
+		matrix_free(pFac);
+		*phFac = NULL;
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+
+double matrix_factorDet(MATRIX_FACTOR hFac) {
+	MatrixFactor* pFac = hFac;
+	double det = pFac->sign;
+
+	for (int i = 0; i < pFac->n && pFac->sign; ++i)
+		det *= pFac->lu[at2(pFac->n, pFac->n, i, i)];
+
+	return det;
+}
+
+
+Status matrix_factorInv(MATRIX_FACTOR hFac, Boolean* pMxIsInvertible, MATRIX* phMxRes) {
+	MatrixFactor* pFac = hFac;
+	Matrix* pMxRes = *phMxRes;    // result matrix, may be NULL
+	double* x = NULL;             // separate array to solve in if the result is a view whose entries aren't contiguous
+	int n = pFac->n;
+	size_t mark;
+
+
+	// a pivot is 0 - the determinant is 0, the matrix is invertible and the inverse can't be calculated
+	*pMxIsInvertible = !pFac->sign;
+	if (!pFac->sign)
+		return FAILURE;
+
+	mark = scratchMark();
+	if (pMxRes && !isContiguous(pMxRes)) {
+		if (!(x = scratchAlloc(sizeof(*x) * getSize(n, n)))) {
+			scratchRelease(mark);
+			return FAILURE;
+		}
+		memset(x, 0, sizeof(*x) * getSize(n, n));
+	}
+
+	// recreate the result matrix if its dimensions aren't appropriate for the inverse or it's NULL, zeroed for the identity
+	if (!adjustMatrixDims((Matrix**)phMxRes, n, n, !x)) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+	pMxRes = *phMxRes;
+
+	// solve A X = I directly in the result matrix - X is the inverse
+	if (!x) {
+		for (int i = 0; i < n; ++i)
+			pMxRes->entries[at(pMxRes, i, i)] = 1;
+		luSolve(pFac->lu, pFac->piv, n, pMxRes->entries, n);
+	}
+	else {
+		for (int i = 0; i < n; ++i)
+			x[at2(n, n, i, i)] = 1;
+		luSolve(pFac->lu, pFac->piv, n, x, n);
+		copyEntries(n, n, x, n, 1, pMxRes->entries, pMxRes->rowStride, pMxRes->colStride);
+	}
+	scratchRelease(mark);
+
+	return SUCCESS;
+}
+
+
+MATRIX_FACTOR matrix_factorize(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	int n = pMx->rows;
+
+	MatrixFactor* pFac = matrix_alloc(sizeof(*pFac));
+	if (pFac) {
+		// the column and row maxima needed during the factorization are kept after the factors
+		if (!(pFac->lu = allocEntries(getSize(n, n) + 2 * n, FALSE))) {
+			matrix_free(pFac);
+			return NULL;
+		}
+		if (!(pFac->piv = matrix_alloc(sizeof(*(pFac->piv)) * n))) {
+			freeEntries(pFac->lu, getSize(n, n) + 2 * n);
+			matrix_free(pFac);
+			return NULL;
+		}
+		pFac->n = n;
+		copyEntries(n, n, pMx->entries, pMx->rowStride, pMx->colStride, pFac->lu, n, 1);
+		pFac->sign = luDecompose(pFac->lu, n, pFac->piv, pFac->lu + getSize(n, n));
+	}
+
+	return pFac;
+}
+
+
+Status matrix_factorSolve(MATRIX_FACTOR hFac, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX) {
+	MatrixFactor* pFac = hFac;
+	Matrix* pMxB = hMxB;
+	Matrix* pMxX = *phMxX;    // result matrix, may be NULL
+	double* x = NULL;         // separate array to solve in if the result is a view whose entries aren't contiguous
+	size_t mark;
+
+
+	// a pivot is 0 - A is invertible and the system has no unique solution
+	*pMxIsInvertible = !pFac->sign;
+	if (!pFac->sign)
+		return FAILURE;
+
+	mark = scratchMark();
+	if (pMxX && !isContiguous(pMxX) && !(x = scratchAlloc(sizeof(*x) * getSize(pMxB->rows, pMxB->cols)))) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+
+	// copy the right-hand side into the result matrix unless solving in place
+	if (*phMxX != hMxB) {
+		if (!adjustMatrixDims((Matrix**)phMxX, pMxB->rows, pMxB->cols, FALSE)) {
+			scratchRelease(mark);
+			return FAILURE;
+		}
+		pMxX = *phMxX;
+		if (!x)
+			copyEntries(pMxB->rows, pMxB->cols, pMxB->entries, pMxB->rowStride, pMxB->colStride, pMxX->entries, pMxX->rowStride, pMxX->colStride);
+	}
+
+	if (!x)
+		luSolve(pFac->lu, pFac->piv, pFac->n, pMxX->entries, pMxX->cols);
+	else {
+		copyEntries(pMxB->rows, pMxB->cols, pMxB->entries, pMxB->rowStride, pMxB->colStride, x, pMxB->cols, 1);
+		luSolve(pFac->lu, pFac->piv, pFac->n, x, pMxB->cols);
+		copyEntries(pMxX->rows, pMxX->cols, x, pMxX->cols, 1, pMxX->entries, pMxX->rowStride, pMxX->colStride);
+	}
+	scratchRelease(mark);
+	markDirty(pMxX);
+
+	return SUCCESS;
+}
+
+
+void matrix_free(void* ptr) {
+	if (!allocator.freeFn)
+		free(ptr);
+	else if (ptr)
+		allocator.freeFn(ptr, allocator.userdata);
+}
+
+
+int matrix_getCols(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	return pMx->cols;
+}
+
+
+Status matrix_getEntry(MATRIX hMx, int row, int col, double* pEntry) {
+	Matrix* pMx = hMx;
+	ptrdiff_t idx;
+
+	idx = at(hMx, row, col);
+	if (idx != -1) {
+		*pEntry = pMx->entries[idx];
+		return SUCCESS;
+	}
+	else {
+		*pEntry = 0;
+		return FAILURE;
+	}
+}
+
+
+int matrix_getNumThreads(void) {
+	return threadPool_getNumThreads();
+}
+
+
+int matrix_getRows(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	return pMx->rows;
+}
+
+
+SimdLevel matrix_getSimdLevel(void) {
+	return getSimdKernels()->level;
+}
+
+
+size_t matrix_getSize(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	return getSize(pMx->rows, pMx->cols);
+}
+
+
+MATRIX matrix_initCopy(MATRIX hMxSrc) {
+	Matrix* pMxSrc = hMxSrc;
+
+	// every entry is copied so the new matrix doesn't need to be zeroed first
+	Matrix* pMx = initMatrix(pMxSrc->rows, pMxSrc->cols, FALSE);
+	if (pMx) {
+		copyMaxLength(pMx, pMxSrc);
+		copyStructure(pMx, pMxSrc);
+		copyEntries(pMx->rows, pMx->cols, pMxSrc->entries, pMxSrc->rowStride, pMxSrc->colStride, pMx->entries, pMx->rowStride, pMx->colStride);
+	}
+
+	return pMx;
+}
+
+
+MATRIX matrix_initDims(int rows, int cols) {
+	return initMatrix(rows, cols, TRUE);
+}
+
+
+MATRIX matrix_initMove(MATRIX* phMxSrc) {
+	Matrix* pMx = *phMxSrc;
+	if (pMx)
+		*phMxSrc = NULL;
+	return pMx;
+}
+
+
+Status matrix_move(MATRIX* phMxDest, MATRIX* phMxSrc) {
+	// source matrix doesn't exist
+	if (!(*phMxSrc))
+		return FAILURE;
+
+	// source matrix exists
+	// destroy matrix in the destination handle if it exists in preparation for the move
+	matrix_destroy(phMxDest);
+
+	// move the source matrix into the destination handle
+	*phMxDest = *phMxSrc;
+
+	// remove ownership of the matrix from the source handle
+	*phMxSrc = NULL;
+
+	return SUCCESS;
+}
+
+
+Status matrix_newMatrix(MATRIX hMx, const double* entries, int rows, int cols) {
+	Matrix* pMx = hMx;
+	double* entriesResize;
+
+	// a view can't be resized because it doesn't own its entries
+	if (pMx->owner) {
+		if (pMx->rows != rows || pMx->cols != cols)
+			return FAILURE;
+	}
+	else {
+		// resize if the array can't hold the entries
+		if (pMx->capacity < getSize(rows, cols)) {
+			if (!(entriesResize = allocEntries(getSize(rows, cols), FALSE)))
+				return FAILURE;
+			releaseEntries(pMx);
+			pMx->entries = entriesResize;
+			pMx->capacity = getSize(rows, cols);
+		}
+
+		// sets rows and columns
+		pMx->rows = rows;
+		pMx->cols = cols;
+		pMx->rowStride = cols;
+	}
+
+	// copy the entries and mark the max length out of date
+	copyEntries(rows, cols, entries, cols, 1, pMx->entries, pMx->rowStride, pMx->colStride);
+	markDirty(pMx);
+
+	return SUCCESS;
+}
+
+
+Status matrix_opAdd(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes) {
+	Matrix* pMxToAdd = hMxs[0];                       // first matrix being added
+	Matrix* pMxRes;                                   // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+	const SimdKernels* pSimd = getSimdKernels();      // kernels for the instruction set in use
+
+
+	// recreate the result matrix if its dimensions aren't appropriate for the addition or it's NULL
+	if (!adjustMatrixDims((Matrix**)phMxRes, pMxToAdd->rows, pMxToAdd->cols, FALSE))
+		return FAILURE;
+	pMxRes = *phMxRes;
+
+
+	// perform the addition
+	return elemwise(hMxs, hMxsSize, pSimd->vecAdd, pMxRes);
+}
+
+
+double matrix_opDet(MATRIX hMx, Status* pMem) {
+	Matrix* pMx = hMx;
+	MatrixFactor fac;      // factorization of the matrix, in the scratch arena
+	size_t mark;
+	double det;
+	*pMem = SUCCESS;  // assume memory allocation failure won't happen
+
+	// the determinant of a 1 x 1 matrix is just the single number in the matrix
+	if (pMx->rows == 1 && pMx->cols == 1)
+		return pMx->entries[0];
+
+	// 2 x 2 matrix: no need to factor
+	if (pMx->rows == 2 && pMx->cols == 2) {
+		double a11 = pMx->entries[at(pMx, 0, 0)];
+		double a21 = pMx->entries[at(pMx, 0, 1)];
+		double a12 = pMx->entries[at(pMx, 1, 0)];
+		double a22 = pMx->entries[at(pMx, 1, 1)];
+		return opDet2x2(a11, a12, a21, a22);
+	}
+
+	// triangular matrix: the determinant is the product of the diagonal
+	if (getStructure(pMx) & (STRUCTURE_LOWER | STRUCTURE_UPPER)) {
+		det = 1;
+		for (int i = 0; i < pMx->rows; ++i)
+			det *= pMx->entries[at(pMx, i, i)];
+		return det;
+	}
+
+	// all other matrices - 3 x 3, 4 x 4 etc.
+	mark = scratchMark();
+	if (!factorizeScratch(pMx, &fac)) {
+		scratchRelease(mark);
+		*pMem = FAILURE;
+		return 0;
+	}
+	det = matrix_factorDet(&fac);
+	scratchRelease(mark);
+
+	return det;
+}
+
+
+Status matrix_opInv(MATRIX hMx, Boolean* pMxIsInvertible, MATRIX* phMxRes) {
+	Matrix* pMx = hMx;
+	MatrixFactor fac;      // factorization of the matrix, in the scratch arena
+	size_t mark;
+	Status status = FAILURE;
+
+
+	*pMxIsInvertible = FALSE;    // assume the matrix isn't invertible
+
+	// diagonal matrix: the inverse is the reciprocal of each entry of the diagonal, invertible if one of them is a zero pivot
+	// the entry is the only one in its row and column, so it is the scale of both like in the factorization
+	if ((getStructure(pMx) & STRUCTURE_DIAGONAL) == STRUCTURE_DIAGONAL) {
+		for (int i = 0; i < pMx->rows; ++i) {
+			double pivot = fabs(pMx->entries[at(pMx, i, i)]);
+			if (isPivotZero(pivot, pivot, pivot, pMx->rows)) {
+				*pMxIsInvertible = TRUE;
+				return FAILURE;
+			}
+		}
+		return opPowDiagonal(pMx, -1, (Matrix**)phMxRes);
+	}
+
+	// factor the matrix once and invert it from the factors
+	mark = scratchMark();
+	if (factorizeScratch(hMx, &fac))
+		status = matrix_factorInv(&fac, pMxIsInvertible, phMxRes);
+	scratchRelease(mark);
+
+	return status;
+}
+
+
+Status matrix_opMult(MATRIX hMx1, MATRIX hMx2, MATRIX* phMxRes) {
+	Matrix* pMx1 = hMx1;    // matrix 1 being multiplied
+	Matrix* pMx2 = hMx2;    // matrix 2 being multiplied
+	Matrix* pMxRes;         // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+	int structure1 = getStructure(pMx1);
+	int structure2 = getStructure(pMx2);
+
+
+	// recreate the result matrix if its dimensions aren't appropriate for the multiplication or it's NULL
+	if (!adjustMatrixDims((Matrix**)phMxRes, pMx1->rows, pMx2->cols, FALSE))
+		return FAILURE;
+	pMxRes = *phMxRes;
+
+	// a diagonal or permutation factor only scales or reorders the rows or columns of the other factor
+	if ((structure1 & STRUCTURE_DIAGONAL) == STRUCTURE_DIAGONAL)
+		multDiagonal(pMx1, pMx2, TRUE, pMxRes);
+	else if ((structure2 & STRUCTURE_DIAGONAL) == STRUCTURE_DIAGONAL)
+		multDiagonal(pMx2, pMx1, FALSE, pMxRes);
+	else if (structure1 & STRUCTURE_PERMUTATION)
+		multPermutation(pMx1, pMx2, TRUE, pMxRes);
+	else if (structure2 & STRUCTURE_PERMUTATION)
+		multPermutation(pMx2, pMx1, FALSE, pMxRes);
+
+	// perform the multiplication, reading and writing each matrix with its own strides so transposed views aren't copied first
+	else if (!matrix_internalGemmParallel(pMx1->rows, pMx2->cols, pMx1->cols, pMx1->entries, pMx1->rowStride, pMx1->colStride, pMx2->entries, pMx2->rowStride, pMx2->colStride,
+	                       pMxRes->entries, pMxRes->rowStride, pMxRes->colStride))
+		return FAILURE;
+
+	return SUCCESS;
+}
+
+
+Status matrix_opPow(MATRIX hMx, int power, MATRIX* phMxRes) {
+	Matrix* pMx = hMx;
+	Matrix* pMxRes;          // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+	double* scratch;         // one scratch allocation for the three buffers below
+	double* base;            // hMx raised to the power of 2 for the current bit of the power
+	double* prod = NULL;     // product of the bases for the bits of the power seen so far, NULL until the first set bit
+	double* spare;           // receives each product before it's swapped with base or prod
+	double* temp;
+	int n = pMx->rows;
+	size_t size = getSize(n, n);
+	size_t mark;
+
+
+	// special case: power = 1
+	if (power == 1)
+		return matrix_copy(phMxRes, hMx);
+
+	// special case: diagonal matrix, each entry of the diagonal is raised to the power on its own
+	if ((getStructure(pMx) & STRUCTURE_DIAGONAL) == STRUCTURE_DIAGONAL)
+		return opPowDiagonal(pMx, power, (Matrix**)phMxRes);
+
+	// all other cases: exponentiation by squaring, so only O(log power) multiplications
+	mark = scratchMark();
+	if (!(scratch = scratchAlloc(sizeof(*scratch) * 3 * size))) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+	base = scratch;
+	spare = scratch + size;
+	copyEntries(n, n, pMx->entries, pMx->rowStride, pMx->colStride, base, n, 1);
+	for (;;) {
+		if (power & 1) {
+			if (!prod) {
+				prod = scratch + 2 * size;
+				memcpy(prod, base, sizeof(*prod) * size);
+			}
+			else {
+				if (!matrix_internalGemmParallel(n, n, n, prod, n, 1, base, n, 1, spare, n, 1)) {
+					scratchRelease(mark);
+					return FAILURE;
+				}
+				temp = prod;
+				prod = spare;
+				spare = temp;
+			}
+		}
+		if (!(power >>= 1))
+			break;
+		if (!matrix_internalGemmParallel(n, n, n, base, n, 1, base, n, 1, spare, n, 1)) {
+			scratchRelease(mark);
+			return FAILURE;
+		}
+		temp = base;
+		base = spare;
+		spare = temp;
+	}
+
+	// store the result of the power operation
+	if (!adjustMatrixDims((Matrix**)phMxRes, n, n, FALSE)) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+	pMxRes = *phMxRes;
+	copyEntries(n, n, prod, n, 1, pMxRes->entries, pMxRes->rowStride, pMxRes->colStride);
+	scratchRelease(mark);
+
+	return SUCCESS;
+}
+
+
+Status matrix_opSolve(MATRIX hMxA, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX) {
+	MatrixFactor fac;      // factorization of A, in the scratch arena
+	size_t mark = scratchMark();
+	Status status = FAILURE;
+
+
+	*pMxIsInvertible = FALSE;    // assume A isn't invertible
+
+	// factor A once and solve for every column of B from the factors
+	if (factorizeScratch(hMxA, &fac))
+		status = matrix_factorSolve(&fac, hMxB, pMxIsInvertible, phMxX);
+	scratchRelease(mark);
+
+	return status;
+}
+
+
+Status matrix_opSub(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes) {
+	Matrix* pMxToSub = hMxs[0];                       // first matrix, the matrix being subtracted from
+	Matrix* pMxRes;                                   // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+	const SimdKernels* pSimd = getSimdKernels();      // kernels for the instruction set in use
+
+
+	// recreate the result matrix if its dimensions aren't appropriate for the subtraction or it's NULL
+	if (!adjustMatrixDims((Matrix**)phMxRes, pMxToSub->rows, pMxToSub->cols, FALSE))
+		return FAILURE;
+	pMxRes = *phMxRes;  // result of subtraction
+
+
+	// perform the subtraction
+	return elemwise(hMxs, hMxsSize, pSimd->vecSub, pMxRes);
+}
+
+
+Status matrix_opTrans(MATRIX hMx, MATRIX* phMxRes) {
+	Matrix* pMx = hMx;
+	Matrix* pMxRes;    // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+
+	// recreate the result matrix if its dimensions aren't appropriate for the transpose or it's NULL
+	if (!adjustMatrixDims((Matrix**)phMxRes, pMx->cols, pMx->rows, FALSE))
+		return FAILURE;
+	pMxRes = *phMxRes;
+
+	// calculate the transpose, which is a copy that reads the rows of the matrix as columns
+	copyEntries(pMx->cols, pMx->rows, pMx->entries, pMx->colStride, pMx->rowStride, pMxRes->entries, pMxRes->rowStride, pMxRes->colStride);
+	copyMaxLength(pMxRes, pMx);
+
+	return SUCCESS;
+}
+
+
+Status matrix_opTransInPlace(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	int temp;
+
+	// a view can't change shape, so only a square one can be transposed
+	if (pMx->owner) {
+		if (pMx->rows != pMx->cols)
+			return FAILURE;
+		transSquareInPlace(pMx->entries, pMx->rows, pMx->rowStride, pMx->colStride);
+		markDirty(pMx);
+		return SUCCESS;
+	}
+
+	// square: swap blocks across the diagonal
+	if (pMx->rows == pMx->cols)
+		transSquareInPlace(pMx->entries, pMx->rows, pMx->rows, 1);
+	// rectangular: follow the cycles of the permutation
+	else if (pMx->rows > 1 && pMx->cols > 1) {
+		if (!transCyclesInPlace(pMx->entries, pMx->rows, pMx->cols))
+			return FAILURE;
+	}
+	// a single row or column is already laid out like its transpose
+
+	temp = pMx->rows;
+	pMx->rows = pMx->cols;
+	pMx->cols = temp;
+	pMx->rowStride = pMx->cols;
+	markDirty(pMx);
+
+	return SUCCESS;
+}
+
+
+void matrix_print(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	char entryStr[500];    // buffer to hold each entry as a string
+	double entry;          // one entry in the matrix
+	int extraSpaces;       // count how many extra spaces to print for each entry
+	int spacesPerNum;      // each entry occupies the same fixed space                          
+	int totalSpaces;       // the total spaces horizontally the matrix takes up so it's known how many dashes to print
+	int maxLength;         // max width of a number in the matrix
+	
+
+	maxLength = getMaxLength(pMx);
+	spacesPerNum = maxLength + 2;
+	totalSpaces = spacesPerNum * pMx->cols + pMx->cols + 1;
+	
+	// print the matrix
+	// print top level of dashes
+	for (int i = 0; i < totalSpaces; ++i)
+		printf("-");
+	printf("\n");
+
+	for (int i = 0; i < pMx->rows; ++i) {
+		for (int j = 0; j < pMx->cols; ++j) {
+			entry = pMx->entries[at(hMx, i, j)];
+			sprintf(entryStr, "%f", entry);
+			removeTrailingZeroes(entryStr);
+			printf("|");
+			printf("%s", entryStr);
+			extraSpaces = maxLength - strlen(entryStr);
+
+			while (extraSpaces > 0) {
+				printf(" ");
+				--extraSpaces;
+			}
+			printf("  ");
+			if (j == pMx->cols - 1)
+				printf("|");
+		}
+		printf("\n");
+
+		// print level of dashes for each row
+		for (int i = 0; i < totalSpaces; ++i)
+			printf("-");
+		printf("\n");
+	}
+}
+
+
+void matrix_releaseCaches(void) {
+	pthread_mutex_lock(&scratchLock);
+	for (Scratch* pScr = scratchList; pScr; pScr = pScr->next)
+		scratchFreeBlocks(pScr);
+	pthread_mutex_unlock(&scratchLock);
+}
+
+
+Status matrix_reserve(MATRIX hMx, size_t capacity) {
+	Matrix* pMx = hMx;
+	double* entries;
+
+	// a view doesn't own its entries
+	if (pMx->owner)
+		return FAILURE;
+
+	// grow the array, keeping the entries, which moves inline entries out of the header
+	if (pMx->capacity < capacity) {
+		if (pMx->entries == pMx->inlineEntries) {
+			if (!(entries = allocEntries(capacity, FALSE)))
+				return FAILURE;
+			memcpy(entries, pMx->entries, sizeof(*entries) * pMx->capacity);
+		}
+		else if (!(entries = reallocEntries(pMx->entries, pMx->capacity, capacity)))
+			return FAILURE;
+		pMx->entries = entries;
+		pMx->capacity = capacity;
+	}
+
+	return SUCCESS;
+}
+
+
+Status matrix_setAllocator(MatrixAllocFn allocFn, MatrixReallocFn reallocFn, MatrixFreeFn freeFn, void* userdata) {
+	Boolean warm;
+
+	if (!allocFn != !freeFn)
+		return FAILURE;
+
+	// the memory the threads keep came from the current allocator, and the workers are restarted so any that warm their arenas do it again with the new one
+	pthread_mutex_lock(&scratchLock);
+	warm = scratchWarmBytes > 0;
+	pthread_mutex_unlock(&scratchLock);
+	threadPool_setWorkerStart(warm ? scratchWarm : NULL);
+	matrix_releaseCaches();
+
+	allocator.allocFn = allocFn;
+	allocator.reallocFn = allocFn ? reallocFn : NULL;
+	allocator.freeFn = freeFn;
+	allocator.userdata = userdata;
+	return SUCCESS;
+}
+
+
+Status matrix_setEntry(MATRIX hMx, int row, int col, double entry) {
+	Matrix* pMx = hMx;
+	ptrdiff_t idx;
+
+	idx = at(hMx, row, col);
+	if (idx != -1) {
+		pMx->entries[idx] = entry;
+		markDirty(pMx);
+		return SUCCESS;
+	}
+	else
+		return FAILURE;
+}
+
+
+Status matrix_setNumThreads(int numThreads) {
+	return threadPool_setNumThreads(numThreads);
+}
+
+
+Status matrix_setSimdLevel(SimdLevel level) {
+	if (level < SIMD_SCALAR || level > cpuSimdLevel())
+		return FAILURE;
+	pthread_once(&simdKernelsOnce, initSimdKernels);
+	pSimdKernels = &simdKernelsTable[level];
+	return SUCCESS;
+}
+
+
+
+
+Status matrix_shrinkToFit(MATRIX hMx) {
+	Matrix* pMx = hMx;
+	double* entries;
+	size_t size;
+
+	// a view doesn't own its entries
+	if (pMx->owner)
+		return FAILURE;
+
+	// move the entries back into the header if they fit there
+	size = getSize(pMx->rows, pMx->cols);
+	if (pMx->entries != pMx->inlineEntries && size <= poolClassSizes[pMx->sizeClass]) {
+		memcpy(pMx->inlineEntries, pMx->entries, sizeof(*entries) * size);
+		freeEntries(pMx->entries, pMx->capacity);
+		pMx->entries = pMx->inlineEntries;
+		pMx->capacity = poolClassSizes[pMx->sizeClass];
+	}
+
+	// shrink the array to the entries of the matrix, inline entries already take no memory of their own
+	else if (pMx->entries != pMx->inlineEntries && pMx->capacity > size) {
+		if (!(entries = reallocEntries(pMx->entries, pMx->capacity, size)))
+			return FAILURE;
+		pMx->entries = entries;
+		pMx->capacity = size;
+	}
+
+	return SUCCESS;
+}
+
+
+MATRIX matrix_view(MATRIX hMx, int rowStart, int rowCount, int colStart, int colCount) {
+	Matrix* pMxSrc = hMx;
+	Matrix* pMx;
+
+	// the block must be inside the matrix
+	if (rowStart < 0 || rowCount < 1 || rowCount > pMxSrc->rows - rowStart || colStart < 0 || colCount < 1 || colCount > pMxSrc->cols - colStart)
+		return NULL;
+
+	pMx = allocMatrix(0);
+	if (pMx) {
+		// the entries are shared starting from the first entry of the block, and the strides skip the rest of each row and column
+		pMx->entries = pMxSrc->entries + at(pMxSrc, rowStart, colStart);
+		pMx->rows = rowCount;
+		pMx->cols = colCount;
+		pMx->rowStride = pMxSrc->rowStride;
+		pMx->colStride = pMxSrc->colStride;
+		pMx->owner = pMxSrc->owner ? pMxSrc->owner : pMxSrc;
+		pMx->capacity = 0;
+		pMx->maxLength = 1;
+		pMx->maxLengthIsDirty = TRUE;
+		pMx->structure = 0;
+		pMx->structureIsDirty = TRUE;
+	}
+
+	return pMx;
+}
+
+
+MATRIX matrix_viewTrans(MATRIX hMx) {
+	Matrix* pMxSrc = hMx;
+
+	Matrix* pMx = allocMatrix(0);
+	if (pMx) {
+		// the entries are shared and the strides are swapped, so entry (i, j) of the view is entry (j, i) of the source
+		pMx->entries = pMxSrc->entries;
+		pMx->rows = pMxSrc->cols;
+		pMx->cols = pMxSrc->rows;
+		pMx->rowStride = pMxSrc->colStride;
+		pMx->colStride = pMxSrc->rowStride;
+		pMx->owner = pMxSrc->owner ? pMxSrc->owner : pMxSrc;
+		pMx->capacity = 0;
+		pMx->maxLength = 1;
+		pMx->maxLengthIsDirty = TRUE;
+		pMx->structure = 0;
+		pMx->structureIsDirty = TRUE;
+	}
+
+	return pMx;
+}
+
+
+
+
+/********** Definitions for internal functions declared in MatrixInternal.h **********/
+Status matrix_internalAdjustDims(MATRIX* phMx, int rows, int cols, Boolean zero) {
+	return adjustMatrixDims((Matrix**)phMx, rows, cols, zero);
+}
+
+
+Status matrix_internalGemmParallel(int m, int n, int k, const double* a, ptrdiff_t rsa, ptrdiff_t csa, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* c, ptrdiff_t rsc, ptrdiff_t csc) {
+	GemmJob job = { m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, csc, 0, 0, 0 };
+	int numThreads = threadPool_getNumThreads();
+	int rowSlivers = (m + GEMM_MR - 1) / GEMM_MR;    // register tiles down a column of C
+	int colSlivers = (n + GEMM_NR - 1) / GEMM_NR;    // register tiles across a row of C
+	int numTiles, gridRows, gridCols;
+	size_t warmBytes;                                // block the workers need for the packing buffers of a tile
+	Boolean restart = FALSE;
+
+
+	if (numThreads == 1 || (double)m * n * k < GEMM_PARALLEL_MIN_WORK)
+		return gemm(m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, csc);
+
+	// split C into a grid of tiles with the same aspect ratio as C so each tile packs as little of A and B as possible
+	numTiles = numThreads * GEMM_TILES_PER_THREAD;
+	gridRows = (int)round(sqrt((double)numTiles * m / n));
+	if (gridRows < 1)
+		gridRows = 1;
+	else if (gridRows > rowSlivers)
+		gridRows = rowSlivers;
+	gridCols = (numTiles + gridRows - 1) / gridRows;
+	if (gridCols > colSlivers)
+		gridCols = colSlivers;
+
+	// round the tiles to whole register tiles and drop any grid rows or columns that end up empty
+	job.tileRows = (rowSlivers + gridRows - 1) / gridRows * GEMM_MR;
+	job.tileCols = (colSlivers + gridCols - 1) / gridCols * GEMM_NR;
+	gridRows = (m + job.tileRows - 1) / job.tileRows;
+	job.gridCols = (n + job.tileCols - 1) / job.tileCols;
+
+	// the workers warm their arenas for the largest tile split across them so far, so one that takes its first tile late doesn't allocate then
+	// the size is rounded up to a power of 2 so the workers are only restarted a few times as the products grow
+	warmBytes = gemmScratchBytes(job.tileRows, job.tileCols, k);
+	pthread_mutex_lock(&scratchLock);
+	if (warmBytes > scratchWarmBytes) {
+		size_t size = SCRATCH_MIN_BYTES;
+		while (size < warmBytes)
+			size *= 2;
+		scratchWarmBytes = (size < GEMM_SCRATCH_BYTES) ? size : GEMM_SCRATCH_BYTES;
+		restart = TRUE;
+	}
+	pthread_mutex_unlock(&scratchLock);
+	if (restart)
+		threadPool_setWorkerStart(scratchWarm);
+
+	return threadPool_run(gemmTask, &job, gridRows * job.gridCols);
+}
+
+
+double* matrix_internalGetEntries(MATRIX hMx, ptrdiff_t* pRowStride, ptrdiff_t* pColStride) {
+	Matrix* pMx = hMx;
+	*pRowStride = pMx->rowStride;
+	*pColStride = pMx->colStride;
+	return pMx->entries;
+}
+
+
+void* matrix_internalScratchAlloc(size_t bytes) {
+	return scratchAlloc(bytes);
 }
 
 
-Status matrix_getEntry(MATRIX hMx, int row, int col, double* pEntry) {
-	Matrix* pMx = hMx;
-	int idx;
+size_t matrix_internalScratchMark(void) {
+	return scratchMark();
+}
 
-	idx = at(hMx, row, col);
-	if (idx != -1) {
-		*pEntry = pMx->entries[idx];
-		return SUCCESS;
+
+void matrix_internalScratchRelease(size_t mark) {
+	scratchRelease(mark);
+}
+
+
+
+
+/********** Helper function definitions **********/
+static Status adjustMatrixDims(Matrix** ppMx, int rows, int cols, Boolean zero) {
+	Matrix* pMx = *ppMx;
+	double* entries;
+
+
+	// matrix doesn't exist
+	if (!(*ppMx)) {
+		if (!(*ppMx = initMatrix(rows, cols, zero)))
+			return FAILURE;
+	}
+	// matrix is a view, it can't be resized because it doesn't own its entries
+	else if (pMx->owner) {
+		if (pMx->rows != rows || pMx->cols != cols)
+			return FAILURE;
+		for (int i = 0; zero && i < rows; ++i) {
+			for (int j = 0; j < cols; ++j)
+				pMx->entries[at(pMx, i, j)] = 0;
+		}
 	}
+	// matrix exists
 	else {
-		*pEntry = 0;
-		return FAILURE;
+		// needs resizing, the array can't hold the entries
+		if (pMx->capacity < getSize(rows, cols)) {
+			if (!(entries = allocEntries(getSize(rows, cols), zero)))
+				return FAILURE;
+			releaseEntries(pMx);
+			pMx->entries = entries;
+			pMx->capacity = getSize(rows, cols);
+		}
+		else if (zero) // doesn't need resizing, 0 out new entries
+			memset(pMx->entries, 0, sizeof(*(pMx->entries)) * getSize(rows, cols));
+
+		// in either case, set the new rows and columns
+		pMx->rows = rows;
+		pMx->cols = cols;
+		pMx->rowStride = cols;
 	}
-}
 
+	// the caller fills in the entries, so the max length is recalculated when it's needed
+	markDirty(*ppMx);
 
-MATRIX matrix_initCopy(MATRIX hMxSrc) {
-	Matrix* pMxSrc = hMxSrc;
+	return SUCCESS;
+}
 
-	Matrix* pMx = malloc(sizeof(*pMx));
-	if (pMx) {
-		int srcSize = getSize(pMxSrc->rows, pMxSrc->cols);
-		if (!(pMx->entries = calloc(srcSize, sizeof(*(pMx->entries))))) {
-			free(pMx);
+
+static double* allocEntries(size_t count, Boolean zero) {
+	size_t bytes = ((size_t)count * sizeof(double) + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN;    // aligned_alloc needs a multiple of the alignment
+	double* entries;
+#ifdef ENTRIES_MMAP
+	char* map;
+	size_t head;    // bytes of the mapping before its first huge page boundary
+
+	// map one huge page more than needed so the array can start on a huge page boundary, then unmap the parts before and after it
+	if (!allocator.allocFn && bytes >= ENTRIES_HUGE_PAGE_MIN_BYTES) {
+		bytes = (bytes + ENTRIES_HUGE_PAGE - 1) / ENTRIES_HUGE_PAGE * ENTRIES_HUGE_PAGE;
+		map = mmap(NULL, bytes + ENTRIES_HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (map == MAP_FAILED)
 			return NULL;
-		}
-		pMx->rows = pMxSrc->rows;
-		pMx->cols = pMxSrc->cols;
-		pMx->maxLength = pMxSrc->maxLength;
-		for (int i = 0; i < srcSize; ++i)
-			pMx->entries[i] = pMxSrc->entries[i];
+		head = (ENTRIES_HUGE_PAGE - (uintptr_t)map % ENTRIES_HUGE_PAGE) % ENTRIES_HUGE_PAGE;
+		if (head)
+			munmap(map, head);
+		munmap(map + head + bytes, ENTRIES_HUGE_PAGE - head);
+#ifdef MADV_HUGEPAGE
+		madvise(map + head, bytes, MADV_HUGEPAGE);
+#endif
+		// anonymous mappings are already zeroed
+		return (double*)(map + head);
 	}
+#endif
 
-	return pMx;
+	if ((entries = allocator.allocFn ? allocator.allocFn(bytes, ENTRIES_ALIGN, allocator.userdata) : aligned_alloc(ENTRIES_ALIGN, bytes)) && zero)
+		memset(entries, 0, bytes);
+
+	return entries;
 }
 
 
-MATRIX matrix_initDims(int rows, int cols) {
-	Matrix* pMx = malloc(sizeof(*pMx));
-	if (pMx) {
-		if (!(pMx->entries = calloc(getSize(rows, cols), sizeof(*(pMx->entries))))) {
-			free(pMx);
-			return NULL;
-		}
-		pMx->rows = rows;
-		pMx->cols = cols;
-		pMx->maxLength = 1;
+static Matrix* allocMatrix(size_t size) {
+	Scratch* pScr = getScratch();
+	Matrix* pMx;
+	int sizeClass = 0;
+
+	for (int i = 1; !sizeClass && i < POOL_CLASSES; ++i) {
+		if (size <= poolClassSizes[i])
+			sizeClass = i;
+	}
+
+	if (pScr && (pMx = pScr->freeMatrices[sizeClass])) {
+		pScr->freeMatrices[sizeClass] = pMx->owner;
+		--pScr->numFreeMatrices[sizeClass];
 	}
+	// the header is allocated like an array of entries so the inline entries after it are aligned like any other array
+	else if (!(pMx = (Matrix*)allocEntries(headerCount(sizeClass), FALSE)))
+		return NULL;
+	pMx->sizeClass = sizeClass;
 
 	return pMx;
 }
 
 
-MATRIX matrix_initMove(MATRIX* phMxSrc) {
-	Matrix* pMx = *phMxSrc;
-	if (pMx)
-		*phMxSrc = NULL;
-	return pMx;
+static ptrdiff_t at(Matrix* pMx, int row, int col) {
+	return (row >= pMx->rows || col >= pMx->cols) ? -1 : (row * pMx->rowStride + col * pMx->colStride);
 }
 
 
-Status matrix_move(MATRIX* phMxDest, MATRIX* phMxSrc) {
-	// source matrix doesn't exist
-	if (!(*phMxSrc))
-		return FAILURE;
+ptrdiff_t at2(int rows, int cols, int row, int col) {
+	return (row >= rows || col >= cols) ? -1 : (ptrdiff_t)row * cols + col;
+}
 
-	// source matrix exists
-	// destroy matrix in the destination handle if it exists in preparation for the move
-	matrix_destroy(phMxDest);
 
-	// move the source matrix into the destination handle
-	*phMxDest = *phMxSrc;
+static int calcEntryLength(double entry) {
+	char entryStr[100];    // string representation of entry
+	int entryInt;          // integer part of entry
+	int length;
 
-	// remove ownership of the matrix from the source handle
-	*phMxSrc = NULL;
+	// if entry is equivalent to an integer (i.e. 2.0) its length is just the integer part
+	entryInt = (int)floor(entry);
+	if (entryInt == entry) {
+		sprintf(entryStr, "%d", entryInt);
+		length =  strlen(entryStr);
+	}
+	// entry isn't equivalent to an integer, must get characters after decimal part, exclude trailing 0s
+	else {
+		sprintf(entryStr, "%f", entry);
+		length = strlen(entryStr);
+		for (int i = strlen(entryStr) - 1; entryStr[i] == '0' || entryStr[i] == '.'; --i)
+			--length;
+	}
 
-	return SUCCESS;
+	return length;
 }
 
 
-Status matrix_newMatrix(MATRIX hMx, const double* entries, int rows, int cols) {
-	Matrix* pMx = hMx;
-	int maxLength = 1;     // max length of the numbers found
-	int numLength;         // length of a single number
-	double* entriesResize;
+static void copyEntries(int rows, int cols, const double* src, ptrdiff_t rss, ptrdiff_t css, double* dst, ptrdiff_t rsd, ptrdiff_t csd) {
+	// both row-major: copy whole rows, or everything at once if neither has gaps between rows
+	if (css == 1 && csd == 1) {
+		if ((rss == cols && rsd == cols) || rows == 1)
+			memcpy(dst, src, sizeof(*dst) * getSize(rows, cols));
+		else {
+			for (int i = 0; i < rows; ++i)
+				memcpy(dst + i * rsd, src + i * rss, sizeof(*dst) * cols);
+		}
+	}
+	// one column-major and the other row-major: a transpose of the column-major side
+	else if (rss == 1 && csd == 1)
+		transRecursive(src, css, dst, rsd, cols, rows, getSimdKernels()->transBlock);
+	else if (css == 1 && rsd == 1)
+		transRecursive(src, rss, dst, csd, rows, cols, getSimdKernels()->transBlock);
+	// both column-major: copy whole columns
+	else if (rss == 1 && rsd == 1) {
+		for (int j = 0; j < cols; ++j)
+			memcpy(dst + j * csd, src + j * css, sizeof(*dst) * rows);
+	}
+	else {
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < cols; ++j)
+				dst[i * rsd + j * csd] = src[i * rss + j * css];
+		}
+	}
+}
 
-	// resize if necessary
-	if (getSize(pMx->rows, pMx->cols) < getSize(rows, cols)) {
-		if (!(entriesResize = malloc(sizeof(*entries) * getSize(rows, cols))))
-			return FAILURE;
-		free(pMx->entries);
-		pMx->entries = entriesResize;
+
+static void copyMaxLength(Matrix* pMxDest, const Matrix* pMxSrc) {
+	if (!pMxDest->owner && !pMxSrc->owner) {
+		pMxDest->maxLength = pMxSrc->maxLength;
+		pMxDest->maxLengthIsDirty = pMxSrc->maxLengthIsDirty;
+	}
+	else
+		markDirty(pMxDest);
+}
+
+
+static void copyStructure(Matrix* pMxDest, const Matrix* pMxSrc) {
+	if (!pMxDest->owner && !pMxSrc->owner) {
+		pMxDest->structure = pMxSrc->structure;
+		pMxDest->structureIsDirty = pMxSrc->structureIsDirty;
 	}
+	else
+		markDirty(pMxDest);
+}
 
-	// copy the entries
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-			pMx->entries[at(pMx, i, j)] = entries[at2(rows, cols, i, j)];
-			numLength = calcEntryLength(entries[at2(rows, cols, i, j)]);
-			if (i == 0 && j == 0)
-				maxLength = numLength;
-			else if (numLength > maxLength)
-				maxLength = numLength;
+
+static SimdLevel cpuSimdLevel(void) {
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SIMD_SSE2;
+#endif
+	return SIMD_SCALAR;
+}
+
+
+static Status elemwise(MATRIX* hMxs, int hMxsSize, void (*op)(int n, const double* x, const double* y, double* z), Matrix* pMxRes) {
+	ptrdiff_t size = getSize(pMxRes->rows, pMxRes->cols);
+	ElemwiseJob job = { hMxs, hMxsSize, op, pMxRes, size, size, 0, 0 };
+	Boolean contiguous = isContiguous(pMxRes);    // every operand is contiguous
+	int numTasks = 1;
+	ptrdiff_t numChunks;
+
+	for (int i = 0; i < hMxsSize; ++i)
+		contiguous = contiguous && isContiguous(hMxs[i]);
+
+	if (contiguous) {
+		// split large results into ranges of whole chunks for the thread pool
+		if (size >= ELEMWISE_PARALLEL_MIN_SIZE) {
+			numChunks = (size + ELEMWISE_CHUNK - 1) / ELEMWISE_CHUNK;
+			numTasks = threadPool_getNumThreads() * ELEMWISE_TASKS_PER_THREAD;
+			job.taskSize = (numChunks + numTasks - 1) / numTasks * ELEMWISE_CHUNK;
+			numTasks = (size + job.taskSize - 1) / job.taskSize;
+		}
+		return threadPool_run(elemwiseTask, &job, numTasks);
+	}
+	else {
+		// narrow matrices get taller tiles so every tile has about ELEMWISE_TILE entries, and large results are split into bands of whole tiles
+		job.tileCols = (pMxRes->cols < ELEMWISE_TILE_COLS) ? pMxRes->cols : ELEMWISE_TILE_COLS;
+		job.tileRows = ELEMWISE_TILE / job.tileCols;
+		job.taskSize = pMxRes->rows;
+		if (size >= ELEMWISE_PARALLEL_MIN_SIZE) {
+			numChunks = (pMxRes->rows + job.tileRows - 1) / job.tileRows;
+			numTasks = threadPool_getNumThreads() * ELEMWISE_TASKS_PER_THREAD;
+			job.taskSize = (numChunks + numTasks - 1) / numTasks * job.tileRows;
+			numTasks = (pMxRes->rows + job.taskSize - 1) / job.taskSize;
 		}
+		return threadPool_run(elemwiseTileTask, &job, numTasks);
 	}
+}
+
 
-	// sets rows, columns, and max length
-	pMx->rows = rows;
-	pMx->cols = cols;
-	pMx->maxLength = maxLength;
+static Status elemwiseTask(void* arg, int taskIdx) {
+	ElemwiseJob* pJob = arg;
+	ptrdiff_t start = taskIdx * pJob->taskSize;                                                    // first entry of the range
+	ptrdiff_t end = (pJob->size - start < pJob->taskSize) ? pJob->size : start + pJob->taskSize;    // entry after the range
+	double* res;
+	int n;
+
+	for (ptrdiff_t chunk = start; chunk < end; chunk += ELEMWISE_CHUNK) {
+		n = (end - chunk < ELEMWISE_CHUNK) ? end - chunk : ELEMWISE_CHUNK;
+		res = pJob->pMxRes->entries + chunk;
+		if (pJob->hMxsSize == 1)
+			memcpy(res, ((Matrix*)pJob->hMxs[0])->entries + chunk, sizeof(*res) * n);
+		else {
+			pJob->op(n, ((Matrix*)pJob->hMxs[0])->entries + chunk, ((Matrix*)pJob->hMxs[1])->entries + chunk, res);
+			for (int i = 2; i < pJob->hMxsSize; ++i)
+				pJob->op(n, res, ((Matrix*)pJob->hMxs[i])->entries + chunk, res);
+		}
+	}
 
 	return SUCCESS;
 }
 
 
-Status matrix_opAdd(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes) {
-	Matrix* pMxToAdd = hMxs[0];        // first matrix being added
-	Matrix* pMxRes;                    // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
-	double sum = 0;                    // sum for each new individual term
-	int maxLength = 1;                 // max length of the new matrix (same as in the matrix structure)
-	int numLength;                     // gets the length of each number to be compared to max length
-	Boolean isFirstNewEntry = TRUE;    // indicates if the first number being calculated in the whole result matrix
-	
+static Status elemwiseTileTask(void* arg, int taskIdx) {
+	ElemwiseJob* pJob = arg;
+	Matrix* pMxRes = pJob->pMxRes;
+	Matrix* pMx;
+	double* res;     // tile of the result
+	double* term;    // tile of the term being combined with it
+	int start = taskIdx * pJob->taskSize;                                                                    // first row of the band
+	int end = (pMxRes->rows - start < pJob->taskSize) ? pMxRes->rows : start + pJob->taskSize;    // row after the band
+	int rows, cols;
+	size_t mark = scratchMark();
 
-	// recreate the result matrix if its dimensions aren't appropriate for the addition or it's NULL
-	if (!adjustMatrixDims((Matrix**)phMxRes, pMxToAdd->rows, pMxToAdd->cols))
+	if (!(res = scratchAlloc(sizeof(*res) * 2 * ELEMWISE_TILE))) {
+		scratchRelease(mark);
 		return FAILURE;
-	pMxRes = *phMxRes;
+	}
+	term = res + ELEMWISE_TILE;
+
+	for (int i = start; i < end; i += pJob->tileRows) {
+		rows = (end - i < pJob->tileRows) ? end - i : pJob->tileRows;
+		for (int j = 0; j < pMxRes->cols; j += pJob->tileCols) {
+			cols = (pMxRes->cols - j < pJob->tileCols) ? pMxRes->cols - j : pJob->tileCols;
+
+			// the tiles are copied into the buffers with cols entries per row so the kernels see contiguous arrays
+			pMx = pJob->hMxs[0];
+			copyEntries(rows, cols, pMx->entries + at(pMx, i, j), pMx->rowStride, pMx->colStride, res, cols, 1);
+			for (int k = 1; k < pJob->hMxsSize; ++k) {
+				pMx = pJob->hMxs[k];
+				copyEntries(rows, cols, pMx->entries + at(pMx, i, j), pMx->rowStride, pMx->colStride, term, cols, 1);
+				pJob->op(rows * cols, res, term, res);
+			}
+			copyEntries(rows, cols, res, cols, 1, pMxRes->entries + at(pMxRes, i, j), pMxRes->rowStride, pMxRes->colStride);
+		}
+	}
+	scratchRelease(mark);
 
+	return SUCCESS;
+}
 
-	// perform the addition
-	// outer 2 loops for result matrix
-	for (int resRow = 0; resRow < pMxToAdd->rows; ++resRow) {
-		for (int resCol = 0; resCol < pMxToAdd->cols; ++resCol) {
-			// inner loop to get the sum
-			sum = 0;
-			for (int i = 0; i < hMxsSize; ++i) {
-				pMxToAdd = hMxs[i];
-				sum += pMxToAdd->entries[at(pMxToAdd, resRow, resCol)];
+
+static Status factorizeScratch(Matrix* pMx, MatrixFactor* pFac) {
+	int n = pMx->rows;
+
+	// the column and row maxima needed during the factorization are kept after the factors
+	if (!(pFac->lu = scratchAlloc(sizeof(*(pFac->lu)) * (getSize(n, n) + 2 * n))) || !(pFac->piv = scratchAlloc(sizeof(*(pFac->piv)) * n)))
+		return FAILURE;
+	pFac->n = n;
+	copyEntries(n, n, pMx->entries, pMx->rowStride, pMx->colStride, pFac->lu, n, 1);
+	pFac->sign = luDecompose(pFac->lu, n, pFac->piv, pFac->lu + getSize(n, n));
+
+	return SUCCESS;
+}
+
+
+static int findStructure(Matrix* pMx) {
+	int n = pMx->rows;
+	int structure = STRUCTURE_DIAGONAL | STRUCTURE_PERMUTATION;
+	int rowOnes;           // entries of the current row that aren't 0
+	Boolean* colTaken;     // whether a row before has its 1 in each column
+	double entry;
+	size_t mark;
+	int k;
+
+	if (pMx->rows != pMx->cols)
+		return 0;
+
+	// read the rows until every shape is ruled out, a permutation needs a single 1 in each of them
+	for (int i = 0; structure && i < n; ++i) {
+		rowOnes = 0;
+		for (int j = 0; structure && j < n; ++j) {
+			entry = pMx->entries[at(pMx, i, j)];
+			if (entry != 0) {
+				if (j > i)
+					structure &= ~STRUCTURE_LOWER;
+				else if (j < i)
+					structure &= ~STRUCTURE_UPPER;
+				if (entry != 1 || ++rowOnes > 1)
+					structure &= ~STRUCTURE_PERMUTATION;
 			}
-			numLength = calcEntryLength(sum);
-			if (isFirstNewEntry) {
-				maxLength = numLength;
-				isFirstNewEntry = FALSE;
+		}
+		if (rowOnes != 1)
+			structure &= ~STRUCTURE_PERMUTATION;
+	}
+
+	// a single 1 in every row is a permutation only if no two rows have it in the same column, read by rows again rather than by columns
+	if (structure & STRUCTURE_PERMUTATION) {
+		mark = scratchMark();
+		if (!(colTaken = scratchAlloc(sizeof(*colTaken) * n)))
+			structure &= ~STRUCTURE_PERMUTATION;
+		else
+			memset(colTaken, 0, sizeof(*colTaken) * n);
+		for (int i = 0; (structure & STRUCTURE_PERMUTATION) && i < n; ++i) {
+			for (k = 0; pMx->entries[at(pMx, i, k)] == 0; ++k)
+				;
+			if (colTaken[k])
+				structure &= ~STRUCTURE_PERMUTATION;
+			colTaken[k] = TRUE;
+		}
+		scratchRelease(mark);
+	}
+
+	return structure;
+}
+
+
+static void freeEntries(double* entries, size_t count) {
+#ifdef ENTRIES_MMAP
+	size_t bytes = ((size_t)count * sizeof(double) + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN;
+
+	// same test as allocEntries
+	if (!allocator.allocFn && bytes >= ENTRIES_HUGE_PAGE_MIN_BYTES) {
+		if (entries)
+			munmap(entries, (bytes + ENTRIES_HUGE_PAGE - 1) / ENTRIES_HUGE_PAGE * ENTRIES_HUGE_PAGE);
+		return;
+	}
+#else
+	(void)count;
+#endif
+
+	matrix_free(entries);
+}
+
+
+static void freeMatrix(Matrix* pMx) {
+	Scratch* pScr = getScratch();
+
+	if (pScr && pScr->numFreeMatrices[pMx->sizeClass] < POOL_MAX_FREE) {
+		pMx->owner = pScr->freeMatrices[pMx->sizeClass];
+		pScr->freeMatrices[pMx->sizeClass] = pMx;
+		++pScr->numFreeMatrices[pMx->sizeClass];
+	}
+	else
+		freeEntries((double*)pMx, headerCount(pMx->sizeClass));
+}
+
+
+static Status gemm(int m, int n, int k, const double* a, ptrdiff_t rsa, ptrdiff_t csa, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* c, ptrdiff_t rsc, ptrdiff_t csc) {
+	double* packedA;                         // packed block of A
+	double* packedB;                         // packed panel of B
+	double ab[GEMM_MR * GEMM_NR];            // product of one register tile
+	int mcMax;                               // rows of the largest block of A
+	int kcMax;                               // depth of the largest panels
+	int ncMax;                               // columns of the largest panel of B
+	size_t mark = scratchMark();
+	void (*microKernel)(int, const double* restrict, const double* restrict, double* restrict) = getSimdKernels()->gemmMicroKernel;
+
+
+	// size the packing buffers for the largest blocks this product needs so small products take little of the scratch arena, as gemmScratchBytes does
+	mcMax = (m < GEMM_MC) ? (m + GEMM_MR - 1) / GEMM_MR * GEMM_MR : GEMM_MC;
+	kcMax = (k < GEMM_KC) ? k : GEMM_KC;
+	ncMax = (n < GEMM_NC) ? (n + GEMM_NR - 1) / GEMM_NR * GEMM_NR : GEMM_NC;
+	if (!(packedA = scratchAlloc(sizeof(*packedA) * mcMax * kcMax)) || !(packedB = scratchAlloc(sizeof(*packedB) * kcMax * ncMax))) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+
+	for (int jc = 0; jc < n; jc += GEMM_NC) {
+		int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+		for (int pc = 0; pc < k; pc += GEMM_KC) {
+			int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+			gemmPackB(kc, nc, b + pc * rsb + jc * csb, rsb, csb, packedB);
+			for (int ic = 0; ic < m; ic += GEMM_MC) {
+				int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+				gemmPackA(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA);
+				for (int jr = 0; jr < nc; jr += GEMM_NR) {
+					int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+					for (int ir = 0; ir < mc; ir += GEMM_MR) {
+						int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+						double* cTile = c + (ic + ir) * rsc + (jc + jr) * csc;
+
+						microKernel(kc, packedA + ir * kc, packedB + jr * kc, ab);
+
+						// the first panel of the depth overwrites C, the rest accumulate into it
+						for (int i = 0; i < mr; ++i) {
+							if (pc == 0) {
+								for (int j = 0; j < nr; ++j)
+									cTile[i * rsc + j * csc] = ab[i * GEMM_NR + j];
+							}
+							else {
+								for (int j = 0; j < nr; ++j)
+									cTile[i * rsc + j * csc] += ab[i * GEMM_NR + j];
+							}
+						}
+					}
+				}
 			}
-			else if (numLength > maxLength)
-				maxLength = numLength;
-			pMxRes->entries[at(pMxRes, resRow, resCol)] = sum;
 		}
 	}
-	pMxRes->maxLength = maxLength;
 
+	scratchRelease(mark);
 	return SUCCESS;
 }
 
 
-double matrix_opDet(MATRIX hMx, Status* pMem) {
-	Matrix* pMx = hMx;
-	*pMem = SUCCESS;  // assume memory allocation failure won't happen
+static void gemmMicroKernel(int kc, const double* restrict a, const double* restrict b, double* restrict ab) {
+	double acc[GEMM_MR][GEMM_NR] = { { 0 } };    // tile accumulated in registers
+
+	for (int p = 0; p < kc; ++p, a += GEMM_MR, b += GEMM_NR) {
+		for (int i = 0; i < GEMM_MR; ++i) {
+			double aip = a[i];
+			for (int j = 0; j < GEMM_NR; ++j)
+				acc[i][j] += aip * b[j];
+		}
+	}
+
+	for (int i = 0; i < GEMM_MR; ++i) {
+		for (int j = 0; j < GEMM_NR; ++j)
+			ab[i * GEMM_NR + j] = acc[i][j];
+	}
+}
+
+
+#ifdef SIMD_X86
+#if GEMM_MR != 4 || GEMM_NR != 8
+#error "The SIMD micro-kernels are written for a 4 x 8 register tile"
+#endif
+
+__attribute__((target("sse2")))
+static void gemmMicroKernelSse2(int kc, const double* restrict a, const double* restrict b, double* restrict ab) {
+	// 16 registers can't hold the whole tile plus operands, so compute the left and right halves in two passes over the slivers
+	for (int half = 0; half < GEMM_NR; half += 4) {
+		__m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+		__m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+		__m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+		__m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+		const double* pa = a;
+		const double* pb = b + half;
+
+		for (int p = 0; p < kc; ++p, pa += GEMM_MR, pb += GEMM_NR) {
+			__m128d b0 = _mm_loadu_pd(pb);
+			__m128d b1 = _mm_loadu_pd(pb + 2);
+			__m128d ai;
+
+			ai = _mm_set1_pd(pa[0]);
+			c00 = _mm_add_pd(c00, _mm_mul_pd(ai, b0));
+			c01 = _mm_add_pd(c01, _mm_mul_pd(ai, b1));
+			ai = _mm_set1_pd(pa[1]);
+			c10 = _mm_add_pd(c10, _mm_mul_pd(ai, b0));
+			c11 = _mm_add_pd(c11, _mm_mul_pd(ai, b1));
+			ai = _mm_set1_pd(pa[2]);
+			c20 = _mm_add_pd(c20, _mm_mul_pd(ai, b0));
+			c21 = _mm_add_pd(c21, _mm_mul_pd(ai, b1));
+			ai = _mm_set1_pd(pa[3]);
+			c30 = _mm_add_pd(c30, _mm_mul_pd(ai, b0));
+			c31 = _mm_add_pd(c31, _mm_mul_pd(ai, b1));
+		}
+
+		_mm_storeu_pd(ab + 0 * GEMM_NR + half, c00);
+		_mm_storeu_pd(ab + 0 * GEMM_NR + half + 2, c01);
+		_mm_storeu_pd(ab + 1 * GEMM_NR + half, c10);
+		_mm_storeu_pd(ab + 1 * GEMM_NR + half + 2, c11);
+		_mm_storeu_pd(ab + 2 * GEMM_NR + half, c20);
+		_mm_storeu_pd(ab + 2 * GEMM_NR + half + 2, c21);
+		_mm_storeu_pd(ab + 3 * GEMM_NR + half, c30);
+		_mm_storeu_pd(ab + 3 * GEMM_NR + half + 2, c31);
+	}
+}
+
+
+__attribute__((target("avx2,fma")))
+static void gemmMicroKernelAvx2(int kc, const double* restrict a, const double* restrict b, double* restrict ab) {
+	__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+	__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+	__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+	__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+	for (int p = 0; p < kc; ++p, a += GEMM_MR, b += GEMM_NR) {
+		__m256d b0 = _mm256_loadu_pd(b);
+		__m256d b1 = _mm256_loadu_pd(b + 4);
+		__m256d ai;
+
+		ai = _mm256_broadcast_sd(a);
+		c00 = _mm256_fmadd_pd(ai, b0, c00);
+		c01 = _mm256_fmadd_pd(ai, b1, c01);
+		ai = _mm256_broadcast_sd(a + 1);
+		c10 = _mm256_fmadd_pd(ai, b0, c10);
+		c11 = _mm256_fmadd_pd(ai, b1, c11);
+		ai = _mm256_broadcast_sd(a + 2);
+		c20 = _mm256_fmadd_pd(ai, b0, c20);
+		c21 = _mm256_fmadd_pd(ai, b1, c21);
+		ai = _mm256_broadcast_sd(a + 3);
+		c30 = _mm256_fmadd_pd(ai, b0, c30);
+		c31 = _mm256_fmadd_pd(ai, b1, c31);
+	}
+
+	_mm256_storeu_pd(ab + 0 * GEMM_NR, c00);
+	_mm256_storeu_pd(ab + 0 * GEMM_NR + 4, c01);
+	_mm256_storeu_pd(ab + 1 * GEMM_NR, c10);
+	_mm256_storeu_pd(ab + 1 * GEMM_NR + 4, c11);
+	_mm256_storeu_pd(ab + 2 * GEMM_NR, c20);
+	_mm256_storeu_pd(ab + 2 * GEMM_NR + 4, c21);
+	_mm256_storeu_pd(ab + 3 * GEMM_NR, c30);
+	_mm256_storeu_pd(ab + 3 * GEMM_NR + 4, c31);
+}
+
+
+__attribute__((target("avx512f")))
+static void gemmMicroKernelAvx512(int kc, const double* restrict a, const double* restrict b, double* restrict ab) {
+	// a row of the tile fits in one register, so even and odd steps of the depth use separate accumulators to keep 8 fused multiply-adds in flight
+	__m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+	__m512d d0 = _mm512_setzero_pd(), d1 = _mm512_setzero_pd(), d2 = _mm512_setzero_pd(), d3 = _mm512_setzero_pd();
+	int p;
+
+	for (p = 0; p + 1 < kc; p += 2, a += 2 * GEMM_MR, b += 2 * GEMM_NR) {
+		__m512d b0 = _mm512_loadu_pd(b);
+		__m512d b1 = _mm512_loadu_pd(b + GEMM_NR);
+
+		c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), b0, c0);
+		c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), b0, c1);
+		c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), b0, c2);
+		c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), b0, c3);
+		d0 = _mm512_fmadd_pd(_mm512_set1_pd(a[4]), b1, d0);
+		d1 = _mm512_fmadd_pd(_mm512_set1_pd(a[5]), b1, d1);
+		d2 = _mm512_fmadd_pd(_mm512_set1_pd(a[6]), b1, d2);
+		d3 = _mm512_fmadd_pd(_mm512_set1_pd(a[7]), b1, d3);
+	}
+	if (p < kc) {
+		__m512d b0 = _mm512_loadu_pd(b);
+
+		c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), b0, c0);
+		c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), b0, c1);
+		c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), b0, c2);
+		c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), b0, c3);
+	}
+
+	_mm512_storeu_pd(ab + 0 * GEMM_NR, _mm512_add_pd(c0, d0));
+	_mm512_storeu_pd(ab + 1 * GEMM_NR, _mm512_add_pd(c1, d1));
+	_mm512_storeu_pd(ab + 2 * GEMM_NR, _mm512_add_pd(c2, d2));
+	_mm512_storeu_pd(ab + 3 * GEMM_NR, _mm512_add_pd(c3, d3));
+}
+#endif
+
+
+static void gemmPackA(int mc, int kc, const double* a, ptrdiff_t rsa, ptrdiff_t csa, double* packed) {
+	for (int ir = 0; ir < mc; ir += GEMM_MR) {
+		int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+		for (int p = 0; p < kc; ++p) {
+			for (int i = 0; i < mr; ++i)
+				packed[i] = a[(ir + i) * rsa + p * csa];
+			for (int i = mr; i < GEMM_MR; ++i)
+				packed[i] = 0;
+			packed += GEMM_MR;
+		}
+	}
+}
+
+
+static void gemmPackB(int kc, int nc, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* packed) {
+	for (int jr = 0; jr < nc; jr += GEMM_NR) {
+		int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+		for (int p = 0; p < kc; ++p) {
+			for (int j = 0; j < nr; ++j)
+				packed[j] = b[p * rsb + (jr + j) * csb];
+			for (int j = nr; j < GEMM_NR; ++j)
+				packed[j] = 0;
+			packed += GEMM_NR;
+		}
+	}
+}
+
+
+static size_t gemmScratchBytes(int m, int n, int k) {
+	size_t mcMax = (m < GEMM_MC) ? (m + GEMM_MR - 1) / GEMM_MR * GEMM_MR : GEMM_MC;
+	size_t kcMax = (k < GEMM_KC) ? k : GEMM_KC;
+	size_t ncMax = (n < GEMM_NC) ? (n + GEMM_NR - 1) / GEMM_NR * GEMM_NR : GEMM_NC;
+	size_t bytesA = (sizeof(double) * mcMax * kcMax + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN;
+	size_t bytesB = (sizeof(double) * kcMax * ncMax + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN;
+
+	return bytesA + bytesB;
+}
+
+
+static Status gemmTask(void* arg, int taskIdx) {
+	GemmJob* pJob = arg;
+	int row = taskIdx / pJob->gridCols * pJob->tileRows;    // first row of the tile
+	int col = taskIdx % pJob->gridCols * pJob->tileCols;    // first column of the tile
+	int rows = (pJob->m - row < pJob->tileRows) ? pJob->m - row : pJob->tileRows;
+	int cols = (pJob->n - col < pJob->tileCols) ? pJob->n - col : pJob->tileCols;
+
+	return gemm(rows, cols, pJob->k, pJob->a + row * pJob->rsa, pJob->rsa, pJob->csa, pJob->b + col * pJob->csb, pJob->rsb, pJob->csb, pJob->c + row * pJob->rsc + col * pJob->csc, pJob->rsc, pJob->csc);
+}
+
+
+static int getMaxLength(Matrix* pMx) {
+	int maxLength = 1;    // max length of the numbers found
+	int numLength;        // length of a single number
+
+	// a view's entries can be changed through its owner or other views, so its max length is always recalculated
+	if (pMx->maxLengthIsDirty || pMx->owner) {
+		for (int i = 0; i < pMx->rows; ++i) {
+			for (int j = 0; j < pMx->cols; ++j) {
+				numLength = calcEntryLength(pMx->entries[at(pMx, i, j)]);
+				if (i == 0 && j == 0)
+					maxLength = numLength;
+				else if (numLength > maxLength)
+					maxLength = numLength;
+			}
+		}
+		pMx->maxLength = maxLength;
+		pMx->maxLengthIsDirty = FALSE;
+	}
+
+	return pMx->maxLength;
+}
+
+
+static Scratch* getScratch(void) {
+	Scratch* pScr;
+
+	pthread_once(&scratchKeyOnce, initScratchKey);
+	if (!(pScr = pthread_getspecific(scratchKey))) {
+		// the arena itself comes from malloc so matrix_setAllocator only has to free the blocks
+		if (!(pScr = calloc(1, sizeof(*pScr))))
+			return NULL;
+		if (pthread_setspecific(scratchKey, pScr)) {
+			free(pScr);
+			return NULL;
+		}
+		pthread_mutex_lock(&scratchLock);
+		pScr->next = scratchList;
+		if (scratchList)
+			scratchList->prev = pScr;
+		scratchList = pScr;
+		pthread_mutex_unlock(&scratchLock);
+	}
+
+	return pScr;
+}
+
+
+static const SimdKernels* getSimdKernels(void) {
+	pthread_once(&simdKernelsOnce, initSimdKernels);
+	return pSimdKernels;
+}
+
+
+size_t getSize(int rows, int cols) {
+	return (size_t)rows * cols;
+}
+
+
+static int getStructure(Matrix* pMx) {
+	// a view's entries can be changed through its owner or other views, so its structure is always found again
+	if (pMx->structureIsDirty || pMx->owner) {
+		pMx->structure = findStructure(pMx);
+		pMx->structureIsDirty = FALSE;
+	}
+
+	return pMx->structure;
+}
+
+
+static size_t headerCount(int sizeClass) {
+	return sizeof(Matrix) / sizeof(double) + poolClassSizes[sizeClass];
+}
+
+
+static Matrix* initMatrix(int rows, int cols, Boolean zero) {
+	size_t size = getSize(rows, cols);
+	Matrix* pMx = allocMatrix(size);
+	if (pMx) {
+		// a small matrix keeps its entries in the header, a large one allocates them separately
+		if (size <= poolClassSizes[pMx->sizeClass]) {
+			pMx->entries = pMx->inlineEntries;
+			pMx->capacity = poolClassSizes[pMx->sizeClass];
+			if (zero)
+				memset(pMx->entries, 0, sizeof(*(pMx->entries)) * size);
+		}
+		else {
+			if (!(pMx->entries = allocEntries(size, zero))) {
+				freeMatrix(pMx);
+				return NULL;
+			}
+			pMx->capacity = size;
+		}
+		pMx->rows = rows;
+		pMx->cols = cols;
+		pMx->rowStride = cols;
+		pMx->colStride = 1;
+		pMx->owner = NULL;
+		pMx->maxLength = 1;
+		pMx->maxLengthIsDirty = !zero;
+		pMx->structure = (rows == cols) ? STRUCTURE_DIAGONAL : 0;    // a matrix of zeros is diagonal
+		pMx->structureIsDirty = !zero;
+	}
+
+	return pMx;
+}
+
+
+static void initScratchKey(void) {
+	pthread_key_create(&scratchKey, scratchDestroy);
+}
 
-	// the determinant of a 1 x 1 matrix is just the single number in the matrix
-	if (pMx->rows == 1 && pMx->cols == 1)
-		return pMx->entries[0];
 
-	// all other matrices - 2 x 2, 3 x 3 etc.
-	return opDet(pMx, pMem);
+static void initSimdKernels(void) {
+	pSimdKernels = &simdKernelsTable[cpuSimdLevel()];
 }
 
 
-Status matrix_opInv(MATRIX hMx, Boolean* pMxIsInvertible, MATRIX* phMxRes) {
-	Matrix* pMx = hMx;
-	Matrix* pMxRes;       // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
-	Status mem;           // indicates if there's memory allocation failure
-	double det;           // determinant
-	double newEntry;      // each new term in result matrix after multiply by 1 / determinant
-	int maxLength = 1;    // max length of the new matrix (same as in the matrix structure)
-	int numLength;        // gets the length of each number to be compared to max length
-	
+static Boolean isContiguous(const Matrix* pMx) {
+	return (pMx->cols == 1 || pMx->colStride == 1) && (pMx->rows == 1 || pMx->rowStride == pMx->cols);
+}
 
-	*pMxIsInvertible = FALSE;    // assume the matrix isn't invertible
 
-	// recreate the result matrix if its dimensions aren't appropriate for the inverse or it's NULL
-	if (!adjustMatrixDims((Matrix**)phMxRes, pMx->rows, pMx->cols))
-		return FAILURE;
-	pMxRes = *phMxRes;
+static Boolean isPivotZero(double pivot, double colMax, double rowMax, ptrdiff_t n) {
+	return pivot == 0 || pivot <= n * DBL_EPSILON * fmin(colMax, rowMax);
+}
 
-	// implement the inverse operation
-	// 1: calculate the determinant - if it's 0 the matrix is invertible and the inverse can't be calculated
-	det = matrix_opDet(hMx, &mem);
-	if (!mem)
-		return FAILURE;
-	else if (det == 0) {
-		*pMxIsInvertible = TRUE;
-		return FAILURE;
+
+static int luDecompose(double* lu, ptrdiff_t n, int* piv, double* scale) {
+	double* rowK;                 // pivot row
+	double* rowI;                 // row being eliminated
+	double* colMax = scale;       // largest magnitude of each original column
+	double* rowMax = scale + n;   // largest magnitude of the original row now at each row, swapped along with the rows
+	double pivot;                 // largest magnitude entry at or below the diagonal in the current column
+	double factor;                // multiplier of the pivot row
+	int pivRow;                   // row holding the pivot
+	int sign = 1;                 // sign of the row permutation
+
+
+	// record the scale of every original column and row so a pivot reduced to rounding noise is recognized as 0
+	for (int j = 0; j < n; ++j)
+		colMax[j] = 0;
+	for (int i = 0; i < n; ++i) {
+		rowMax[i] = 0;
+		for (int j = 0; j < n; ++j) {
+			double entry = fabs(lu[i * n + j]);
+			if (entry > colMax[j])
+				colMax[j] = entry;
+			if (entry > rowMax[i])
+				rowMax[i] = entry;
+		}
 	}
 
-	// 2: calculate the adjugate matrix
-	if (!opAdjugate(pMx, &pMxRes))
-		return FAILURE;
+	for (int k = 0; k < n; ++k) {
+		// find the pivot
+		pivRow = k;
+		pivot = fabs(lu[k * n + k]);
+		for (int i = k + 1; i < n; ++i) {
+			if (fabs(lu[i * n + k]) > pivot) {
+				pivot = fabs(lu[i * n + k]);
+				pivRow = i;
+			}
+		}
+		if (piv)
+			piv[k] = pivRow;
+		if (isPivotZero(pivot, colMax[k], rowMax[pivRow], n))
+			return 0;
 
-	// 3: multiply every term in the adjugate matrix by 1 / determinant - the result of this is the inverse
-	int size = getSize(pMxRes->rows, pMxRes->cols);
-	for (int i = 0; i < size; ++i) {
-		newEntry = pMxRes->entries[i] / det;
-		numLength = calcEntryLength(newEntry);
-		if (i == 0)
-			maxLength = numLength;
-		else if (numLength > maxLength)
-			maxLength = numLength;
-		pMxRes->entries[i] = newEntry;
+		// move the pivot row into place
+		if (pivRow != k) {
+			rowK = lu + k * n;
+			rowI = lu + pivRow * n;
+			for (int j = 0; j < n; ++j) {
+				double temp = rowK[j];
+				rowK[j] = rowI[j];
+				rowI[j] = temp;
+			}
+			double temp = rowMax[k];
+			rowMax[k] = rowMax[pivRow];
+			rowMax[pivRow] = temp;
+			sign = -sign;
+		}
+
+		// eliminate below the pivot
+		rowK = lu + k * n;
+		for (int i = k + 1; i < n; ++i) {
+			rowI = lu + i * n;
+			factor = rowI[k] / rowK[k];
+			rowI[k] = factor;
+			if (factor != 0) {
+				for (int j = k + 1; j < n; ++j)
+					rowI[j] -= factor * rowK[j];
+			}
+		}
 	}
-	pMxRes->maxLength = maxLength;
 
-	return SUCCESS;
+	return sign;
 }
 
 
-Status matrix_opMult(MATRIX hMx1, MATRIX hMx2, MATRIX* phMxRes) {
-	Matrix* pMx1 = hMx1;               // matrix 1 being multiplied
-	Matrix* pMx2 = hMx2;               // matrix 2 being multiplied
-	Matrix* pMxRes;                    // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
-	double sum = 0;                    // the sum for each new entry in the result matrix
-	int resRow = 0;                    // index tracker of the result matrix's row
-	int resCol = 0;                    // index tracker of the result matrix's column
-	int maxLength = 1;                 // max length of the new matrix (same as in the matrix structure)
-	int numLength;                     // gets the length of each number to be compared to max length
-	Boolean isFirstNewEntry = TRUE;    // indicates if the first number being calculated in the whole result matrix
+static void luSolve(const double* lu, const int* piv, ptrdiff_t n, double* x, ptrdiff_t nrhs) {
+	double* rowI;          // panel row of the solution being computed
+	const double* rowK;    // panel row of the solution already computed
+	double factor;
+	int panelCols;         // columns in each panel
 
 
-	// recreate the result matrix if its dimensions aren't appropriate for the multiplication or it's NULL
-	if (!adjustMatrixDims((Matrix**)phMxRes, pMx1->rows, pMx2->cols))
-		return FAILURE;
-	pMxRes = *phMxRes;
+	panelCols = SOLVE_PANEL_BYTES / (int)sizeof(*x) / n;
+	if (panelCols < 8)
+		panelCols = 8;
+
+	for (int j0 = 0; j0 < nrhs; j0 += panelCols) {
+		int nb = (nrhs - j0 < panelCols) ? nrhs - j0 : panelCols;    // columns in this panel
+
+		// apply the row swaps of the factorization
+		for (int k = 0; k < n; ++k) {
+			if (piv[k] != k) {
+				rowI = x + k * nrhs + j0;
+				double* rowP = x + piv[k] * nrhs + j0;
+				for (int j = 0; j < nb; ++j) {
+					double temp = rowI[j];
+					rowI[j] = rowP[j];
+					rowP[j] = temp;
+				}
+			}
+		}
 
+		// forward substitution with the unit lower triangle
+		for (int i = 1; i < n; ++i) {
+			rowI = x + i * nrhs + j0;
+			for (int k = 0; k < i; ++k) {
+				factor = lu[i * n + k];
+				if (factor != 0) {
+					rowK = x + k * nrhs + j0;
+					for (int j = 0; j < nb; ++j)
+						rowI[j] -= factor * rowK[j];
+				}
+			}
+		}
 
-	// perform the multiplication
-	for (int m1row = 0; m1row < pMx1->rows; ++m1row) {
-		resCol = 0;
-		for (int m2col = 0; m2col < pMx2->cols; ++m2col) {
-			sum = 0;
-			for (int m1col = 0, m2row = 0; m1col < pMx1->cols; ++m1col, ++m2row)
-				sum += pMx1->entries[at(pMx1, m1row, m1col)] * pMx2->entries[at(pMx2, m2row, m2col)];
-			numLength = calcEntryLength(sum);
-			if (isFirstNewEntry) {
-				maxLength = numLength;
-				isFirstNewEntry = FALSE;
+		// back substitution with the upper triangle
+		for (int i = n - 1; i >= 0; --i) {
+			rowI = x + i * nrhs + j0;
+			for (int k = i + 1; k < n; ++k) {
+				factor = lu[i * n + k];
+				if (factor != 0) {
+					rowK = x + k * nrhs + j0;
+					for (int j = 0; j < nb; ++j)
+						rowI[j] -= factor * rowK[j];
+				}
 			}
-			else if (numLength > maxLength)
-				maxLength = numLength;
-			pMxRes->entries[at(pMxRes, resRow, resCol)] = sum;
-			++resCol;
+			factor = 1 / lu[i * n + i];
+			for (int j = 0; j < nb; ++j)
+				rowI[j] *= factor;
 		}
-		++resRow;
 	}
-	pMxRes->maxLength = maxLength;
+}
 
-	return SUCCESS;
+
+static void markDirty(Matrix* pMx) {
+	pMx->maxLengthIsDirty = TRUE;
+	pMx->structureIsDirty = TRUE;
+	if (pMx->owner) {
+		pMx->owner->maxLengthIsDirty = TRUE;
+		pMx->owner->structureIsDirty = TRUE;
+	}
 }
 
 
-Status matrix_opPow(MATRIX hMx, int power, MATRIX* phMxRes) {
-	MATRIX hMxToMult = NULL;        // handles used for power operation
-	MATRIX hMxResTemp = NULL;
+static void multDiagonal(const Matrix* pMxDiag, const Matrix* pMx, Boolean left, Matrix* pMxRes) {
+	const double* diag = pMxDiag->entries;
+	ptrdiff_t diagStride = pMxDiag->rowStride + pMxDiag->colStride;    // distance from an entry of the diagonal to the next one
+	int rows = pMxRes->rows, cols = pMxRes->cols;
+	ptrdiff_t rss = pMx->rowStride, css = pMx->colStride;
+	ptrdiff_t rsd = pMxRes->rowStride, csd = pMxRes->colStride;
+	double scale;
+
+	// a diagonal on the right scales the columns, which are the rows of the transposes
+	if (!left) {
+		rows = pMxRes->cols;
+		cols = pMxRes->rows;
+		rss = pMx->colStride;
+		css = pMx->rowStride;
+		rsd = pMxRes->colStride;
+		csd = pMxRes->rowStride;
+	}
 
-	// special cases: power = 1 or 2
-	if (power == 1) {
-		if (!matrix_copy(phMxRes, hMx))
-			return FAILURE;
-		return SUCCESS;
+	for (int i = 0; i < rows; ++i) {
+		const double* src = pMx->entries + i * rss;
+		double* dst = pMxRes->entries + i * rsd;
+		scale = diag[i * diagStride];
+		if (css == 1 && csd == 1) {
+			for (int j = 0; j < cols; ++j)
+				dst[j] = scale * src[j];
+		}
+		else {
+			for (int j = 0; j < cols; ++j)
+				dst[j * csd] = scale * src[j * css];
+		}
 	}
-	else if (power == 2) {
-		if (!matrix_opMult(hMx, hMx, phMxRes))
-			return FAILURE;
-		return SUCCESS;
+}
+
+
+static void multPermutation(const Matrix* pMxPerm, const Matrix* pMx, Boolean left, Matrix* pMxRes) {
+	int n = pMxPerm->rows;
+	int cols = left ? pMx->cols : pMx->rows;
+	ptrdiff_t rsp = pMxPerm->rowStride, csp = pMxPerm->colStride;
+	ptrdiff_t rss = pMx->rowStride, css = pMx->colStride;
+	ptrdiff_t rsd = pMxRes->rowStride, csd = pMxRes->colStride;
+	int k;
+
+	// a permutation on the right gathers the columns, which are the rows of the transposes, by the rows of P^T
+	if (!left) {
+		rsp = pMxPerm->colStride;
+		csp = pMxPerm->rowStride;
+		rss = pMx->colStride;
+		css = pMx->rowStride;
+		rsd = pMxRes->colStride;
+		csd = pMxRes->rowStride;
 	}
 
-	// all other cases
-	// do the first multiplication in the power operation
-	if (!matrix_opMult(hMx, hMx, &hMxToMult))
-		return FAILURE;
-	// do all other multiplications thereafter
-	for (int i = 3; i <= power; ++i) {
-		if (!matrix_opMult(hMx, hMxToMult, &hMxResTemp)) {
-			matrix_destroy(&hMxToMult);
-			return FAILURE;
-		}
-		matrix_destroy(&hMxToMult);
-		hMxToMult = hMxResTemp;
-		hMxResTemp = NULL;
+	// row i of the result is row k of the other factor, where the 1 of row i of the permutation is in column k
+	for (int i = 0; i < n; ++i) {
+		for (k = 0; pMxPerm->entries[i * rsp + k * csp] == 0; ++k)
+			;
+		copyEntries(1, cols, pMx->entries + k * rss, rss, css, pMxRes->entries + i * rsd, rsd, csd);
 	}
+}
 
-	// store the result of the power operation
-	matrix_move(phMxRes, &hMxToMult);
-	return SUCCESS;
+
+static double opDet2x2(double a11, double a12, double a21, double a22) {
+	return a11 * a22 - a21 * a12;
 }
 
 
-Status matrix_opSub(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes) {
-	Matrix* pMxToSub = hMxs[0];        // first matrix, the matrix being subtracted from
-	Matrix* pMxRes;                    // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
-	double sum = 0;                    // sum for each new individual term
-	int maxLength = 1;                 // max length of the new matrix (same as in the matrix structure)
-	int numLength;                     // gets the length of each number to be compared to max length
-	Boolean isFirstNewEntry = TRUE;    // indicates if the first number being calculated in the whole result matrix
-	
+static Status opPowDiagonal(Matrix* pMx, int power, Matrix** ppMxRes) {
+	int n = pMx->rows;
+	double* diag;         // diagonal of the result, computed before the result is zeroed in case it's pMx
+	double base;
+	size_t mark = scratchMark();
 
-	// recreate the result matrix if its dimensions aren't appropriate for the subtraction or it's NULL
-	if (!adjustMatrixDims((Matrix**)phMxRes, pMxToSub->rows, pMxToSub->cols))
+	if (!(diag = scratchAlloc(sizeof(*diag) * n))) {
+		scratchRelease(mark);
 		return FAILURE;
-	pMxRes = *phMxRes;  // result of subtraction
-	
-
-	// perform the subtraction
-	// outer 2 loops for result matrix
-	for (int resRow = 0; resRow < pMxToSub->rows; ++resRow) {
-		for (int resCol = 0; resCol < pMxToSub->cols; ++resCol) {
-			// inner loop to get the sum
-			sum = 0;
-			for (int i = 0; i < hMxsSize; ++i) {
-				pMxToSub = hMxs[i];
-				if (i == 0)
-					sum += pMxToSub->entries[at(pMxToSub, resRow, resCol)];
-				else
-					sum -= pMxToSub->entries[at(pMxToSub, resRow, resCol)];
-			}
-			numLength = calcEntryLength(sum);
-			if (isFirstNewEntry) {
-				maxLength = numLength;
-				isFirstNewEntry = FALSE;
+	}
+	for (int i = 0; i < n; ++i) {
+		base = pMx->entries[at(pMx, i, i)];
+		if (power == -1)
+			diag[i] = 1 / base;
+		else {
+			// the same exponentiation by squaring as matrix_opPow, one entry at a time
+			diag[i] = 1;
+			for (int p = power; ; base *= base) {
+				if (p & 1)
+					diag[i] *= base;
+				if (!(p >>= 1))
+					break;
 			}
-			else if (numLength > maxLength)
-				maxLength = numLength;
-			pMxRes->entries[at(pMxRes, resRow, resCol)] = sum;
 		}
 	}
-	pMxRes->maxLength = maxLength;
+
+	if (!adjustMatrixDims(ppMxRes, n, n, TRUE)) {
+		scratchRelease(mark);
+		return FAILURE;
+	}
+	for (int i = 0; i < n; ++i)
+		(*ppMxRes)->entries[at(*ppMxRes, i, i)] = diag[i];
+	scratchRelease(mark);
 
 	return SUCCESS;
 }
 
 
-Status matrix_opTrans(MATRIX hMx, MATRIX* phMxRes) {
-	Matrix* pMx = hMx;
-	Matrix* pMxRes;    // result matrix, not initialized b/c phMxRes isn't guaranteed to have a matrix
+static double* reallocEntries(double* entries, size_t count, size_t newCount) {
+	double* newEntries;
 
-	// recreate the result matrix if its dimensions aren't appropriate for the transpose or it's NULL
-	if (!adjustMatrixDims((Matrix**)phMxRes, pMx->cols, pMx->rows))
-		return FAILURE;
-	pMxRes = *phMxRes;
+	if (allocator.reallocFn)
+		return allocator.reallocFn(entries, ((size_t)newCount * sizeof(double) + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN, ENTRIES_ALIGN, allocator.userdata);
 
-	// calculate the transpose
-	for (int i = 0; i < pMx->rows; ++i) {
-		for (int j = 0; j < pMx->cols; ++j)
-			pMxRes->entries[at(pMxRes, j, i)] = pMx->entries[at(pMx, i, j)];
+	newEntries = allocEntries(newCount, FALSE);
+
+	if (newEntries) {
+		memcpy(newEntries, entries, sizeof(*entries) * ((count < newCount) ? count : newCount));
+		freeEntries(entries, count);
 	}
-	pMxRes->maxLength = pMx->maxLength;
 
-	return SUCCESS;
+	return newEntries;
 }
 
 
-void matrix_print(MATRIX hMx) {
-	Matrix* pMx = hMx;
-	char entryStr[500];    // buffer to hold each entry as a string
-	double entry;          // one entry in the matrix
-	int extraSpaces;       // count how many extra spaces to print for each entry
-	int spacesPerNum;      // each entry occupies the same fixed space                          
-	int totalSpaces;       // the total spaces horizontally the matrix takes up so it's known how many dashes to print
-	
-
-	spacesPerNum = pMx->maxLength + 2;
-	totalSpaces = spacesPerNum * pMx->cols + pMx->cols + 1;
-	
-	// print the matrix
-	// print top level of dashes
-	for (int i = 0; i < totalSpaces; ++i)
-		printf("-");
-	printf("\n");
+static void releaseEntries(Matrix* pMx) {
+	if (pMx->entries != pMx->inlineEntries)
+		freeEntries(pMx->entries, pMx->capacity);
+}
 
-	for (int i = 0; i < pMx->rows; ++i) {
-		for (int j = 0; j < pMx->cols; ++j) {
-			entry = pMx->entries[at(hMx, i, j)];
-			sprintf(entryStr, "%f", entry);
-			removeTrailingZeroes(entryStr);
-			printf("|");
-			printf("%s", entryStr);
-			extraSpaces = pMx->maxLength - strlen(entryStr);
 
-			while (extraSpaces > 0) {
-				printf(" ");
-				--extraSpaces;
-			}
-			printf("  ");
-			if (j == pMx->cols - 1)
-				printf("|");
-		}
-		printf("\n");
+static void removeTrailingZeroes(char* entryStr) {
+	Boolean reachedDecimalPoint = FALSE;
 
-		// print level of dashes for each row
-		for (int i = 0; i < totalSpaces; ++i)
-			printf("-");
-		printf("\n");
+	for (int i = strlen(entryStr) - 1; i >= 0 && (entryStr[i] == '0' || entryStr[i] == '.'); --i) {
+		if (reachedDecimalPoint == TRUE)
+			break;
+		if (entryStr[i] == '.')
+			reachedDecimalPoint = TRUE;
+		entryStr[i] = '\0';
 	}
 }
 
 
-Status matrix_setEntry(MATRIX hMx, int row, int col, double entry) {
-	Matrix* pMx = hMx;
-	int idx;
+static void* scratchAlloc(size_t bytes) {
+	Scratch* pScr = getScratch();
+	ScratchChunk* pChunk;
+	void* mem;
+	size_t count;
 
-	idx = at(hMx, row, col);
-	if (idx != -1) {
-		pMx->entries[idx] = entry;
-		return SUCCESS;
+	if (!pScr)
+		return NULL;
+	bytes = (bytes + ENTRIES_ALIGN - 1) / ENTRIES_ALIGN * ENTRIES_ALIGN;    // keep every request aligned
+
+	if (pScr->top + bytes <= pScr->size)
+		mem = (char*)pScr->block + pScr->top;
+	else {
+		// spill into a chunk of its own with the header before the memory handed out
+		count = (ENTRIES_ALIGN + bytes) / sizeof(double);
+		if (!(pChunk = (ScratchChunk*)allocEntries(count, FALSE)))
+			return NULL;
+		pChunk->next = pScr->chunks;
+		pChunk->mark = pScr->top;
+		pChunk->count = count;
+		pScr->chunks = pChunk;
+		mem = (char*)pChunk + ENTRIES_ALIGN;
 	}
-	else
-		return FAILURE;
+	pScr->top += bytes;
+	if (pScr->top > pScr->peak)
+		pScr->peak = pScr->top;
+
+	return mem;
 }
 
 
+static void scratchDestroy(void* arg) {
+	Scratch* pScr = arg;
 
+	pthread_mutex_lock(&scratchLock);
+	if (pScr->prev)
+		pScr->prev->next = pScr->next;
+	else
+		scratchList = pScr->next;
+	if (pScr->next)
+		pScr->next->prev = pScr->prev;
+	pthread_mutex_unlock(&scratchLock);
+
+	// operations release everything they allocate before they return, so only the block and the free lists are left
+	scratchFreeBlocks(pScr);
+	free(pScr);
+}
 
-/********** Helper function definitions **********/
-static Status adjustMatrixDims(Matrix** ppMx, int rows, int cols) {
-	Matrix* pMx = *ppMx;
-	double* entries;
 
+static void scratchFreeBlocks(Scratch* pScr) {
+	Matrix* pMx;
 
-	// matrix doesn't exist
-	if (!(*ppMx)) {
-		if (!(*ppMx = matrix_initDims(rows, cols)))
-			return FAILURE;
-	}
-	// matrix exists
-	else {
-		// needs resizing
-		if (getSize(pMx->rows, pMx->cols) < getSize(rows, cols)) {
-			if (!(entries = calloc(getSize(rows, cols), sizeof(*entries))))
-				return FAILURE;
-			free(pMx->entries);
-			pMx->entries = entries;
-		}
-		else { // doesn't need resizing, 0 out new entries
-			int size = getSize(rows, cols);
-			for (int i = 0; i < size; ++i)
-				pMx->entries[i] = 0;
+	freeEntries(pScr->block, pScr->size / sizeof(double));
+	pScr->block = NULL;
+	pScr->size = 0;
+	pScr->peak = 0;
+	for (int i = 0; i < POOL_CLASSES; ++i) {
+		while ((pMx = pScr->freeMatrices[i])) {
+			pScr->freeMatrices[i] = pMx->owner;
+			freeEntries((double*)pMx, headerCount(i));
 		}
-
-		// in either case, set the new rows, columns, and max length
-		pMx->rows = rows;
-		pMx->cols = cols;
-		pMx->maxLength = 1;
+		pScr->numFreeMatrices[i] = 0;
 	}
-
-	return SUCCESS;
 }
 
 
-static int at(Matrix* pMx, int row, int col) {
-	return (row >= pMx->rows || col >= pMx->cols) ? -1 : (row * pMx->cols + col);
+static size_t scratchMark(void) {
+	Scratch* pScr = getScratch();
+	return pScr ? pScr->top : 0;
 }
 
 
-int at2(int rows, int cols, int row, int col) {
-	return (row >= rows || col >= cols) ? -1 : row * cols + col;
+static void scratchRelease(size_t mark) {
+	Scratch* pScr = pthread_getspecific(scratchKey);
+	ScratchChunk* pChunk;
+	size_t size;
+
+	if (!pScr)
+		return;
+
+	while (pScr->chunks && pScr->chunks->mark >= mark) {
+		pChunk = pScr->chunks;
+		pScr->chunks = pChunk->next;
+		freeEntries((double*)pChunk, pChunk->count);
+	}
+	pScr->top = mark;
+
+	// grow geometrically so a thread whose operations keep getting bigger replaces its block only O(log size) times
+	if (!mark && pScr->peak > pScr->size && pScr->size < SCRATCH_MAX_BYTES) {
+		size = 2 * pScr->size;
+		if (size < pScr->peak)
+			size = pScr->peak;
+		if (size < SCRATCH_MIN_BYTES)
+			size = SCRATCH_MIN_BYTES;
+		if (size > SCRATCH_MAX_BYTES)
+			size = SCRATCH_MAX_BYTES;
+		freeEntries(pScr->block, pScr->size / sizeof(double));
+		pScr->block = allocEntries(size / sizeof(double), FALSE);
+		pScr->size = pScr->block ? size : 0;
+	}
 }
 
 
-static int calcEntryLength(double entry) {
-	char entryStr[100];    // string representation of entry
-	int entryInt;          // integer part of entry
-	int length;
+static void scratchWarm(void) {
+	Scratch* pScr = getScratch();
+	size_t size;
 
-	// if entry is equivalent to an integer (i.e. 2.0) its length is just the integer part
-	entryInt = (int)floor(entry);
-	if (entryInt == entry) {
-		sprintf(entryStr, "%d", entryInt);
-		length =  strlen(entryStr);
+	pthread_mutex_lock(&scratchLock);
+	size = scratchWarmBytes;
+	pthread_mutex_unlock(&scratchLock);
+
+	// releasing an empty arena whose peak is past its block replaces the block with one that holds the peak
+	if (pScr && pScr->size < size) {
+		if (pScr->peak < size)
+			pScr->peak = size;
+		scratchRelease(0);
 	}
-	// entry isn't equivalent to an integer, must get characters after decimal part, exclude trailing 0s
-	else {
-		sprintf(entryStr, "%f", entry);
-		length = strlen(entryStr);
-		for (int i = strlen(entryStr) - 1; entryStr[i] == '0' || entryStr[i] == '.'; --i)
-			--length;
+}
+
+
+static void transBlock(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd) {
+	for (int i = 0; i < TRANS_BLOCK; ++i) {
+		for (int j = 0; j < TRANS_BLOCK; ++j)
+			dst[j * ldd + i] = src[i * lds + j];
 	}
+}
 
-	return length;
+
+#ifdef SIMD_X86
+#if TRANS_BLOCK != 4
+#error "The SIMD transpose kernels are written for a 4 x 4 tile"
+#endif
+
+__attribute__((target("sse2")))
+static void transBlockSse2(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd) {
+	for (int i = 0; i < TRANS_BLOCK; i += 2) {
+		for (int j = 0; j < TRANS_BLOCK; j += 2) {
+			__m128d r0 = _mm_loadu_pd(src + i * lds + j);
+			__m128d r1 = _mm_loadu_pd(src + (i + 1) * lds + j);
+			_mm_storeu_pd(dst + j * ldd + i, _mm_unpacklo_pd(r0, r1));
+			_mm_storeu_pd(dst + (j + 1) * ldd + i, _mm_unpackhi_pd(r0, r1));
+		}
+	}
 }
 
 
-static int getSize(int rows, int cols) {
-	return rows * cols;
+__attribute__((target("avx2")))
+static void transBlockAvx2(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd) {
+	__m256d r0 = _mm256_loadu_pd(src);
+	__m256d r1 = _mm256_loadu_pd(src + lds);
+	__m256d r2 = _mm256_loadu_pd(src + 2 * lds);
+	__m256d r3 = _mm256_loadu_pd(src + 3 * lds);
+	__m256d t0 = _mm256_unpacklo_pd(r0, r1);    // r00 r10 r02 r12
+	__m256d t1 = _mm256_unpackhi_pd(r0, r1);    // r01 r11 r03 r13
+	__m256d t2 = _mm256_unpacklo_pd(r2, r3);    // r20 r30 r22 r32
+	__m256d t3 = _mm256_unpackhi_pd(r2, r3);    // r21 r31 r23 r33
+
+	_mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+	_mm256_storeu_pd(dst + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+	_mm256_storeu_pd(dst + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+	_mm256_storeu_pd(dst + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
 }
+#endif
 
 
-static Status opAdjugate(Matrix* pMx, Matrix** ppMxRes) {
-	Matrix* pMxRes;    // result matrix, not initialized b/c ppMxRes isn't guaranteed to have a matrix
-	
+static Status transCyclesInPlace(double* entries, int rows, int cols) {
+	long long last = (long long)rows * cols - 1;    // index of the last entry, which stays put like the first
+	unsigned char* moved;                            // bitset of the entries already moved
+	double carry, temp;
+	long long next;
+	size_t mark = scratchMark();
 
-	// recreate the result matrix if its dimensions aren't appropriate for the adjugate or it's NULL
-	if (!adjustMatrixDims(ppMxRes, pMx->rows, pMx->cols))
+	if (!(moved = scratchAlloc(last / CHAR_BIT + 1))) {
+		scratchRelease(mark);
 		return FAILURE;
-	pMxRes = *ppMxRes;
-
-	// special case for 1 x 1 matrix
-	if (pMxRes->rows == 1 && pMxRes->cols == 1) {
-		pMxRes->entries[0] = (pMx->entries[0] != 0) ? 1 : 0;
-		return SUCCESS;
 	}
-	// special case for a 2 x 2 matrix
-	else if (pMxRes->rows == 2 && pMxRes->cols == 2) {
-		int size = getSize(pMxRes->rows, pMxRes->cols);
-		for (int i = 0; i < size; ++i)
-			pMxRes->entries[i] = pMx->entries[i];
-
-		pMxRes->entries[at(pMxRes, 0, 1)] *= -1;
-		pMxRes->entries[at(pMxRes, 1, 0)] *= -1;
-		double temp = pMxRes->entries[at(pMxRes, 0, 0)];
-		pMxRes->entries[at(pMxRes, 0, 0)] = pMxRes->entries[at(pMxRes, 1, 1)];
-		pMxRes->entries[at(pMxRes, 1, 1)] = temp;
-		int length1 = calcEntryLength(pMxRes->entries[at(pMxRes, 0, 0)]);
-		int length2 = calcEntryLength(pMxRes->entries[at(pMxRes, 0, 1)]);
-		int length3 = calcEntryLength(pMxRes->entries[at(pMxRes, 1, 0)]);
-		int length4 = calcEntryLength(pMxRes->entries[at(pMxRes, 1, 1)]);
-		int maxLength = length1;
-		if (length2 > maxLength)
-			maxLength = length2;
-		if (length3 > maxLength)
-			maxLength = length3;
-		if (length4 > maxLength)
-			maxLength = length4;
-		pMxRes->maxLength = maxLength;
-		return SUCCESS;
+	memset(moved, 0, last / CHAR_BIT + 1);
+
+	for (long long start = 1; start < last; ++start) {
+		if (moved[start / CHAR_BIT] & (1 << (start % CHAR_BIT)))
+			continue;
+
+		// move each entry of the cycle to where the entry before it belongs, ending back at the start
+		carry = entries[start];
+		next = start;
+		do {
+			next = next * rows % last;
+			temp = entries[next];
+			entries[next] = carry;
+			carry = temp;
+			moved[next / CHAR_BIT] |= 1 << (next % CHAR_BIT);
+		} while (next != start);
 	}
 
-	// all other matrices - 3 x 3, 4 x 4 etc.
-	// create the matrix of cofactors
-	MATRIX hMxOfCofactors;     // the adjugate matrix is the transpose of the matrix of cofactors
-	Matrix* pMxOfCofactors;    
-	if (!(hMxOfCofactors = matrix_initDims(pMx->cols, pMx->rows)))
-		return FAILURE;
-	pMxOfCofactors = hMxOfCofactors;
-
-	// calculate each entry for the matrix of cofactors
-	Status mem;                    // indicate if there is memory allocation failure
-	int maxLength = 1;             // max length of the new matrix (same as in the matrix structure).
-	int numLength;                 // gets the length of each number to be compared to max length
-	Boolean firstNewNum = TRUE;    // TRUE = first number being calculated in the whole result matrix
-	double newTerm;                // each new term after multiplying by 1 / determinant
-
-	for (int row = 0; row < pMx->rows; ++row) {
-		for (int col = 0; col < pMx->cols; ++col) {
-			// create the recursive submatrix
-			MATRIX hMxSub = matrix_initDims(pMx->rows - 1, pMx->cols - 1);
-			if (!hMxSub) {
-				matrix_destroy(&hMxOfCofactors);
-				return FAILURE;
-			}
-			Matrix* pMxSub = hMxSub;
-
-			// get the submatrix
-			int mxSub_row = 0;
-			int mxSub_col = 0;
-			for (int _row = 0; _row < pMx->rows; ++_row) {
-				if (_row == row)
-					continue;
-				mxSub_col = 0;
-				for (int _col = 0; _col < pMx->cols; ++_col) {
-					if (_col == col)
-						continue;
-					pMxSub->entries[at(pMxSub, mxSub_row, mxSub_col)] = pMx->entries[at(pMx, _row, _col)];
-					++mxSub_col;
-				}
-				++mxSub_row;
-			}
+	scratchRelease(mark);
+	return SUCCESS;
+}
 
-			// get the i, jth entry in the matrix of cofactors
-			mem = SUCCESS;
-			newTerm = opDet(pMxSub, &mem);
-			// memory allocation failure
-			if (!mem) {
-				matrix_destroy(&hMxOfCofactors);
-				return FAILURE;
-			}
-			// multiply by -1 or not
-			if (newTerm != 0 && (row + col) % 2 != 0)
-				newTerm *= -1;
 
-			numLength = calcEntryLength(newTerm);
+static void transRecursive(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd, int rows, int cols, void (*kernel)(const double* src, ptrdiff_t lds, double* dst, ptrdiff_t ldd)) {
+	int half;
+	int rowsTiled, colsTiled;    // rows and columns covered by whole tiles
 
-			if (firstNewNum) {
-				maxLength = numLength;
-				firstNewNum = FALSE;
-			}
-			else if (numLength > maxLength)
-				maxLength = numLength;
-			
-			pMxOfCofactors->entries[at(pMxOfCofactors, row, col)] = newTerm;
+	// split the longer side, keeping the split on a tile boundary
+	if (rows > TRANS_LEAF && rows >= cols) {
+		half = rows / 2 / TRANS_BLOCK * TRANS_BLOCK;
+		transRecursive(src, lds, dst, ldd, half, cols, kernel);
+		transRecursive(src + half * lds, lds, dst + half, ldd, rows - half, cols, kernel);
+		return;
+	}
+	if (cols > TRANS_LEAF) {
+		half = cols / 2 / TRANS_BLOCK * TRANS_BLOCK;
+		transRecursive(src, lds, dst, ldd, rows, half, kernel);
+		transRecursive(src + half, lds, dst + half * ldd, ldd, rows, cols - half, kernel);
+		return;
+	}
 
-			matrix_destroy(&hMxSub);
+	// transpose the block a tile at a time, then the leftover columns and rows
+	rowsTiled = rows / TRANS_BLOCK * TRANS_BLOCK;
+	colsTiled = cols / TRANS_BLOCK * TRANS_BLOCK;
+	for (int i = 0; i < rowsTiled; i += TRANS_BLOCK) {
+		for (int j = 0; j < colsTiled; j += TRANS_BLOCK)
+			kernel(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+		for (int ii = i; ii < i + TRANS_BLOCK; ++ii) {
+			for (int j = colsTiled; j < cols; ++j)
+				dst[j * ldd + ii] = src[ii * lds + j];
 		}
 	}
-	pMxOfCofactors->maxLength = maxLength;
+	for (int i = rowsTiled; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j)
+			dst[j * ldd + i] = src[i * lds + j];
+	}
+}
 
 
-	// matrix of cofactors has been created
-	// now calculate the transpose of the matrix of cofactors, this is the adjugate matrix
-	if (!matrix_opTrans(hMxOfCofactors, (MATRIX*)ppMxRes)) {
-		matrix_destroy(&hMxOfCofactors);
-		return FAILURE;
+static void transSquareInPlace(double* entries, int n, ptrdiff_t rs, ptrdiff_t cs) {
+	double temp;
+
+	for (int bi = 0; bi < n; bi += TRANS_LEAF) {
+		int iEnd = (n - bi < TRANS_LEAF) ? n : bi + TRANS_LEAF;
+		for (int bj = bi; bj < n; bj += TRANS_LEAF) {
+			int jEnd = (n - bj < TRANS_LEAF) ? n : bj + TRANS_LEAF;
+			for (int i = bi; i < iEnd; ++i) {
+				// on a diagonal block only swap the entries above its diagonal
+				for (int j = (bi == bj) ? i + 1 : bj; j < jEnd; ++j) {
+					temp = entries[i * rs + j * cs];
+					entries[i * rs + j * cs] = entries[j * rs + i * cs];
+					entries[j * rs + i * cs] = temp;
+				}
+			}
+		}
 	}
+}
 
-	matrix_destroy(&hMxOfCofactors);
 
-	return SUCCESS;
+static void vecAdd(int n, const double* x, const double* y, double* z) {
+	for (int i = 0; i < n; ++i)
+		z[i] = x[i] + y[i];
 }
 
 
-static double opDet(Matrix* pMx, Status* pMem) {
-	MATRIX hMxSub;        // recursive submatrix in non-base case
-	Matrix* pMxSub;       // non-handle version of recursive submatrix in non-base case
-	double sum;           // sum in non-base case
-	double entry;         // entry used in non-base case
-	int mxSub_row = 0;    // submatrix row in non-base case
-	int mxSub_col = 0;    // submatrix column in non-base case
+#ifdef SIMD_X86
+__attribute__((target("sse2")))
+static void vecAddSse2(int n, const double* x, const double* y, double* z) {
+	int i;
 
+	for (i = 0; i + 2 <= n; i += 2)
+		_mm_storeu_pd(z + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] + y[i];
+}
 
-	// base case: 2 x 2 matrix
-	if (pMx->rows == 2 && pMx->cols == 2) {
-		double a11 = pMx->entries[at(pMx, 0, 0)];
-		double a21 = pMx->entries[at(pMx, 0, 1)];
-		double a12 = pMx->entries[at(pMx, 1, 0)];
-		double a22 = pMx->entries[at(pMx, 1, 1)];
-		return opDet2x2(a11, a12, a21, a22);
-	}
 
-	// all other cases: recursive calculation
-	sum = 0;
-	for (int col = 0; col < pMx->cols; ++col) {
-		// create the recursive submatrix
-		hMxSub = matrix_initDims(pMx->rows - 1, pMx->cols - 1);
-		if (!hMxSub) {
-			*pMem = FAILURE;
-			return 0;
-		}
-		pMxSub = hMxSub;
-
-		// get one part of the recursive sum
-		// get the a_1_jth entry
-		entry = pMx->entries[at(pMx, 0, col)];
-		mxSub_row = 0;
-		mxSub_col = 0;
-		// get the recursive submatrix
-		for (int row = 1; row < pMx->rows; ++row) {
-			mxSub_col = 0;
-			for (int _col = 0; _col < pMx->cols; ++_col) {
-				if (_col == col)
-					continue;
-				pMxSub->entries[at(hMxSub, mxSub_row, mxSub_col)] = pMx->entries[at(pMx, row, _col)];
-				++mxSub_col;
-			}
-			++mxSub_row;
-		}
+__attribute__((target("avx2")))
+static void vecAddAvx2(int n, const double* x, const double* y, double* z) {
+	int i;
 
-		if (col % 2 == 0)
-			sum += entry * opDet(pMxSub, pMem);
-		else
-			sum -= entry * opDet(pMxSub, pMem);
+	for (i = 0; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(z + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] + y[i];
+}
 
-		matrix_destroy((MATRIX*)(&pMxSub));
-	}
 
-	return sum;
+__attribute__((target("avx512f")))
+static void vecAddAvx512(int n, const double* x, const double* y, double* z) {
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		_mm512_storeu_pd(z + i, _mm512_add_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] + y[i];
 }
+#endif
 
 
-static double opDet2x2(double a11, double a12, double a21, double a22) {
-	return a11 * a22 - a21 * a12;
+static void vecSub(int n, const double* x, const double* y, double* z) {
+	for (int i = 0; i < n; ++i)
+		z[i] = x[i] - y[i];
 }
 
 
-static void removeTrailingZeroes(char* entryStr) {
-	Boolean reachedDecimalPoint = FALSE;
+#ifdef SIMD_X86
+__attribute__((target("sse2")))
+static void vecSubSse2(int n, const double* x, const double* y, double* z) {
+	int i;
 
-	for (int i = strlen(entryStr) - 1; i >= 0 && (entryStr[i] == '0' || entryStr[i] == '.'); --i) {
-		if (reachedDecimalPoint == TRUE)
-			break;
-		if (entryStr[i] == '.')
-			reachedDecimalPoint = TRUE;
-		entryStr[i] = '\0';
-	}
+	for (i = 0; i + 2 <= n; i += 2)
+		_mm_storeu_pd(z + i, _mm_sub_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] - y[i];
+}
+
+
+__attribute__((target("avx2")))
+static void vecSubAvx2(int n, const double* x, const double* y, double* z) {
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(z + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] - y[i];
+}
+
+
+__attribute__((target("avx512f")))
+static void vecSubAvx512(int n, const double* x, const double* y, double* z) {
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		_mm512_storeu_pd(z + i, _mm512_sub_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	for (; i < n; ++i)
+		z[i] = x[i] - y[i];
 }
+#endif
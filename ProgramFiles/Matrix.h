@@ -9,11 +9,349 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <stddef.h>
 #include "Status.h"
 
-typedef void* MATRIX;    // opaque object handle for matrix objects
+typedef void* MATRIX;           // opaque object handle for matrix objects
+typedef void* MATRIX_FACTOR;    // opaque object handle for matrix factorization objects
+typedef void* MATRIX_BANDED;    // opaque object handle for banded matrix objects
+typedef void* MATRIX_SYMMETRIC;    // opaque object handle for symmetric matrix objects
 
+typedef enum simdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 } SimdLevel;    // instruction sets the compute kernels can use
 
+// allocator hooks set with matrix_setAllocator, each gets the userdata it was set with
+// alignment is a power of 2 the memory must start on, 64 for arrays of entries, and size is a multiple of it
+typedef void* (*MatrixAllocFn)(size_t size, size_t alignment, void* userdata);
+typedef void* (*MatrixReallocFn)(void* ptr, size_t size, size_t alignment, void* userdata);
+typedef void (*MatrixFreeFn)(void* ptr, void* userdata);
+
+
+
+
+/*
+FUNCTION
+  - Name:     matrix_alloc
+  - Purpose:  Allocate memory with the allocator set with matrix_setAllocator, or malloc if none is set,
+              so a program using the library can keep its own allocations in the same arena as the matrices.
+              The memory is aligned like malloc's, i.e. to _Alignof(max_align_t).
+PRECONDITION
+  - size
+      Purpose:       Bytes to allocate.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the memory, which must be freed with matrix_free.
+  - Return value:  The memory.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+void* matrix_alloc(size_t size);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedDestroy
+  - Purpose:  Destroy a banded matrix.
+PRECONDITION
+  - phBd
+      Purpose:       Banded matrix to destroy.
+      Restrictions:  Pointer to a handle to a valid banded matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        Handle to a valid banded matrix object.
+  - Summary:       Frees the banded matrix and sets the handle to NULL.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        NULL handle.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_bandedDestroy(MATRIX_BANDED* phBd);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedDet
+  - Purpose:  Calculate the determinant of a banded matrix from its LU factorization with partial pivoting restricted to the band,
+              which takes O(n kl (kl + ku)) operations and O(n (2 kl + ku + 1)) memory instead of O(n^3) and O(n^2).
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to calculate the determinant of.
+      Restrictions:  Handle to a valid banded matrix object.
+  - pMem
+      Purpose:       Indicate if memory allocation fails.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the determinant. For a large matrix it can overflow or underflow, like the determinant of a dense matrix.
+  - Return value:  The determinant, 0 if a pivot is 0.
+  - pMem:          The status it points to is set to SUCCESS.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The determinant isn't calculated.
+  - Return value:  0
+  - pMem:          The status it points to is set to FAILURE.
+*/
+double matrix_bandedDet(MATRIX_BANDED hBd, Status* pMem);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedGetEntry
+  - Purpose:  Get an entry of a banded matrix.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to get the entry of.
+      Restrictions:  Handle to a valid banded matrix object.
+  - row, col
+      Purpose:       Row and column of the entry.
+      Restrictions:  N/A
+  - pEntry
+      Purpose:       Store the entry.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        The row and column are inside the matrix.
+  - Summary:       Stores the entry, which is 0 outside the band.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        The row or column is outside the matrix.
+  - Summary:       Stores 0.
+  - Return value:  FAILURE
+*/
+Status matrix_bandedGetEntry(MATRIX_BANDED hBd, int row, int col, double* pEntry);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedGetLower
+  - Purpose:  Get the lower bandwidth kl of a banded matrix, the number of diagonals below the main diagonal that can hold entries that aren't 0.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to get the lower bandwidth of.
+      Restrictions:  Handle to a valid banded matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the lower bandwidth.
+  - Return value:  Any integer >= 0.
+Failure
+  - N/A
+*/
+int matrix_bandedGetLower(MATRIX_BANDED hBd);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedGetRows
+  - Purpose:  Get the rows of a banded matrix, which equal its columns.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to get the rows of.
+      Restrictions:  Handle to a valid banded matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the rows.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int matrix_bandedGetRows(MATRIX_BANDED hBd);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedGetUpper
+  - Purpose:  Get the upper bandwidth ku of a banded matrix, the number of diagonals above the main diagonal that can hold entries that aren't 0.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to get the upper bandwidth of.
+      Restrictions:  Handle to a valid banded matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the upper bandwidth.
+  - Return value:  Any integer >= 0.
+Failure
+  - N/A
+*/
+int matrix_bandedGetUpper(MATRIX_BANDED hBd);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedInit
+  - Purpose:  Initialize an n x n banded matrix of zeros that stores only the main diagonal, kl diagonals below it and ku diagonals above it,
+              which is n (kl + ku + 1) entries instead of n^2. A tridiagonal matrix has kl = ku = 1.
+PRECONDITION
+  - n
+      Purpose:       Rows and columns of the matrix.
+      Restrictions:  Any positive integer.
+  - kl, ku
+      Purpose:       Diagonals below and above the main diagonal that can hold entries that aren't 0.
+      Restrictions:  Any integers >= 0. Values past n - 1 are reduced to n - 1.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and valid dimensions.
+  - Summary:       Initializes and returns the banded matrix.
+  - Return value:  Handle to a valid banded matrix object.
+Failure
+  - Reason:        Memory allocation failure or invalid dimensions.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_BANDED matrix_bandedInit(int n, int kl, int ku);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedInitDense
+  - Purpose:  Initialize a banded matrix with the entries of a square matrix inside a band.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to convert.
+      Restrictions:  Handle to a valid matrix object.
+  - kl, ku
+      Purpose:       Same as matrix_bandedInit.
+      Restrictions:  Same as matrix_bandedInit.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and hMx is square.
+  - Summary:       Initializes and returns a banded matrix with the entries of hMx inside the band. The entries outside of it are dropped.
+  - Return value:  Handle to a valid banded matrix object.
+Failure
+  - Reason:        Memory allocation failure or hMx isn't square.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_BANDED matrix_bandedInitDense(MATRIX hMx, int kl, int ku);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedMult
+  - Purpose:  Multiply a banded matrix A by a matrix B in O(n (kl + ku + 1) cols) operations, since row i of A B only combines the rows of B inside the band of row i.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix A.
+      Restrictions:  Handle to a valid banded matrix object.
+  - hMx
+      Purpose:       Matrix B.
+      Restrictions:  Handle to a valid matrix object. The rows equal the rows of A.
+  - phMxRes
+      Purpose:       Store the product.
+      Restrictions:  Pointer to a handle to a valid matrix object other than hMx or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the dimensions agree.
+  - Summary:       Stores A B.
+  - Return value:  SUCCESS
+  - phMxRes:       Stores the product.
+                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:        Memory allocation failure or the dimensions don't agree.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_bandedMult(MATRIX_BANDED hBd, MATRIX hMx, MATRIX* phMxRes);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedSetEntry
+  - Purpose:  Set an entry inside the band of a banded matrix.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to set the entry of.
+      Restrictions:  Handle to a valid banded matrix object.
+  - row, col
+      Purpose:       Row and column of the entry.
+      Restrictions:  N/A
+  - entry
+      Purpose:       Value of the entry.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        The entry is inside the matrix and its band.
+  - Summary:       Sets the entry.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        The entry is outside the matrix or its band.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_bandedSetEntry(MATRIX_BANDED hBd, int row, int col, double entry);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedSolve
+  - Purpose:  Solve the linear system A X = B for a banded matrix A with its LU factorization with partial pivoting restricted to the band.
+              It takes O(n kl (kl + ku)) operations to factor A and O(n (2 kl + ku + 1)) per column of B, so a tridiagonal system of 10^6 rows is solved in O(n) like the Thomas algorithm,
+              but pivoting keeps it stable for matrices that aren't diagonally dominant.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix A.
+      Restrictions:  Handle to a valid banded matrix object.
+  - hMxB
+      Purpose:       Right-hand side B with one column per system.
+      Restrictions:  Handle to a valid matrix object. The rows equal the rows of A.
+  - pMxIsInvertible
+      Purpose:       Indicate if A is invertible (determinant is 0).
+                     If A is invertible, the system has no unique solution.
+      Restrictions:  Not NULL.
+  - phMxX
+      Purpose:       Store the solution X.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+                     It may point to hMxB to solve in place.
+POSTCONDITION
+Success
+  - Reason:           No memory allocation failure and A is vertible.
+  - Summary:          Solves the system and stores the solution in the result matrix.
+  - Return value:     SUCCESS
+  - pMxIsInvertible:  The Boolean it points to is set to FALSE.
+  - phMxX:            Stores the solution with the same dimensions as B.
+                      If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                      If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:           Memory allocation failure, the dimensions don't agree or A is invertible.
+  - Summary:          The system isn't solved and nothing of significance happens.
+  - Return value:     FAILURE
+  - pMxIsInvertible:  The Boolean it points to is set to TRUE if A is invertible and FALSE otherwise.
+*/
+Status matrix_bandedSolve(MATRIX_BANDED hBd, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX);
+
+
+/*
+FUNCTION
+  - Name:     matrix_bandedToDense
+  - Purpose:  Convert a banded matrix to a matrix object.
+PRECONDITION
+  - hBd
+      Purpose:       Banded matrix to convert.
+      Restrictions:  Handle to a valid banded matrix object.
+  - phMxRes
+      Purpose:       Store the matrix.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Stores the matrix with zeros outside the band.
+                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_bandedToDense(MATRIX_BANDED hBd, MATRIX* phMxRes);
 
 
 /*
@@ -171,6 +509,7 @@ Success
   - Summary:       Destroys the matrix.
   - Return value:  SUCCESS
   - phMx:          Frees all memory associated with the matrix and sets the handle to NULL.
+                   The entries of a view belong to the matrix it views, so only the view itself is freed.
 Failure
   - Reason:        The handle it points to is NULL.
   - Summary:       No matrix is destroyed and nothing of significance happens.
@@ -182,103 +521,392 @@ Status matrix_destroy(MATRIX* phMx);
 
 /*
 FUNCTION
-  - Name:     matrix_getEntry
-  - Purpose:  Get the entry of a matrix at a row-column coordinate.
+  - Name:     matrix_factorCanBeInv
+  - Purpose:  Determine if the factored matrix can be inverted (is vertible).
+              A matrix is vertible if its determinant isn't 0.
 PRECONDITION
-  - hMx
-      Purpose:       Matrix to get the entry of.
-      Restrictions:  Handle to a valid matrix object.
-  - row
-      Purpose:       Index of the row of the entry (i.e. row 1 = index 0).
-      Restrictions:  Any integer >= 0.
-  - col
-      Purpose:       Index of the column of the entry (i.e. column 1 = index 0).
-      Restrictions:  Any integer >= 0.
-  - pEntry
-      Purpose:       Store the entry.
-      Restrictions:  Not NULL.
+  - hFac
+      Purpose:       Factorization of the matrix to check.
+      Restrictions:  Handle to a valid matrix factorization object.
 POSTCONDITION
 Success
-  - Reason:        The row-column coordinate is in bounds.
-  - Summary:       Gets the entry of the matrix at the row-column coordinate.
-  - Return value:  SUCCESS
-  - hMx:           The state of the matrix before the function call is preserved.
-  - pEntry:        The integer it points to is set to the entry at the row-column coordinate.
+  - Reason:        All cases.
+  - Summary:       The correct value is returned accordingly without refactoring the matrix.
+  - Return value:  TRUE if the factored matrix can be inverted.
+                   FALSE if otherwise.
+  - hFac:          The state of the factorization before the function call is preserved.
 Failure
-  - Reason:        The row-column coordinate is out of bounds.
-  - Summary:       Doesn't get the entry of the matrix at the row-column coordinate and nothing of significance happens.
-  - Return value:  FAILURE
-  - hMx:           The state of the matrix before the function call is preserved.
-  - pEntry:        The integer it points to is set to the special value of 0.
+  - N/A
 */
-Status matrix_getEntry(MATRIX hMx, int row, int col, double* pEntry);
+Boolean matrix_factorCanBeInv(MATRIX_FACTOR hFac);
 
 
 /*
 FUNCTION
-  - Name:     matrix_initCopy
-  - Purpose:  Initializes a new matrix that's a copy of another.
-              C Opaque object design version of the copy constructor in C++.
+  - Name:     matrix_factorDestroy
+  - Purpose:  Destroys a matrix factorization.
 PRECONDITION
-  - hMxSrc
-      Purpose:       Matrix object to copy from.
-      Restrictions:  Handle to a valid matrix object.
+  - phFac
+      Purpose:       Factorization to destroy.
+      Restrictions:  Pointer to a handle to a valid matrix factorization object or NULL handle.
 POSTCONDITION
 Success
-  - Reason:        No memory allocation failure.
-  - Summary:       Initializes and returns a new matrix that's a copy of hMxSrc.
-  - Return value:  Handle to a valid matrix object that's a copy of hMxSrc.
-  - hMxSrc:        The state of the matrix before the function call is preserved.
+  - Reason:        The handle it points to stores a valid matrix factorization object.
+  - Summary:       Destroys the factorization.
+  - Return value:  SUCCESS
+  - phFac:         Frees all memory associated with the factorization and sets the handle to NULL.
 Failure
-  - Reason:        Memory allocation failure.
-  - Summary:       Doesn't initialize and return a new matrix and nothing of significance happens.
-  - Return value:  NULL
-  - hMxSrc:        The state of the matrix before the function call is preserved.
+  - Reason:        The handle it points to is NULL.
+  - Summary:       No factorization is destroyed and nothing of significance happens.
+  - Return value:  FAILURE
+  - phFac:         The handle it points to remains NULL.
 */
-MATRIX matrix_initCopy(MATRIX hMxSrc);
+Status matrix_factorDestroy(MATRIX_FACTOR* phFac);
 
 
 /*
 FUNCTION
-  - Name:     matrix_initMove
-  - Purpose:  Initialize a new matrix handle by moving an existing matrix in a source handle into the new handle.
-              It is a transfer of ownership of the matrix and not a copy.
-              C Opaque object design version of the move constructor in C++.
+  - Name:     matrix_factorDet
+  - Purpose:  Calculate the determinant of the factored matrix.
 PRECONDITION
-  - phMxSrc
-      Purpose:       Pointer to the matrix handle to move from.
-      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+  - hFac
+      Purpose:       Factorization of the matrix to calculate the determinant of.
+      Restrictions:  Handle to a valid matrix factorization object.
 POSTCONDITION
 Success
-  - Reason:        The handle pointed to by phMxSrc is a handle to a valid matrix object.
-  - Summary:       Initializes a new matrix handle by moving an existing matrix in a source handle into the new handle.
-                   The source handle loses ownership of the matrix object.
-  - Return value:  Handle to a valid matrix object that is the same matrix of the handle pointed to by phMxSrc.
-  - phMxSrc:       The handle it points to loses ownership of the matrix and is set to NULL.
+  - Reason:        All cases.
+  - Summary:       Calculates the determinant from the pivots of the factorization in O(n).
+  - Return value:  The determinant of the factored matrix.
+  - hFac:          The state of the factorization before the function call is preserved.
 Failure
-  - Reason:        The handle pointed to by phMxSrc is a NULL handle.
-  - Summary:       Doesn't initialize a new matrix handle and nothing of significance happens.
-  - Return value:  NULL
-  - phMxSrc:       The handle it points to remains NULL.
+  - N/A
 */
-MATRIX matrix_initMove(MATRIX* phMxSrc);
+double matrix_factorDet(MATRIX_FACTOR hFac);
 
 
 /*
 FUNCTION
-  - Name:     matrix_initDims
-  - Purpose:  Initialize a new matrix with a given amount of rows and columns and the entries in a default state.
+  - Name:     matrix_factorInv
+  - Purpose:  Perform the matrix inverse operation using an existing factorization of the matrix.
 PRECONDITION
-  - rows
-      Purpose:       Rows of the new matrix.
-      Restrictions:  Any positive integer.
-  - columns
-      Purpose:       Columns of the matrix.
-      Restrictions:  Any positive integer.
+  - hFac
+      Purpose:       Factorization of the matrix to calculate the inverse of.
+      Restrictions:  Handle to a valid matrix factorization object.
+  - pMxIsInvertible
+      Purpose:       Indicate if the matrix is invertible (determinant is 0).
+                     If a matrix is invertible, its inverse can't be calculated.
+      Restrictions:  Not NULL.
+  - phMxRes
+      Purpose:       Store the matrix that is the result of the inverse operation.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
 POSTCONDITION
 Success
-  - Reason:        No memory allocation failure.
-  - Summary:       Initializes and returns a new matrix with the given amount of rows and columns.
+  - Reason:           No memory allocation failure and matrix is vertible.
+  - Summary:          Performs the matrix inverse operation and stores the inverted matrix in the result matrix.
+  - Return value:     SUCCESS
+  - hFac:             The state of the factorization before the function call is preserved.
+  - pMxIsInvertible:  The Boolean it points to is set to FALSE.
+  - phMxRes:          Stores the inverted matrix that is the result of the inverse operation.
+                      If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                      If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:           Memory allocation failure or matrix is invertible.
+  - Summary:          The inverse operation isn't performed and nothing of significance happens.
+  - Return value:     FAILURE
+  - hFac:             The state of the factorization before the function call is preserved.
+  - pMxIsInvertible:  The Boolean it points to is set to TRUE if the matrix is invertible and FALSE if there is memory allocation failure.
+  - phMxRes:          If it was a pointer to a handle to a valid matrix object before the function call, the state of the matrix before the function call is preserved.
+                      If it was a pointer to a NULL handle before the function call, the handle remains NULL.
+*/
+Status matrix_factorInv(MATRIX_FACTOR hFac, Boolean* pMxIsInvertible, MATRIX* phMxRes);
+
+
+/*
+FUNCTION
+  - Name:     matrix_factorize
+  - Purpose:  Initialize a new factorization of a matrix.
+              The matrix is factored once with LU and partial pivoting so its determinant, invertibility, inverse, and linear solves can be queried repeatedly without refactoring it.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to factor.
+      Restrictions:  Handle to a valid matrix object.
+                     The rows equal the columns.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Factors the matrix and returns the factorization.
+                   A singular matrix still has a factorization, it just reports a determinant of 0 and can't be inverted or solved.
+                   The factorization is independent of the matrix and isn't affected by later changes to it.
+  - Return value:  Handle to a valid matrix factorization object.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Doesn't initialize and return a new factorization and nothing of significance happens.
+  - Return value:  NULL
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+MATRIX_FACTOR matrix_factorize(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_factorSolve
+  - Purpose:  Solve the linear system A X = B for X using an existing factorization of A.
+PRECONDITION
+  - hFac
+      Purpose:       Factorization of A.
+      Restrictions:  Handle to a valid matrix factorization object.
+  - hMxB
+      Purpose:       Right-hand side B with one column per system.
+      Restrictions:  Handle to a valid matrix object.
+                     The rows equal the rows of A.
+  - pMxIsInvertible
+      Purpose:       Indicate if A is invertible (determinant is 0).
+                     If A is invertible, the system has no unique solution.
+      Restrictions:  Not NULL.
+  - phMxX
+      Purpose:       Store the solution X.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+                     It may point to hMxB to solve in place.
+POSTCONDITION
+Success
+  - Reason:           No memory allocation failure and A is vertible.
+  - Summary:          Solves the system and stores the solution in the result matrix.
+  - Return value:     SUCCESS
+  - hFac:             The state of the factorization before the function call is preserved.
+  - hMxB:             The state of the matrix before the function call is preserved unless phMxX points to it.
+  - pMxIsInvertible:  The Boolean it points to is set to FALSE.
+  - phMxX:            Stores the solution with the same dimensions as B.
+                      If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                      If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:           Memory allocation failure or A is invertible.
+  - Summary:          The system isn't solved and nothing of significance happens.
+  - Return value:     FAILURE
+  - hFac:             The state of the factorization before the function call is preserved.
+  - hMxB:             The state of the matrix before the function call is preserved.
+  - pMxIsInvertible:  The Boolean it points to is set to TRUE if A is invertible and FALSE if there is memory allocation failure.
+  - phMxX:            If it was a pointer to a handle to a valid matrix object before the function call, the state of the matrix before the function call is preserved.
+                      If it was a pointer to a NULL handle before the function call, the handle remains NULL.
+*/
+Status matrix_factorSolve(MATRIX_FACTOR hFac, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX);
+
+
+/*
+FUNCTION
+  - Name:     matrix_free
+  - Purpose:  Free memory allocated with matrix_alloc.
+PRECONDITION
+  - ptr
+      Purpose:       Memory to free.
+      Restrictions:  Memory allocated with matrix_alloc under the allocator currently set, or NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Frees the memory.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+void matrix_free(void* ptr);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getCols
+  - Purpose:  Get the columns of a matrix.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to get the columns of.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the columns.
+  - Return value:  Any positive integer.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - N/A
+*/
+int matrix_getCols(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getEntry
+  - Purpose:  Get the entry of a matrix at a row-column coordinate.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to get the entry of.
+      Restrictions:  Handle to a valid matrix object.
+  - row
+      Purpose:       Index of the row of the entry (i.e. row 1 = index 0).
+      Restrictions:  Any integer >= 0.
+  - col
+      Purpose:       Index of the column of the entry (i.e. column 1 = index 0).
+      Restrictions:  Any integer >= 0.
+  - pEntry
+      Purpose:       Store the entry.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        The row-column coordinate is in bounds.
+  - Summary:       Gets the entry of the matrix at the row-column coordinate.
+  - Return value:  SUCCESS
+  - hMx:           The state of the matrix before the function call is preserved.
+  - pEntry:        The integer it points to is set to the entry at the row-column coordinate.
+Failure
+  - Reason:        The row-column coordinate is out of bounds.
+  - Summary:       Doesn't get the entry of the matrix at the row-column coordinate and nothing of significance happens.
+  - Return value:  FAILURE
+  - hMx:           The state of the matrix before the function call is preserved.
+  - pEntry:        The integer it points to is set to the special value of 0.
+*/
+Status matrix_getEntry(MATRIX hMx, int row, int col, double* pEntry);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getNumThreads
+  - Purpose:  Get the number of threads the multiplication operation uses for large matrices.
+              Unless set with matrix_setNumThreads, on first use it is read from the environment variable MATRIX_NUM_THREADS
+              or, if that isn't a positive integer, set to the number of online processors.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the number of threads, counting the thread that calls the operation.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int matrix_getNumThreads(void);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getRows
+  - Purpose:  Get the rows of a matrix.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to get the rows of.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the rows.
+  - Return value:  Any positive integer.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - N/A
+*/
+int matrix_getRows(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getSimdLevel
+  - Purpose:  Get the instruction set used by the multiplication, addition, subtraction and transpose kernels.
+              On first use the best instruction set supported by the CPU is detected and selected.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the instruction set in use.
+  - Return value:  SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 (with FMA) or SIMD_AVX512.
+Failure
+  - N/A
+*/
+SimdLevel matrix_getSimdLevel(void);
+
+
+/*
+FUNCTION
+  - Name:     matrix_getSize
+  - Purpose:  Get the number of entries of a matrix, rows * columns, which can exceed INT_MAX even though each dimension fits in an int.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to get the size of.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the number of entries.
+  - Return value:  Any positive integer.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - N/A
+*/
+size_t matrix_getSize(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_initCopy
+  - Purpose:  Initializes a new matrix that's a copy of another.
+              C Opaque object design version of the copy constructor in C++.
+PRECONDITION
+  - hMxSrc
+      Purpose:       Matrix object to copy from.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Initializes and returns a new matrix that's a copy of hMxSrc.
+  - Return value:  Handle to a valid matrix object that's a copy of hMxSrc.
+  - hMxSrc:        The state of the matrix before the function call is preserved.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Doesn't initialize and return a new matrix and nothing of significance happens.
+  - Return value:  NULL
+  - hMxSrc:        The state of the matrix before the function call is preserved.
+*/
+MATRIX matrix_initCopy(MATRIX hMxSrc);
+
+
+/*
+FUNCTION
+  - Name:     matrix_initMove
+  - Purpose:  Initialize a new matrix handle by moving an existing matrix in a source handle into the new handle.
+              It is a transfer of ownership of the matrix and not a copy.
+              C Opaque object design version of the move constructor in C++.
+PRECONDITION
+  - phMxSrc
+      Purpose:       Pointer to the matrix handle to move from.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        The handle pointed to by phMxSrc is a handle to a valid matrix object.
+  - Summary:       Initializes a new matrix handle by moving an existing matrix in a source handle into the new handle.
+                   The source handle loses ownership of the matrix object.
+  - Return value:  Handle to a valid matrix object that is the same matrix of the handle pointed to by phMxSrc.
+  - phMxSrc:       The handle it points to loses ownership of the matrix and is set to NULL.
+Failure
+  - Reason:        The handle pointed to by phMxSrc is a NULL handle.
+  - Summary:       Doesn't initialize a new matrix handle and nothing of significance happens.
+  - Return value:  NULL
+  - phMxSrc:       The handle it points to remains NULL.
+*/
+MATRIX matrix_initMove(MATRIX* phMxSrc);
+
+
+/*
+FUNCTION
+  - Name:     matrix_initDims
+  - Purpose:  Initialize a new matrix with a given amount of rows and columns and the entries in a default state.
+PRECONDITION
+  - rows
+      Purpose:       Rows of the new matrix.
+      Restrictions:  Any positive integer.
+  - columns
+      Purpose:       Columns of the matrix.
+      Restrictions:  Any positive integer. Only each dimension is limited to INT_MAX, the entries rows * columns are counted with size_t and can exceed it.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Initializes and returns a new matrix with the given amount of rows and columns.
                    The value of every entry is 0 by default.
   - Return value:  Handle to a valid matrix object in the state as described above.
 Failure
@@ -392,6 +1020,7 @@ Status matrix_opAdd(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes);
 FUNCTION
   - Name:     matrix_opDet
   - Purpose:  Perform the matrix determinant operation.
+              The determinant of a triangular matrix is the product of its diagonal, found in O(n) once the matrix is known to be triangular.
 PRECONDITION
   - hMx
       Purpose:       Matrix to calculate the determinant of.
@@ -417,10 +1046,45 @@ Failure
 double matrix_opDet(MATRIX hMx, Status* pMem);
 
 
+/*
+FUNCTION
+  - Name:     matrix_opGram
+  - Purpose:  Calculate the Gram matrix A^T A of the columns of A directly into a symmetric matrix.
+              Only the upper triangle is calculated, in blocks of rows multiplied with the same kernel as matrix_opMult,
+              so it takes about half the operations of matrix_opTrans and matrix_opMult and never stores A^T.
+              A A^T, the Gram matrix of the rows, is the Gram matrix of the view matrix_viewTrans(A).
+PRECONDITION
+  - hMxA
+      Purpose:       Matrix A.
+      Restrictions:  Handle to a valid matrix object.
+  - phSymRes
+      Purpose:       Store A^T A.
+      Restrictions:  Pointer to a handle to a valid symmetric matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates A^T A, whose rows and columns are the columns of A.
+  - Return value:  SUCCESS
+  - hMxA:          The state of the matrix before the function call is preserved.
+  - phSymRes:      Stores A^T A.
+                   If it was a pointer to a handle to a valid symmetric matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new symmetric matrix gets created to store the result.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The Gram matrix isn't calculated.
+  - Return value:  FAILURE
+  - hMxA:          The state of the matrix before the function call is preserved.
+  - phSymRes:      If it was a pointer to a NULL handle before the function call, the handle remains NULL.
+                   Otherwise its entries are unspecified.
+*/
+Status matrix_opGram(MATRIX hMxA, MATRIX_SYMMETRIC* phSymRes);
+
+
 /*
 FUNCTION
   - Name:     matrix_opInv
   - Purpose:  Perform the matrix inverse operation.
+              A diagonal matrix is inverted in O(n) by taking the reciprocal of each entry of its diagonal.
 PRECONDITION
   - hMx
       Purpose:       Matrix to calculate the inverse of.
@@ -463,6 +1127,7 @@ Status matrix_opInv(MATRIX hMx, Boolean* pMxIsInvertible, MATRIX* phMxRes);
 FUNCTION
   - Name:     matrix_opMult
   - Purpose:  Performs the matrix multiplication operation.
+              A diagonal factor scales the rows or columns of the other factor and a permutation factor reorders them, without the O(n^3) product.
 PRECONDITION
   - hMx1
       Purpose:       Matrix to be multiplied with the other matrix.
@@ -501,6 +1166,7 @@ Status matrix_opMult(MATRIX hMx1, MATRIX hMx2, MATRIX* phMxRes);
 FUNCTION
   - Name:     matrix_opPow
   - Purpose:  Performs the matrix power operation.
+              A diagonal matrix is raised to the power in O(n) by raising each entry of its diagonal.
 PRECONDITION
   - hMx
       Purpose:       Matrix to perform the power operation on.
@@ -531,6 +1197,55 @@ Failure
 Status matrix_opPow(MATRIX hMx, int power, MATRIX* phMxRes);
 
 
+/*
+FUNCTION
+  - Name:     matrix_opSolve
+  - Purpose:  Solve the linear system A X = B for X without forming the inverse of A.
+              Every column of B is a separate right-hand side and all of them are solved with one factorization of A.
+PRECONDITION
+  - hMxA
+      Purpose:       Coefficient matrix A.
+      Restrictions:  Handle to a valid matrix object.
+                     The rows equal the columns.
+  - hMxB
+      Purpose:       Right-hand side B with one column per system.
+      Restrictions:  Handle to a valid matrix object.
+                     The rows equal the rows of A.
+  - pMxIsInvertible
+      Purpose:       Indicate if A is invertible (determinant is 0).
+                     If A is invertible, the system has no unique solution.
+      Restrictions:  Not NULL.
+  - phMxX
+      Purpose:       Store the solution X.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+                     It may point to hMxB to solve in place.
+POSTCONDITION
+Success
+  - Reason:           No memory allocation failure and A is vertible.
+  - Summary:          Solves the system and stores the solution in the result matrix.
+  - Return value:     SUCCESS
+  - hMxA:             The state of the matrix before the function call is preserved.
+  - hMxB:             The state of the matrix before the function call is preserved unless phMxX points to it.
+  - pMxIsInvertible:  The Boolean it points to is set to FALSE.
+  - phMxX:            Stores the solution with the same dimensions as B.
+                      If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                      If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:           Memory allocation failure or A is invertible.
+  - Summary:          The system isn't solved and nothing of significance happens.
+  - Return value:     FAILURE
+  - hMxA:             The state of the matrix before the function call is preserved.
+  - hMxB:             The state of the matrix before the function call is preserved.
+  - pMxIsInvertible:  The Boolean it points to is set accordingly.
+                        - FALSE is there is memory allocation failure.
+                          This doesn't necessarily mean A is vertible.
+                        - TRUE if otherwise.
+  - phMxX:            If it was a pointer to a handle to a valid matrix object before the function call, the state of the matrix before the function call is preserved.
+                      If it was a pointer to a NULL handle before the function call, the handle remains NULL.
+*/
+Status matrix_opSolve(MATRIX hMxA, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX);
+
+
 /*
 FUNCTION
   - Name:     matrix_opSub
@@ -569,6 +1284,7 @@ Status matrix_opSub(MATRIX* hMxs, int hMxsSize, MATRIX* phMxRes);
 FUNCTION
   - Name:     matrix_opTrans
   - Purpose:  Perform the matrix transpose operation.
+              Use matrix_viewTrans instead when the transpose doesn't need its own copy of the entries.
 PRECONDITION
   - hMx
       Purpose:       Matrix to be transposed.
@@ -596,6 +1312,31 @@ Failure
 Status matrix_opTrans(MATRIX hMx, MATRIX* phMxRes);
 
 
+/*
+FUNCTION
+  - Name:     matrix_opTransInPlace
+  - Purpose:  Perform the matrix transpose operation in place, without a second matrix of entries.
+              Square matrices swap entries across the diagonal a block at a time.
+              Rectangular matrices move each entry along the cycles of the transpose permutation, which needs one bit of scratch memory per entry.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to be transposed.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Performs the matrix transpose operation and stores the result in the matrix.
+  - Return value:  SUCCESS
+  - hMx:           Stores the transpose. Its rows and columns are swapped.
+Failure
+  - Reason:        Memory allocation failure (rectangular matrices only).
+  - Summary:       The matrix isn't transposed and nothing of significance happens.
+  - Return value:  FAILURE
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+Status matrix_opTransInPlace(MATRIX hMx);
+
+
 /*
 FUNCTION
   - Name:     matrix_print
@@ -616,6 +1357,92 @@ Failure
 void matrix_print(MATRIX hMx);
 
 
+/*
+FUNCTION
+  - Name:     matrix_releaseCaches
+  - Purpose:  Return the memory the library keeps between operations to the allocator it came from:
+              the scratch arena of every thread that ran an operation and the headers of destroyed matrices pooled for reuse.
+              With a bump allocator set with matrix_setAllocator, destroying the matrices of a batch and calling this leaves nothing allocated from it,
+              so it can be reset without setting the allocator again. The arenas grow back on demand.
+              Must not be called while another thread is using the library.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Frees the memory of every scratch arena and every pooled header.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+void matrix_releaseCaches(void);
+
+
+/*
+FUNCTION
+  - Name:     matrix_reserve
+  - Purpose:  Make sure a matrix can hold a given number of entries without allocating memory again.
+              A matrix keeps its memory when it shrinks, so it only allocates when it grows past the most entries it has held.
+              Reserving the largest size up front lets a result matrix that is reused in a loop with different dimensions never allocate.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to reserve memory for.
+      Restrictions:  Handle to a valid matrix object.
+  - capacity
+      Purpose:       Number of entries the matrix must be able to hold.
+      Restrictions:  Any integer >= 0, including more than INT_MAX.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the matrix isn't a view.
+  - Summary:       Grows the memory of the matrix if it can't hold capacity entries. Its dimensions and entries are preserved.
+  - Return value:  SUCCESS
+  - hMx:           Can hold at least capacity entries.
+Failure
+  - Reason:        Memory allocation failure, or the matrix is a view, which doesn't own its entries.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+Status matrix_reserve(MATRIX hMx, size_t capacity);
+
+
+/*
+FUNCTION
+  - Name:     matrix_setAllocator
+  - Purpose:  Route every allocation of the library through custom hooks, e.g. a jemalloc arena or a bump allocator whose free does nothing
+              and whose memory is released in one shot once a batch of matrices is done.
+              Matrices, factorizations, their entries and the temporaries of the operations all come from the hooks.
+              Temporaries come from a scratch arena per thread and destroyed matrix headers are pooled per thread, both kept between operations,
+              so memory from the hooks must stay valid until matrix_releaseCaches or matrix_setAllocator returns them to the hooks they came from.
+              Every allocation passes the alignment it needs, so entries are 64 byte aligned with hooks as with the default allocator, which also backs large ones with huge pages.
+              Memory is freed with the allocator set when it's freed, so it must only be changed while nothing allocated with the previous one is alive,
+              and not while another thread is using the library.
+PRECONDITION
+  - allocFn
+      Purpose:       Allocate size bytes starting on a multiple of alignment, returning NULL on failure.
+      Restrictions:  NULL to restore the default allocator.
+  - reallocFn
+      Purpose:       Resize memory from allocFn to size bytes starting on a multiple of alignment, keeping its contents, returning NULL and leaving the memory alone on failure.
+      Restrictions:  NULL to allocate, copy and free instead, e.g. if the hooks wrap realloc, which only keeps the alignment of malloc.
+  - freeFn
+      Purpose:       Free memory from allocFn or reallocFn. It is never called with NULL.
+      Restrictions:  NULL if and only if allocFn is NULL.
+  - userdata
+      Purpose:       Passed to every hook.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        allocFn and freeFn are both set or both NULL.
+  - Summary:       Sets the allocator for all subsequent allocations.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Only one of allocFn and freeFn is NULL.
+  - Summary:       The allocator in use is preserved.
+  - Return value:  FAILURE
+*/
+Status matrix_setAllocator(MatrixAllocFn allocFn, MatrixReallocFn reallocFn, MatrixFreeFn freeFn, void* userdata);
+
+
 /*
 FUNCTION
   - Name:     matrix_setEntry
@@ -648,4 +1475,369 @@ Failure
 Status matrix_setEntry(MATRIX hMx, int row, int col, double entry);
 
 
+/*
+FUNCTION
+  - Name:     matrix_setNumThreads
+  - Purpose:  Set the number of threads the multiplication operation uses for large matrices.
+              The threads are kept between operations and are replaced when the number changes.
+PRECONDITION
+  - numThreads
+      Purpose:       Number of threads, counting the thread that calls the operation.
+      Restrictions:  Any integer.
+POSTCONDITION
+Success
+  - Reason:        numThreads is positive.
+  - Summary:       Sets the number of threads for all subsequent operations.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        numThreads isn't positive.
+  - Summary:       The number of threads is preserved.
+  - Return value:  FAILURE
+*/
+Status matrix_setNumThreads(int numThreads);
+
+
+/*
+FUNCTION
+  - Name:     matrix_setSimdLevel
+  - Purpose:  Select the instruction set used by the multiplication, addition, subtraction and transpose kernels.
+              Mainly useful to compare a SIMD kernel against the scalar one.
+              Addition, subtraction and transpose give identical results at every level.
+              Multiplication with SIMD_AVX2 or SIMD_AVX512 uses fused multiply-add and a different summation order so it can differ from SIMD_SCALAR by rounding error.
+PRECONDITION
+  - level
+      Purpose:       Instruction set to use.
+      Restrictions:  Any SimdLevel.
+POSTCONDITION
+Success
+  - Reason:        The CPU and compiler support the instruction set.
+  - Summary:       Selects the instruction set for all subsequent operations.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        The CPU or compiler doesn't support the instruction set.
+  - Summary:       The instruction set in use is preserved.
+  - Return value:  FAILURE
+*/
+Status matrix_setSimdLevel(SimdLevel level);
+
+
+/*
+FUNCTION
+  - Name:     matrix_shrinkToFit
+  - Purpose:  Free the memory a matrix kept from when it held more entries than it does now.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to shrink.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the matrix isn't a view.
+  - Summary:       Shrinks the memory of the matrix to its rows times its columns. Its dimensions and entries are preserved.
+  - Return value:  SUCCESS
+  - hMx:           Holds only its entries.
+Failure
+  - Reason:        Memory allocation failure, or the matrix is a view, which doesn't own its entries.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+Status matrix_shrinkToFit(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricCholesky
+  - Purpose:  Calculate the Cholesky factorization A = R^T R of a symmetric positive definite matrix A, such as a Gram matrix of linearly independent columns,
+              with R upper triangular and a positive diagonal. It takes n^3 / 3 operations, half as many as the LU factorization of matrix_factorize.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix A.
+      Restrictions:  Handle to a valid symmetric matrix object.
+  - pMxIsPosDef
+      Purpose:       Indicate if A is positive definite.
+                     A pivot that isn't positive or is reduced to rounding noise means it isn't, such as for the Gram matrix of linearly dependent columns.
+                     Note that TRUE means A is positive definite, the opposite sense of pMxIsInvertible in the other operations, which is TRUE when the matrix can't be inverted.
+      Restrictions:  Not NULL.
+  - phMxR
+      Purpose:       Store R.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and A is positive definite.
+  - Summary:       Factors A and stores R with zeros below the diagonal.
+  - Return value:  SUCCESS
+  - pMxIsPosDef:   The Boolean it points to is set to TRUE.
+  - phMxR:         Stores R.
+                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:        Memory allocation failure or A isn't positive definite.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - pMxIsPosDef:   The Boolean it points to is set to FALSE if A isn't positive definite and TRUE otherwise.
+*/
+Status matrix_symmetricCholesky(MATRIX_SYMMETRIC hSym, Boolean* pMxIsPosDef, MATRIX* phMxR);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricDestroy
+  - Purpose:  Destroy a symmetric matrix.
+PRECONDITION
+  - phSym
+      Purpose:       Symmetric matrix to destroy.
+      Restrictions:  Pointer to a handle to a valid symmetric matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        Handle to a valid symmetric matrix object.
+  - Summary:       Frees the symmetric matrix and sets the handle to NULL.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        NULL handle.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_symmetricDestroy(MATRIX_SYMMETRIC* phSym);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricGetEntry
+  - Purpose:  Get an entry of a symmetric matrix. Entries (row, col) and (col, row) are the same entry.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix to get the entry of.
+      Restrictions:  Handle to a valid symmetric matrix object.
+  - row, col
+      Purpose:       Row and column of the entry.
+      Restrictions:  N/A
+  - pEntry
+      Purpose:       Store the entry.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        The row and column are inside the matrix.
+  - Summary:       Stores the entry.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        The row or column is outside the matrix.
+  - Summary:       Stores 0.
+  - Return value:  FAILURE
+*/
+Status matrix_symmetricGetEntry(MATRIX_SYMMETRIC hSym, int row, int col, double* pEntry);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricGetRows
+  - Purpose:  Get the rows of a symmetric matrix, which equal its columns.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix to get the rows of.
+      Restrictions:  Handle to a valid symmetric matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the rows.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int matrix_symmetricGetRows(MATRIX_SYMMETRIC hSym);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricInit
+  - Purpose:  Initialize an n x n symmetric matrix of zeros that stores only its upper triangle packed row by row, n (n + 1) / 2 entries instead of n^2.
+PRECONDITION
+  - n
+      Purpose:       Rows and columns of the matrix.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and valid dimensions.
+  - Summary:       Initializes and returns the symmetric matrix.
+  - Return value:  Handle to a valid symmetric matrix object.
+Failure
+  - Reason:        Memory allocation failure or invalid dimensions.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_SYMMETRIC matrix_symmetricInit(int n);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricInitDense
+  - Purpose:  Initialize a symmetric matrix with the upper triangle of a square matrix.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to convert.
+      Restrictions:  Handle to a valid matrix object.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and hMx is square.
+  - Summary:       Initializes and returns a symmetric matrix with the entries of hMx on and above the diagonal. The entries below it are ignored.
+  - Return value:  Handle to a valid symmetric matrix object.
+Failure
+  - Reason:        Memory allocation failure or hMx isn't square.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_SYMMETRIC matrix_symmetricInitDense(MATRIX hMx);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricSetEntry
+  - Purpose:  Set an entry of a symmetric matrix, which sets entries (row, col) and (col, row) since they're stored once.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix to set the entry of.
+      Restrictions:  Handle to a valid symmetric matrix object.
+  - row, col
+      Purpose:       Row and column of the entry.
+      Restrictions:  N/A
+  - entry
+      Purpose:       Value of the entry.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        The entry is inside the matrix.
+  - Summary:       Sets the entry.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        The entry is outside the matrix.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_symmetricSetEntry(MATRIX_SYMMETRIC hSym, int row, int col, double entry);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricSolve
+  - Purpose:  Solve the linear system A X = B for a symmetric positive definite matrix A with its Cholesky factorization A = R^T R,
+              solving R^T Y = B and R X = Y. Solving the normal equations A^T A x = A^T b of a least squares problem this way takes half the operations of matrix_opSolve.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix A.
+      Restrictions:  Handle to a valid symmetric matrix object.
+  - hMxB
+      Purpose:       Right-hand side B with one column per system.
+      Restrictions:  Handle to a valid matrix object. The rows equal the rows of A.
+  - pMxIsPosDef
+      Purpose:       Indicate if A is positive definite, the same as matrix_symmetricCholesky. TRUE means it is, unlike pMxIsInvertible.
+      Restrictions:  Not NULL.
+  - phMxX
+      Purpose:       Store the solution X.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+                     It may point to hMxB to solve in place.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and A is positive definite.
+  - Summary:       Solves the system and stores the solution in the result matrix.
+  - Return value:  SUCCESS
+  - pMxIsPosDef:   The Boolean it points to is set to TRUE.
+  - phMxX:         Stores the solution with the same dimensions as B.
+                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+Failure
+  - Reason:        Memory allocation failure, the dimensions don't agree or A isn't positive definite.
+  - Summary:       The system isn't solved and nothing of significance happens.
+  - Return value:  FAILURE
+  - pMxIsPosDef:   The Boolean it points to is set to FALSE if A isn't positive definite and TRUE otherwise.
+*/
+Status matrix_symmetricSolve(MATRIX_SYMMETRIC hSym, MATRIX hMxB, Boolean* pMxIsPosDef, MATRIX* phMxX);
+
+
+/*
+FUNCTION
+  - Name:     matrix_symmetricToDense
+  - Purpose:  Convert a symmetric matrix to a matrix object.
+PRECONDITION
+  - hSym
+      Purpose:       Symmetric matrix to convert.
+      Restrictions:  Handle to a valid symmetric matrix object.
+  - phMxRes
+      Purpose:       Store the matrix.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Stores the matrix with both triangles filled in.
+                   If it was a pointer to a handle to a valid matrix object before the function call, the matrix's dimensions are adjusted if necessary.
+                   If it was a pointer to a NULL handle before the function call, a new matrix gets created to store the result.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrix_symmetricToDense(MATRIX_SYMMETRIC hSym, MATRIX* phMxRes);
+
+
+/*
+FUNCTION
+  - Name:     matrix_view
+  - Purpose:  Initializes a view of a block of a matrix, e.g. a minor, a row, a column or one quarter of a blocked algorithm, that shares its entries instead of copying them.
+              The view is a matrix object like any other. Every function accepts it as an operand or a result and reads and writes the entries of hMx through it,
+              e.g. matrix_setEntry on entry (0, 0) of the view sets entry (rowStart, colStart) of hMx.
+              A view can't change dimensions, so functions that would resize it fail if it doesn't already have the dimensions of their result, and matrix_opTransInPlace only accepts a square view.
+              The result of an operation must not share entries with its operands.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to view a block of.
+      Restrictions:  Handle to a valid matrix object. It may be a view itself.
+                     It must not be destroyed or resized while the view exists.
+  - rowStart, rowCount
+      Purpose:       Index of the first row of the block (i.e. row 1 = index 0) and the number of rows in it.
+      Restrictions:  Any integers.
+  - colStart, colCount
+      Purpose:       Index of the first column of the block (i.e. column 1 = index 0) and the number of columns in it.
+      Restrictions:  Any integers.
+POSTCONDITION
+Success
+  - Reason:        The block is inside the matrix and no memory allocation failure.
+  - Summary:       Initializes and returns a view of the block.
+  - Return value:  Handle to a valid matrix object with rowCount rows and colCount columns. It must be destroyed with matrix_destroy, which leaves the entries of hMx alone.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - Reason:        The block is empty or not entirely inside the matrix, or memory allocation failure.
+  - Summary:       Doesn't initialize and return a view and nothing of significance happens.
+  - Return value:  NULL
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+MATRIX matrix_view(MATRIX hMx, int rowStart, int rowCount, int colStart, int colCount);
+
+
+/*
+FUNCTION
+  - Name:     matrix_viewTrans
+  - Purpose:  Initializes a view of the transpose of a matrix that shares its entries instead of copying them.
+              Useful when the transpose is only needed as an operand, e.g. A^T B, since no entries are copied and nothing the size of the matrix is allocated.
+              The view is a matrix object like any other. Every function accepts it and reads and writes the entries of hMx through it, e.g. matrix_setEntry on entry (i, j) of the view sets entry (j, i) of hMx.
+              A view can't change dimensions, so functions that would resize it fail if it doesn't already have the dimensions of their result, and matrix_opTransInPlace only accepts a square view.
+              The result of an operation must not share entries with its operands.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to view the transpose of.
+      Restrictions:  Handle to a valid matrix object. It may be a view itself.
+                     It must not be destroyed or resized while the view exists.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Initializes and returns a view of the transpose of hMx.
+  - Return value:  Handle to a valid matrix object whose rows are the columns of hMx. It must be destroyed with matrix_destroy, which leaves the entries of hMx alone.
+  - hMx:           The state of the matrix before the function call is preserved.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Doesn't initialize and return a view and nothing of significance happens.
+  - Return value:  NULL
+  - hMx:           The state of the matrix before the function call is preserved.
+*/
+MATRIX matrix_viewTrans(MATRIX hMx);
+
+
 #endif
\ No newline at end of file
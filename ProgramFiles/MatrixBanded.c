@@ -0,0 +1,486 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixBanded.c
+  Description:  Implementation file for the banded matrix functions of the matrix opaque object interface.
+*/
+
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "Matrix.h"
+#include "MatrixInternal.h"
+
+typedef struct matrixBanded {
+	int n;              // rows and columns
+	int kl;             // diagonals below the main diagonal that can hold entries that aren't 0
+	int ku;             // diagonals above the main diagonal that can hold entries that aren't 0
+	double* entries;    // the band row by row, kl + ku + 1 entries per row with entry (i, j) at index i * (kl + ku + 1) + j - i + kl, the ones outside the matrix are 0
+} MatrixBanded;
+
+typedef struct bandedFactor {
+	int n;
+	int kl;
+	int width;          // entries stored per row, 2 kl + ku + 1, since the row swaps of partial pivoting widen U to kl + ku diagonals above the main one
+	double* lu;         // U and the multipliers of L row by row, entry (i, j) at index i * width + j - i + kl
+	int* piv;           // row swapped with row k at step k of the elimination
+	int sign;           // sign of the row permutation, 0 if a pivot is 0 (A is singular)
+	size_t mark;        // top of the scratch arena before lu and piv were allocated from it
+} BandedFactor;
+
+
+
+
+/*********** Declarations for helper functions defined in this file **********/
+/*
+FUNCTION
+  - Name:     bandedFactorize
+  - Purpose:  Factor a banded matrix as P A = L U with Gaussian elimination and partial pivoting restricted to the band.
+              Each step only touches the kl rows below the pivot and the kl + ku columns to its right, so it takes O(n kl (kl + ku)) operations.
+              A pivot that is 0 or reduced to rounding noise relative to both its column and the row it came from marks the matrix invertible, like the dense factorization.
+              The factors are allocated from the scratch arena of the calling thread.
+PRECONDITION
+  - pBd
+      Purpose:       Matrix to factor.
+      Restrictions:  Pointer to a valid banded matrix object.
+  - pFac
+      Purpose:       Store the factorization.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Stores the factors, with sign 0 if the matrix is invertible. They're released with bandedFactorFree, before anything else allocated from the arena after them.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+static Status bandedFactorize(const MatrixBanded* pBd, BandedFactor* pFac);
+
+
+/*
+FUNCTION
+  - Name:     bandedFactorFree
+  - Purpose:  Release the arrays of a factorization from bandedFactorize to the scratch arena.
+PRECONDITION
+  - pFac
+      Purpose:       Factorization to free.
+      Restrictions:  Pointer to a factorization stored by bandedFactorize.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Releases the arrays and everything allocated from the arena after them.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void bandedFactorFree(BandedFactor* pFac);
+
+
+/*
+FUNCTION
+  - Name:     bandedIdx
+  - Purpose:  Find the index of entry (i, j) in a band stored row by row with kl diagonals below the main one and a given width.
+PRECONDITION
+  - i, j
+      Purpose:       Row and column of the entry.
+      Restrictions:  j - i between -kl and width - kl - 1.
+  - kl
+      Purpose:       Diagonals below the main diagonal.
+      Restrictions:  Any integer >= 0.
+  - width
+      Purpose:       Entries stored per row.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the index.
+  - Return value:  The index of the entry.
+Failure
+  - N/A
+*/
+static ptrdiff_t bandedIdx(int i, int j, int kl, int width);
+
+
+
+
+/********** Definitions for banded matrix interface functions declared in Matrix.h **********/
+Status matrix_bandedDestroy(MATRIX_BANDED* phBd) {
+	MatrixBanded* pBd = *phBd;
+	if (pBd) {
+		matrix_free(pBd->entries);
+		matrix_free(pBd);
+		*phBd = NULL;
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+
+double matrix_bandedDet(MATRIX_BANDED hBd, Status* pMem) {
+	BandedFactor fac;
+	double det;
+
+	*pMem = SUCCESS;
+	if (!bandedFactorize(hBd, &fac)) {
+		*pMem = FAILURE;
+		return 0;
+	}
+
+	// the determinant of P A = L U is the sign of P times the product of the diagonal of U
+	det = fac.sign;
+	for (int i = 0; i < fac.n && fac.sign; ++i)
+		det *= fac.lu[bandedIdx(i, i, fac.kl, fac.width)];
+	bandedFactorFree(&fac);
+
+	return det;
+}
+
+
+Status matrix_bandedGetEntry(MATRIX_BANDED hBd, int row, int col, double* pEntry) {
+	MatrixBanded* pBd = hBd;
+
+	*pEntry = 0;
+	if (row < 0 || row >= pBd->n || col < 0 || col >= pBd->n)
+		return FAILURE;
+	if (col - row >= -pBd->kl && col - row <= pBd->ku)
+		*pEntry = pBd->entries[bandedIdx(row, col, pBd->kl, pBd->kl + pBd->ku + 1)];
+
+	return SUCCESS;
+}
+
+
+int matrix_bandedGetLower(MATRIX_BANDED hBd) {
+	MatrixBanded* pBd = hBd;
+	return pBd->kl;
+}
+
+
+int matrix_bandedGetRows(MATRIX_BANDED hBd) {
+	MatrixBanded* pBd = hBd;
+	return pBd->n;
+}
+
+
+int matrix_bandedGetUpper(MATRIX_BANDED hBd) {
+	MatrixBanded* pBd = hBd;
+	return pBd->ku;
+}
+
+
+MATRIX_BANDED matrix_bandedInit(int n, int kl, int ku) {
+	MatrixBanded* pBd;
+	size_t size;
+
+	if (n < 1 || kl < 0 || ku < 0)
+		return NULL;
+
+	// diagonals past the corners of the matrix would only hold zeros
+	if (kl > n - 1)
+		kl = n - 1;
+	if (ku > n - 1)
+		ku = n - 1;
+	size = (size_t)n * (kl + ku + 1);
+
+	if (!(pBd = matrix_alloc(sizeof(*pBd))))
+		return NULL;
+	if (!(pBd->entries = matrix_alloc(sizeof(*pBd->entries) * size))) {
+		matrix_free(pBd);
+		return NULL;
+	}
+	memset(pBd->entries, 0, sizeof(*pBd->entries) * size);
+	pBd->n = n;
+	pBd->kl = kl;
+	pBd->ku = ku;
+
+	return pBd;
+}
+
+
+MATRIX_BANDED matrix_bandedInitDense(MATRIX hMx, int kl, int ku) {
+	MatrixBanded* pBd;
+	const double* entries;
+	ptrdiff_t rs, cs;
+	int n = matrix_getRows(hMx);
+	int width;
+
+	if (matrix_getCols(hMx) != n || !(pBd = matrix_bandedInit(n, kl, ku)))
+		return NULL;
+
+	// copy the entries inside the band, the rest are dropped
+	entries = matrix_internalGetEntries(hMx, &rs, &cs);
+	width = pBd->kl + pBd->ku + 1;
+	for (int i = 0; i < n; ++i) {
+		int first = (i - pBd->kl > 0) ? i - pBd->kl : 0;
+		int last = (i + pBd->ku < n - 1) ? i + pBd->ku : n - 1;
+		for (int j = first; j <= last; ++j)
+			pBd->entries[bandedIdx(i, j, pBd->kl, width)] = entries[i * rs + j * cs];
+	}
+
+	return pBd;
+}
+
+
+Status matrix_bandedMult(MATRIX_BANDED hBd, MATRIX hMx, MATRIX* phMxRes) {
+	MatrixBanded* pBd = hBd;
+	int width = pBd->kl + pBd->ku + 1;
+	int cols = matrix_getCols(hMx);
+	const double* b;
+	double* c;
+	ptrdiff_t rsb, csb, rsc, csc;
+
+	if (matrix_getRows(hMx) != pBd->n || !matrix_internalAdjustDims(phMxRes, pBd->n, cols, FALSE))
+		return FAILURE;
+	b = matrix_internalGetEntries(hMx, &rsb, &csb);
+	c = matrix_internalGetEntries(*phMxRes, &rsc, &csc);
+
+	// row i of the product is a combination of the rows of the other matrix inside the band of row i
+	for (int i = 0; i < pBd->n; ++i) {
+		int first = (i - pBd->kl > 0) ? i - pBd->kl : 0;
+		int last = (i + pBd->ku < pBd->n - 1) ? i + pBd->ku : pBd->n - 1;
+		const double* a = pBd->entries + bandedIdx(i, 0, pBd->kl, width);    // a[j] is entry (i, j) for j in the band
+		double* cRow = c + i * rsc;
+
+		// a single column is a dot product of the band of the row with the vector
+		if (cols == 1) {
+			double sum = 0;
+			for (int j = first; j <= last; ++j)
+				sum += a[j] * b[j * rsb];
+			cRow[0] = sum;
+			continue;
+		}
+
+		for (int k = 0; k < cols; ++k)
+			cRow[k * csc] = 0;
+		for (int j = first; j <= last; ++j) {
+			const double* bRow = b + j * rsb;
+			if (csb == 1 && csc == 1) {
+				for (int k = 0; k < cols; ++k)
+					cRow[k] += a[j] * bRow[k];
+			}
+			else {
+				for (int k = 0; k < cols; ++k)
+					cRow[k * csc] += a[j] * bRow[k * csb];
+			}
+		}
+	}
+
+	return SUCCESS;
+}
+
+
+Status matrix_bandedSetEntry(MATRIX_BANDED hBd, int row, int col, double entry) {
+	MatrixBanded* pBd = hBd;
+
+	if (row < 0 || row >= pBd->n || col < 0 || col >= pBd->n || col - row < -pBd->kl || col - row > pBd->ku)
+		return FAILURE;
+	pBd->entries[bandedIdx(row, col, pBd->kl, pBd->kl + pBd->ku + 1)] = entry;
+
+	return SUCCESS;
+}
+
+
+Status matrix_bandedSolve(MATRIX_BANDED hBd, MATRIX hMxB, Boolean* pMxIsInvertible, MATRIX* phMxX) {
+	MatrixBanded* pBd = hBd;
+	BandedFactor fac;
+	const double* b;
+	double* x;
+	ptrdiff_t rsb, csb, rs, cs;
+	int n = pBd->n;
+	int cols = matrix_getCols(hMxB);
+
+
+	*pMxIsInvertible = FALSE;    // assume A isn't invertible
+	if (matrix_getRows(hMxB) != n || !bandedFactorize(pBd, &fac))
+		return FAILURE;
+
+	// a pivot is 0 - the determinant is 0, A is invertible and the system has no unique solution
+	if (!fac.sign) {
+		*pMxIsInvertible = TRUE;
+		bandedFactorFree(&fac);
+		return FAILURE;
+	}
+
+	// solve in the result matrix, starting from a copy of B unless it is B
+	if (!matrix_internalAdjustDims(phMxX, n, cols, FALSE)) {
+		bandedFactorFree(&fac);
+		return FAILURE;
+	}
+	b = matrix_internalGetEntries(hMxB, &rsb, &csb);
+	x = matrix_internalGetEntries(*phMxX, &rs, &cs);
+	if (*phMxX != hMxB) {
+		for (int i = 0; i < n; ++i) {
+			for (int k = 0; k < cols; ++k)
+				x[i * rs + k * cs] = b[i * rsb + k * csb];
+		}
+	}
+
+	// L y = P b, applying each row swap and the multipliers below its pivot in the order of the elimination, every column at once
+	for (int k = 0; k < n; ++k) {
+		int last = (k + fac.kl < n - 1) ? k + fac.kl : n - 1;
+		double* xk = x + k * rs;
+		if (fac.piv[k] != k) {
+			double* xp = x + fac.piv[k] * rs;
+			for (int c = 0; c < cols; ++c) {
+				double temp = xk[c * cs];
+				xk[c * cs] = xp[c * cs];
+				xp[c * cs] = temp;
+			}
+		}
+		for (int i = k + 1; i <= last; ++i) {
+			double factor = fac.lu[bandedIdx(i, k, fac.kl, fac.width)];
+			double* xi = x + i * rs;
+			if (factor != 0) {
+				for (int c = 0; c < cols; ++c)
+					xi[c * cs] -= factor * xk[c * cs];
+			}
+		}
+	}
+
+	// U x = y from the last row up, U has kl + ku diagonals above the main one
+	for (int i = n - 1; i >= 0; --i) {
+		int last = (i + fac.width - fac.kl - 1 < n - 1) ? i + fac.width - fac.kl - 1 : n - 1;
+		double* xi = x + i * rs;
+		double diag = fac.lu[bandedIdx(i, i, fac.kl, fac.width)];
+		for (int j = i + 1; j <= last; ++j) {
+			double u = fac.lu[bandedIdx(i, j, fac.kl, fac.width)];
+			const double* xj = x + j * rs;
+			if (u != 0) {
+				for (int c = 0; c < cols; ++c)
+					xi[c * cs] -= u * xj[c * cs];
+			}
+		}
+		for (int c = 0; c < cols; ++c)
+			xi[c * cs] /= diag;
+	}
+	bandedFactorFree(&fac);
+
+	return SUCCESS;
+}
+
+
+Status matrix_bandedToDense(MATRIX_BANDED hBd, MATRIX* phMxRes) {
+	MatrixBanded* pBd = hBd;
+	double* entries;
+	ptrdiff_t rs, cs;
+	int width = pBd->kl + pBd->ku + 1;
+
+	if (!matrix_internalAdjustDims(phMxRes, pBd->n, pBd->n, TRUE))
+		return FAILURE;
+
+	entries = matrix_internalGetEntries(*phMxRes, &rs, &cs);
+	for (int i = 0; i < pBd->n; ++i) {
+		int first = (i - pBd->kl > 0) ? i - pBd->kl : 0;
+		int last = (i + pBd->ku < pBd->n - 1) ? i + pBd->ku : pBd->n - 1;
+		for (int j = first; j <= last; ++j)
+			entries[i * rs + j * cs] = pBd->entries[bandedIdx(i, j, pBd->kl, width)];
+	}
+
+	return SUCCESS;
+}
+
+
+
+
+/********** Helper function definitions **********/
+static Status bandedFactorize(const MatrixBanded* pBd, BandedFactor* pFac) {
+	int n = pBd->n, kl = pBd->kl, ku = pBd->ku;
+	int width = 2 * kl + ku + 1;
+	double* lu;
+	double* colMax;      // largest magnitude of each original column, so a pivot reduced to rounding noise is recognized as 0
+	double* rowMax;      // largest magnitude of the original row now at each row, swapped along with the rows
+	double pivot, factor;
+	int pivRow;
+	int sign = 1;
+
+
+	pFac->n = n;
+	pFac->kl = kl;
+	pFac->width = width;
+	pFac->mark = matrix_internalScratchMark();
+	pFac->lu = matrix_internalScratchAlloc(sizeof(*pFac->lu) * (size_t)n * width);
+	pFac->piv = matrix_internalScratchAlloc(sizeof(*pFac->piv) * n);
+	colMax = matrix_internalScratchAlloc(sizeof(*colMax) * 2 * n);
+	if (!pFac->lu || !pFac->piv || !colMax) {
+		bandedFactorFree(pFac);
+		return FAILURE;
+	}
+	lu = pFac->lu;
+	rowMax = colMax + n;
+
+	// copy the band into the wider rows, the diagonals the row swaps fill in start at 0
+	memset(lu, 0, sizeof(*lu) * (size_t)n * width);
+	memset(colMax, 0, sizeof(*colMax) * 2 * n);
+	for (int i = 0; i < n; ++i) {
+		int first = (i - kl > 0) ? i - kl : 0;
+		int last = (i + ku < n - 1) ? i + ku : n - 1;
+		for (int j = first; j <= last; ++j) {
+			double entry = fabs(pBd->entries[bandedIdx(i, j, kl, kl + ku + 1)]);
+			lu[bandedIdx(i, j, kl, width)] = pBd->entries[bandedIdx(i, j, kl, kl + ku + 1)];
+			if (entry > colMax[j])
+				colMax[j] = entry;
+			if (entry > rowMax[i])
+				rowMax[i] = entry;
+		}
+	}
+
+	for (int k = 0; k < n && sign; ++k) {
+		int lastRow = (k + kl < n - 1) ? k + kl : n - 1;           // only the kl rows below the pivot have entries in its column
+		int lastCol = (k + kl + ku < n - 1) ? k + kl + ku : n - 1;  // and none of them reaches past kl + ku columns to its right
+
+		// find the pivot
+		pivRow = k;
+		pivot = fabs(lu[bandedIdx(k, k, kl, width)]);
+		for (int i = k + 1; i <= lastRow; ++i) {
+			if (fabs(lu[bandedIdx(i, k, kl, width)]) > pivot) {
+				pivot = fabs(lu[bandedIdx(i, k, kl, width)]);
+				pivRow = i;
+			}
+		}
+		pFac->piv[k] = pivRow;
+		if (pivot == 0 || pivot <= (kl + ku + 1) * DBL_EPSILON * fmin(colMax[k], rowMax[pivRow])) {
+			sign = 0;
+			break;
+		}
+
+		// move the pivot row into place, each row indexes its own part of the band
+		if (pivRow != k) {
+			for (int j = k; j <= lastCol; ++j) {
+				double temp = lu[bandedIdx(k, j, kl, width)];
+				lu[bandedIdx(k, j, kl, width)] = lu[bandedIdx(pivRow, j, kl, width)];
+				lu[bandedIdx(pivRow, j, kl, width)] = temp;
+			}
+			double temp = rowMax[k];
+			rowMax[k] = rowMax[pivRow];
+			rowMax[pivRow] = temp;
+			sign = -sign;
+		}
+
+		// eliminate below the pivot
+		for (int i = k + 1; i <= lastRow; ++i) {
+			factor = lu[bandedIdx(i, k, kl, width)] / lu[bandedIdx(k, k, kl, width)];
+			lu[bandedIdx(i, k, kl, width)] = factor;
+			if (factor != 0) {
+				for (int j = k + 1; j <= lastCol; ++j)
+					lu[bandedIdx(i, j, kl, width)] -= factor * lu[bandedIdx(k, j, kl, width)];
+			}
+		}
+	}
+	pFac->sign = sign;
+
+	return SUCCESS;
+}
+
+
+static void bandedFactorFree(BandedFactor* pFac) {
+	matrix_internalScratchRelease(pFac->mark);
+	pFac->lu = NULL;
+	pFac->piv = NULL;
+}
+
+
+static ptrdiff_t bandedIdx(int i, int j, int kl, int width) {
+	return (ptrdiff_t)i * width + j - i + kl;
+}
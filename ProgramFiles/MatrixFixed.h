@@ -0,0 +1,440 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixFixed.h
+  Description:  Header file for the fixed-size 2 x 2, 3 x 3 and 4 x 4 matrix value types.
+                Unlike the matrix opaque object interface they live on the stack or inside other structs, need no memory allocation,
+                and their operations are unrolled for their size, which suits graphics and robotics code that works with many tiny matrices.
+                The types and functions for each size are generated by MATRIX_FIXED_DEFINE, so every function below exists as mat2_, mat3_ and mat4_
+                for Mat2, Mat3 and Mat4, written here as matN_ and MatN.
+                Every function is defined static inline in this header, so a call compiles to the unrolled code at the call site with no call overhead
+                and the compiler can keep the entries in registers from one operation to the next.
+*/
+
+
+#ifndef MATRIX_FIXED_H
+#define MATRIX_FIXED_H
+
+#include "Matrix.h"
+#include "Status.h"
+
+// multiplication works on pairs of entries in SSE2 registers when the compiler targets x86 with SSE2, which every x86-64 target does
+#ifdef __SSE2__
+#define MATRIX_FIXED_SSE2
+#include <emmintrin.h>
+#endif
+
+// loops over the size are fully unrolled, the size is a constant so every entry ends up in a register
+#ifdef __GNUC__
+#define MATRIX_FIXED_UNROLL _Pragma("GCC unroll 16")
+#else
+#define MATRIX_FIXED_UNROLL
+#endif
+
+
+
+
+/*
+TYPE
+  - Name:     MatN
+  - Purpose:  N x N matrix of doubles stored by value, where m[i][j] is the entry in row i and column j counting from 0.
+              The entries can be read and written directly.
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_fromMatrix
+  - Purpose:  Copy the entries of a matrix object into a fixed-size matrix.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to copy.
+      Restrictions:  Handle to a valid matrix object.
+  - pRes
+      Purpose:       Store the copy.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        The matrix object is N x N.
+  - Summary:       Copies the entries.
+  - Return value:  SUCCESS
+  - pRes:          Stores the entries of hMx.
+Failure
+  - Reason:        The matrix object isn't N x N.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_identity
+  - Purpose:  Get the N x N identity matrix.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the identity matrix.
+  - Return value:  The identity matrix.
+Failure
+  - N/A
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_opDet
+  - Purpose:  Calculate the determinant with the closed-form cofactor expansion for the size, with no pivoting or loops.
+PRECONDITION
+  - pA
+      Purpose:       Matrix to find the determinant of.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates the determinant.
+  - Return value:  The determinant.
+Failure
+  - N/A
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_opInv
+  - Purpose:  Calculate the inverse as the adjugate divided by the determinant, with the cofactors shared with the determinant.
+PRECONDITION
+  - pA
+      Purpose:       Matrix to invert.
+      Restrictions:  Not NULL.
+  - pRes
+      Purpose:       Store the inverse.
+      Restrictions:  Not NULL. May be pA.
+POSTCONDITION
+Success
+  - Reason:        The determinant isn't 0.
+  - Summary:       Calculates the inverse.
+  - Return value:  SUCCESS
+  - pRes:          Stores the inverse.
+Failure
+  - Reason:        The determinant is 0, so the matrix isn't invertible and the inverse can't be calculated.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_opMult
+  - Purpose:  Multiply two matrices.
+PRECONDITION
+  - pA
+      Purpose:       Left matrix.
+      Restrictions:  Not NULL.
+  - pB
+      Purpose:       Right matrix.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates A x B.
+  - Return value:  The product.
+Failure
+  - N/A
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_opPow
+  - Purpose:  Raise a matrix to a power by squaring, so only O(log power) multiplications.
+PRECONDITION
+  - pA
+      Purpose:       Matrix to raise to the power.
+      Restrictions:  Not NULL.
+  - power
+      Purpose:       Power to raise the matrix to.
+      Restrictions:  Any integer >= 0. A power of 0 gives the identity matrix.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates A^power.
+  - Return value:  The power of the matrix.
+Failure
+  - N/A
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_opTrans
+  - Purpose:  Transpose a matrix.
+PRECONDITION
+  - pA
+      Purpose:       Matrix to transpose.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Calculates A^T.
+  - Return value:  The transpose.
+Failure
+  - N/A
+*/
+
+
+/*
+FUNCTION
+  - Name:     matN_toMatrix
+  - Purpose:  Copy a fixed-size matrix into a matrix object, creating or resizing it like matrix_copy.
+PRECONDITION
+  - pA
+      Purpose:       Matrix to copy.
+      Restrictions:  Not NULL.
+  - phMx
+      Purpose:       Store the copy.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the matrix object isn't a view of other dimensions.
+  - Summary:       Copies the entries, creating the matrix object if the handle is NULL and resizing it to N x N otherwise.
+  - Return value:  SUCCESS
+  - phMx:          Handle to an N x N matrix object with the entries of pA.
+Failure
+  - Reason:        Memory allocation failure, or the matrix object is a view that isn't N x N.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phMx:          The state of the matrix before the function call is preserved.
+*/
+
+
+// multiply the n x n matrices stored row by row at pA and pB into pRes, n is a constant once this is inlined into a matN_opMult
+static inline void matrixFixed_mult(const double* pA, const double* pB, double* pRes, int n) {
+	// each row of the product is a combination of the rows of B, so whole rows are scaled and added
+#ifdef MATRIX_FIXED_SSE2
+	if (!(n & 1)) {
+		MATRIX_FIXED_UNROLL for (int i = 0; i < n; ++i) {
+			MATRIX_FIXED_UNROLL for (int j = 0; j < n; j += 2) {
+				__m128d sum = _mm_mul_pd(_mm_set1_pd(pA[i * n]), _mm_loadu_pd(pB + j));
+				MATRIX_FIXED_UNROLL for (int k = 1; k < n; ++k)
+					sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(pA[i * n + k]), _mm_loadu_pd(pB + k * n + j)));
+				_mm_storeu_pd(pRes + i * n + j, sum);
+			}
+		}
+		return;
+	}
+#endif
+	MATRIX_FIXED_UNROLL for (int i = 0; i < n; ++i) {
+		MATRIX_FIXED_UNROLL for (int j = 0; j < n; ++j)
+			pRes[i * n + j] = pA[i * n] * pB[j];
+		MATRIX_FIXED_UNROLL for (int k = 1; k < n; ++k) {
+			MATRIX_FIXED_UNROLL for (int j = 0; j < n; ++j)
+				pRes[i * n + j] += pA[i * n + k] * pB[k * n + j];
+		}
+	}
+}
+
+
+// define the type and functions for N x N matrices, other than the determinant and inverse which are written out for each size
+#define MATRIX_FIXED_DEFINE(N)                                                         \
+	typedef struct mat##N { double m[N][N]; } Mat##N;                                  \
+                                                                                       \
+	static inline Status mat##N##_fromMatrix(MATRIX hMx, Mat##N* pRes) {               \
+		if (matrix_getRows(hMx) != N || matrix_getCols(hMx) != N)                      \
+			return FAILURE;                                                            \
+		for (int i = 0; i < N; ++i) {                                                  \
+			for (int j = 0; j < N; ++j)                                                \
+				matrix_getEntry(hMx, i, j, &pRes->m[i][j]);                            \
+		}                                                                              \
+		return SUCCESS;                                                                \
+	}                                                                                  \
+                                                                                       \
+	static inline Mat##N mat##N##_identity(void) {                                     \
+		Mat##N res;                                                                    \
+		MATRIX_FIXED_UNROLL for (int i = 0; i < N; ++i) {                              \
+			MATRIX_FIXED_UNROLL for (int j = 0; j < N; ++j)                            \
+				res.m[i][j] = (i == j);                                                \
+		}                                                                              \
+		return res;                                                                    \
+	}                                                                                  \
+                                                                                       \
+	static inline Mat##N mat##N##_opMult(const Mat##N* pA, const Mat##N* pB) {         \
+		Mat##N res;                                                                    \
+		matrixFixed_mult(&pA->m[0][0], &pB->m[0][0], &res.m[0][0], N);                 \
+		return res;                                                                    \
+	}                                                                                  \
+                                                                                       \
+	static inline Mat##N mat##N##_opPow(const Mat##N* pA, int power) {                 \
+		Mat##N base = *pA;                                                             \
+		Mat##N res = mat##N##_identity();                                              \
+		for (; power > 0; power >>= 1) {                                               \
+			if (power & 1)                                                             \
+				res = mat##N##_opMult(&res, &base);                                    \
+			if (power > 1)                                                             \
+				base = mat##N##_opMult(&base, &base);                                  \
+		}                                                                              \
+		return res;                                                                    \
+	}                                                                                  \
+                                                                                       \
+	static inline Mat##N mat##N##_opTrans(const Mat##N* pA) {                          \
+		Mat##N res;                                                                    \
+		MATRIX_FIXED_UNROLL for (int i = 0; i < N; ++i) {                              \
+			MATRIX_FIXED_UNROLL for (int j = 0; j < N; ++j)                            \
+				res.m[j][i] = pA->m[i][j];                                             \
+		}                                                                              \
+		return res;                                                                    \
+	}                                                                                  \
+                                                                                       \
+	static inline Status mat##N##_toMatrix(const Mat##N* pA, MATRIX* phMx) {           \
+		if (!*phMx && !(*phMx = matrix_initDims(N, N)))                                \
+			return FAILURE;                                                            \
+		return matrix_newMatrix(*phMx, &pA->m[0][0], N, N);                            \
+	}
+
+MATRIX_FIXED_DEFINE(2)
+MATRIX_FIXED_DEFINE(3)
+MATRIX_FIXED_DEFINE(4)
+
+
+
+
+static inline double mat2_opDet(const Mat2* pA) {
+	return pA->m[0][0] * pA->m[1][1] - pA->m[0][1] * pA->m[1][0];
+}
+
+
+static inline Status mat2_opInv(const Mat2* pA, Mat2* pRes) {
+	double det = mat2_opDet(pA);
+	double a00 = pA->m[0][0], a01 = pA->m[0][1];
+	double a10 = pA->m[1][0], a11 = pA->m[1][1];
+
+	if (det == 0)
+		return FAILURE;
+	det = 1 / det;
+
+	pRes->m[0][0] = a11 * det;
+	pRes->m[0][1] = -a01 * det;
+	pRes->m[1][0] = -a10 * det;
+	pRes->m[1][1] = a00 * det;
+
+	return SUCCESS;
+}
+
+
+static inline double mat3_opDet(const Mat3* pA) {
+	const double (*a)[3] = pA->m;
+
+	return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+	     - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+	     + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+}
+
+
+static inline Status mat3_opInv(const Mat3* pA, Mat3* pRes) {
+	const double (*a)[3] = pA->m;
+	double c00, c01, c02, c10, c11, c12, c20, c21, c22;    // cofactor of each entry
+	double det;
+
+	c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+	c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+	c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+	det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+	if (det == 0)
+		return FAILURE;
+	det = 1 / det;
+
+	c10 = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+	c11 = a[0][0] * a[2][2] - a[0][2] * a[2][0];
+	c12 = a[0][1] * a[2][0] - a[0][0] * a[2][1];
+	c20 = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+	c21 = a[0][2] * a[1][0] - a[0][0] * a[1][2];
+	c22 = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+
+	// the inverse is the transpose of the cofactors divided by the determinant, written after every read in case pRes is pA
+	pRes->m[0][0] = c00 * det;
+	pRes->m[0][1] = c10 * det;
+	pRes->m[0][2] = c20 * det;
+	pRes->m[1][0] = c01 * det;
+	pRes->m[1][1] = c11 * det;
+	pRes->m[1][2] = c21 * det;
+	pRes->m[2][0] = c02 * det;
+	pRes->m[2][1] = c12 * det;
+	pRes->m[2][2] = c22 * det;
+
+	return SUCCESS;
+}
+
+
+static inline double mat4_opDet(const Mat4* pA) {
+	const double (*a)[4] = pA->m;
+	double s0, s1, s2, s3, s4, s5;    // 2 x 2 determinants of the top two rows
+	double c0, c1, c2, c3, c4, c5;    // 2 x 2 determinants of the bottom two rows
+
+	s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+	s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+	s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+	s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+	s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+	s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+	c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+	c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+	c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+	c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+	c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+	c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+
+	// Laplace expansion along the top two rows
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+
+static inline Status mat4_opInv(const Mat4* pA, Mat4* pRes) {
+	const double (*a)[4] = pA->m;
+	double s0, s1, s2, s3, s4, s5;    // 2 x 2 determinants of the top two rows
+	double c0, c1, c2, c3, c4, c5;    // 2 x 2 determinants of the bottom two rows
+	double det;
+	Mat4 res;                         // pRes may be pA, so the inverse is built here first
+
+	s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+	s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+	s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+	s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+	s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+	s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+	c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+	c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+	c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+	c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+	c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+	c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+
+	det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	if (det == 0)
+		return FAILURE;
+	det = 1 / det;
+
+	// each cofactor is a 3 x 3 determinant expanded along a row, reusing the 2 x 2 determinants of the other two rows
+	res.m[0][0] = ( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * det;
+	res.m[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * det;
+	res.m[0][2] = ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * det;
+	res.m[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * det;
+	res.m[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * det;
+	res.m[1][1] = ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * det;
+	res.m[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * det;
+	res.m[1][3] = ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * det;
+	res.m[2][0] = ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * det;
+	res.m[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * det;
+	res.m[2][2] = ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * det;
+	res.m[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * det;
+	res.m[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * det;
+	res.m[3][1] = ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * det;
+	res.m[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * det;
+	res.m[3][3] = ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * det;
+	*pRes = res;
+
+	return SUCCESS;
+}
+
+
+#endif
@@ -0,0 +1,125 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixInternal.h
+  Description:  Header file for the functions Matrix.c shares with the other files of the matrix interface, such as MatrixSparse.c, which only see handles.
+                They aren't part of the interface, so only the files that implement it include this header.
+*/
+
+
+#ifndef MATRIX_INTERNAL_H
+#define MATRIX_INTERNAL_H
+
+#include <stddef.h>
+#include "Matrix.h"
+
+
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalAdjustDims
+  - Purpose:  Make a matrix rows x cols, or create it if the handle is NULL, through adjustMatrixDims in Matrix.c.
+PRECONDITION
+  - phMx
+      Purpose:       Matrix to be adjusted.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+  - rows, cols, zero
+      Purpose:       Same as adjustMatrixDims.
+      Restrictions:  Same as adjustMatrixDims.
+POSTCONDITION
+  - Same as adjustMatrixDims.
+*/
+Status matrix_internalAdjustDims(MATRIX* phMx, int rows, int cols, Boolean zero);
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalGemmParallel
+  - Purpose:  Multiply two arrays of entries like gemm in Matrix.c, splitting the product into 2D tiles that the thread pool computes at the same time.
+              Products smaller than GEMM_PARALLEL_MIN_WORK are computed on the calling thread.
+PRECONDITION
+  - m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, csc
+      Purpose:       Same as gemm.
+      Restrictions:  Same as gemm.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the product.
+  - Return value:  SUCCESS
+  - c:             Stores the product.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The product isn't calculated.
+  - Return value:  FAILURE
+  - c:             Some tiles may store their product and the rest are preserved.
+*/
+Status matrix_internalGemmParallel(int m, int n, int k, const double* a, ptrdiff_t rsa, ptrdiff_t csa, const double* b, ptrdiff_t rsb, ptrdiff_t csb, double* c, ptrdiff_t rsc, ptrdiff_t csc);
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalGetEntries
+  - Purpose:  Get the array of entries of a matrix and its strides.
+              Entry (i, j) is at index i * row stride + j * column stride. Whoever writes to the entries must have resized the matrix with matrix_internalAdjustDims first,
+              which marks its max length out of date.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to get the entries of.
+      Restrictions:  Handle to a valid matrix object.
+  - pRowStride, pColStride
+      Purpose:       Store the strides.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the entries and stores the strides.
+  - Return value:  The array of entries, which starts at entry (0, 0).
+Failure
+  - N/A
+*/
+double* matrix_internalGetEntries(MATRIX hMx, ptrdiff_t* pRowStride, ptrdiff_t* pColStride);
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalScratchAlloc
+  - Purpose:  Allocate temporary memory from the scratch arena of the calling thread through scratchAlloc in Matrix.c,
+              so the other files of the interface reuse the same memory as the dense operations instead of allocating their own temporaries.
+PRECONDITION
+  - bytes
+      Purpose:       Bytes to allocate.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+  - Same as scratchAlloc.
+*/
+void* matrix_internalScratchAlloc(size_t bytes);
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalScratchMark
+  - Purpose:  Get the top of the scratch arena of the calling thread through scratchMark in Matrix.c, to release everything allocated after it with matrix_internalScratchRelease.
+PRECONDITION
+  - N/A
+POSTCONDITION
+  - Same as scratchMark.
+*/
+size_t matrix_internalScratchMark(void);
+
+
+/*
+FUNCTION
+  - Name:     matrix_internalScratchRelease
+  - Purpose:  Release everything allocated from the scratch arena of the calling thread since a mark was taken, through scratchRelease in Matrix.c.
+PRECONDITION
+  - mark
+      Purpose:       Top to release the arena to.
+      Restrictions:  A mark from matrix_internalScratchMark on the calling thread that hasn't been released past yet.
+POSTCONDITION
+  - Same as scratchRelease.
+*/
+void matrix_internalScratchRelease(size_t mark);
+
+
+#endif
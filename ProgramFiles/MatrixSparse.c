@@ -0,0 +1,1174 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixSparse.c
+  Description:  Implementation file for the sparse matrix opaque object interface.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "MatrixInternal.h"
+#include "MatrixSparse.h"
+#include "ThreadPool.h"
+
+#define SPARSE_PARALLEL_MIN_WORK (1 << 15)    // smallest number of entries or multiply-adds worth waking the workers for
+#define SPARSE_TASKS_PER_THREAD 4             // ranges of rows per thread so uneven rows balance out
+#define SPARSE_SORT_MIN 32                    // longest row of a product sorted with insertion sort instead of qsort
+
+typedef struct matrixSparse {
+	int rows;           // total rows
+	int cols;           // total columns
+	SparseFormat format;
+	size_t* starts;     // first entry of each row (CSR) or column (CSC) in indices and values, followed by the number of entries
+	int* indices;       // column (CSR) or row (CSC) of each entry, increasing within each row or column
+	double* values;     // value of each entry
+} MatrixSparse;
+
+typedef struct mergeJob {
+	const MatrixSparse* pA;     // terms of the sum or difference, both in CSR
+	const MatrixSparse* pB;
+	double sign;                // 1 for the sum, -1 for the difference
+	MatrixSparse* pRes;         // result, its indices and values are NULL while the entries of each row are counted
+	const int* bounds;          // first row of each task, followed by rows
+} MergeJob;
+
+typedef struct multJob {
+	const MatrixSparse* pA;     // factors of the product, both in CSR
+	const MatrixSparse* pB;
+	MatrixSparse* pRes;         // result, its indices and values are NULL while the entries of each row are counted
+	const int* bounds;          // first row of each task, followed by rows
+} MultJob;
+
+typedef struct multDenseJob {
+	const MatrixSparse* pA;     // sparse factor in CSR
+	const double* b;            // dense factor
+	ptrdiff_t rsb, csb;
+	double* c;                  // product
+	ptrdiff_t rsc, csc;
+	int cols;                   // columns of b and c
+	const int* bounds;          // first row of each task, followed by rows
+} MultDenseJob;
+
+
+
+
+/*********** Declarations for helper functions defined in this file **********/
+/*
+FUNCTION
+  - Name:     allocSparse
+  - Purpose:  Allocate a sparse matrix and the starts of its rows or columns, leaving the entries to allocSparseEntries once their number is known.
+PRECONDITION
+  - rows, cols
+      Purpose:       Dimensions of the sparse matrix.
+      Restrictions:  Any positive integers.
+  - format
+      Purpose:       Format of the sparse matrix.
+      Restrictions:  SPARSE_CSR or SPARSE_CSC.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the sparse matrix with uninitialized starts and NULL indices and values.
+  - Return value:  The sparse matrix.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MatrixSparse* allocSparse(int rows, int cols, SparseFormat format);
+
+
+/*
+FUNCTION
+  - Name:     allocSparseEntries
+  - Purpose:  Allocate the indices and values of a sparse matrix.
+PRECONDITION
+  - pSp
+      Purpose:       Sparse matrix from allocSparse.
+      Restrictions:  Its indices and values are NULL.
+  - nnz
+      Purpose:       Number of entries.
+      Restrictions:  Any integer >= 0.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Allocates the arrays, with room for at least one entry so they are never NULL.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The arrays stay NULL.
+  - Return value:  FAILURE
+*/
+static Status allocSparseEntries(MatrixSparse* pSp, size_t nnz);
+
+
+/*
+FUNCTION
+  - Name:     compareInts
+  - Purpose:  Compare two ints for qsort.
+PRECONDITION
+  - a, b
+      Purpose:       Ints to compare.
+      Restrictions:  Pointers to ints.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Compares the ints.
+  - Return value:  Negative, 0 or positive if the first is less than, equal to or greater than the second.
+Failure
+  - N/A
+*/
+static int compareInts(const void* a, const void* b);
+
+
+/*
+FUNCTION
+  - Name:     convertFormat
+  - Purpose:  Build a copy of a sparse matrix in the other format with a counting sort of its entries by their index.
+              Scattering the rows in order leaves every new row or column sorted.
+PRECONDITION
+  - pSp
+      Purpose:       Sparse matrix to convert.
+      Restrictions:  Pointer to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns the copy.
+  - Return value:  The sparse matrix in the other format.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MatrixSparse* convertFormat(const MatrixSparse* pSp);
+
+
+/*
+FUNCTION
+  - Name:     countRows
+  - Purpose:  Turn the entries of each row stored in starts[1..rows] by the counting pass of an operation into the starts of the rows, then allocate the entries.
+PRECONDITION
+  - pSp
+      Purpose:       Result of the operation.
+      Restrictions:  Its starts from allocSparse hold the entries of row i at index i + 1.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Sums the counts and allocates the indices and values.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The indices and values stay NULL.
+  - Return value:  FAILURE
+*/
+static Status countRows(MatrixSparse* pSp);
+
+
+/*
+FUNCTION
+  - Name:     csrView
+  - Purpose:  Get a sparse matrix in CSR form without copying, which is the matrix itself if it's CSR, or its transpose if it's CSC, since the CSC arrays of a matrix are the CSR arrays of its transpose.
+              The operations work only on CSR and get the CSC cases from identities of the transpose, such as (A B)^T = B^T A^T.
+PRECONDITION
+  - pSp
+      Purpose:       Sparse matrix to view.
+      Restrictions:  Pointer to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns a copy of the header with the dimensions swapped if it's CSC, sharing the arrays.
+  - Return value:  The CSR view.
+Failure
+  - N/A
+*/
+static MatrixSparse csrView(const MatrixSparse* pSp);
+
+
+/*
+FUNCTION
+  - Name:     freeSparse
+  - Purpose:  Free a sparse matrix and its arrays.
+PRECONDITION
+  - pSp
+      Purpose:       Sparse matrix to free.
+      Restrictions:  Pointer from allocSparse or NULL.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Frees the sparse matrix.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void freeSparse(MatrixSparse* pSp);
+
+
+/*
+FUNCTION
+  - Name:     merge
+  - Purpose:  Add or subtract two sparse matrices in CSR, counting the entries of every row of the result and then merging them, each pass split across the thread pool.
+PRECONDITION
+  - pA, pB
+      Purpose:       Terms.
+      Restrictions:  CSR sparse matrices with the same dimensions.
+  - sign
+      Purpose:       Factor of the entries of pB.
+      Restrictions:  1 or -1.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns pA + sign * pB.
+  - Return value:  The result in CSR.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MatrixSparse* merge(const MatrixSparse* pA, const MatrixSparse* pB, double sign);
+
+
+/*
+FUNCTION
+  - Name:     mergeRow
+  - Purpose:  Merge one row of two sparse matrices in CSR.
+PRECONDITION
+  - pA, pB, sign
+      Purpose:       Same as merge.
+      Restrictions:  Same as merge.
+  - row
+      Purpose:       Row to merge.
+      Restrictions:  In bounds.
+  - indices, values
+      Purpose:       Store the entries of the row of the result.
+      Restrictions:  Arrays with room for the entries of the row, or both NULL to only count them.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Merges the row.
+  - Return value:  Entries of the row of the result.
+Failure
+  - N/A
+*/
+static size_t mergeRow(const MatrixSparse* pA, const MatrixSparse* pB, double sign, int row, int* indices, double* values);
+
+
+/*
+FUNCTION
+  - Name:     mergeTask
+  - Purpose:  Count or merge the rows of one task of a MergeJob, counting if the indices of the result are NULL.
+PRECONDITION
+  - arg
+      Purpose:       The MergeJob.
+      Restrictions:  Pointer to a MergeJob.
+  - taskIdx
+      Purpose:       Index in the bounds of the job.
+      Restrictions:  Any integer >= 0 less than the number of tasks.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Counts or merges the rows.
+  - Return value:  SUCCESS
+Failure
+  - N/A
+*/
+static Status mergeTask(void* arg, int taskIdx);
+
+
+/*
+FUNCTION
+  - Name:     mult
+  - Purpose:  Multiply two sparse matrices in CSR with Gustavson's algorithm, counting the entries of every row of the product and then computing them.
+              Both passes are split across the thread pool into ranges of rows with about the same number of multiply-adds.
+PRECONDITION
+  - pA, pB
+      Purpose:       Factors.
+      Restrictions:  CSR sparse matrices where the columns of pA equal the rows of pB.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns pA pB.
+  - Return value:  The product in CSR.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static MatrixSparse* mult(const MatrixSparse* pA, const MatrixSparse* pB);
+
+
+/*
+FUNCTION
+  - Name:     multDenseTask
+  - Purpose:  Compute the rows of the product of one task of a MultDenseJob.
+PRECONDITION
+  - arg
+      Purpose:       The MultDenseJob.
+      Restrictions:  Pointer to a MultDenseJob.
+  - taskIdx
+      Purpose:       Index in the bounds of the job.
+      Restrictions:  Any integer >= 0 less than the number of tasks.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Computes the rows.
+  - Return value:  SUCCESS
+Failure
+  - N/A
+*/
+static Status multDenseTask(void* arg, int taskIdx);
+
+
+/*
+FUNCTION
+  - Name:     multTask
+  - Purpose:  Count or compute the rows of the product of one task of a MultJob, counting if the indices of the result are NULL.
+              Each row is accumulated in a dense array the width of the product, with a marker per column recording the last row that touched it so nothing is cleared between rows.
+PRECONDITION
+  - arg
+      Purpose:       The MultJob.
+      Restrictions:  Pointer to a MultJob.
+  - taskIdx
+      Purpose:       Index in the bounds of the job.
+      Restrictions:  Any integer >= 0 less than the number of tasks.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Counts or computes the rows.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       The rows aren't counted or computed.
+  - Return value:  FAILURE
+*/
+static Status multTask(void* arg, int taskIdx);
+
+
+/*
+FUNCTION
+  - Name:     replaceSparse
+  - Purpose:  Store the result of an operation in the handle it was asked for, after it has been computed in memory of its own so the handle can also be an operand.
+PRECONDITION
+  - phSpRes
+      Purpose:       Handle to store the result in.
+      Restrictions:  Pointer to a handle to a valid sparse matrix object or NULL handle.
+  - pRes
+      Purpose:       Result.
+      Restrictions:  Pointer from allocSparse with its entries allocated.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       If the handle is NULL it stores pRes, otherwise the arrays of its sparse matrix are freed and replaced with those of pRes, and pRes itself is freed.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void replaceSparse(MATRIX_SPARSE* phSpRes, MatrixSparse* pRes);
+
+
+/*
+FUNCTION
+  - Name:     sortRow
+  - Purpose:  Sort the indices of a row of a product, with insertion sort for short rows and qsort for the rest.
+PRECONDITION
+  - indices
+      Purpose:       Indices to sort.
+      Restrictions:  Array of size count.
+  - count
+      Purpose:       Number of indices.
+      Restrictions:  Any integer >= 0.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Sorts the indices in increasing order.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void sortRow(int* indices, size_t count);
+
+
+/*
+FUNCTION
+  - Name:     splitRows
+  - Purpose:  Split rows into ranges with about the same work for the thread pool, or one range if there isn't enough work to wake the workers for.
+PRECONDITION
+  - work
+      Purpose:       Work done before each row, so row i takes work[i + 1] - work[i].
+      Restrictions:  Nondecreasing array of size rows + 1 starting at 0.
+  - rows
+      Purpose:       Rows to split.
+      Restrictions:  Any positive integer.
+  - pNumTasks
+      Purpose:       Store the number of ranges.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Returns the first row of each range followed by rows, found with a binary search of work for each share of the total.
+  - Return value:  Array of size *pNumTasks + 1 to free with matrix_free.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+static int* splitRows(const size_t* work, int rows, int* pNumTasks);
+
+
+/*
+FUNCTION
+  - Name:     transView
+  - Purpose:  Relabel a sparse matrix as its transpose by swapping its dimensions and format, since the same arrays describe both.
+PRECONDITION
+  - pSp
+      Purpose:       Sparse matrix to relabel.
+      Restrictions:  Pointer to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       The sparse matrix becomes its transpose without moving any entry.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void transView(MatrixSparse* pSp);
+
+
+
+
+/********** Definitions for sparse matrix interface functions declared in MatrixSparse.h **********/
+Status matrixSparse_destroy(MATRIX_SPARSE* phSp) {
+	if (*phSp) {
+		freeSparse(*phSp);
+		*phSp = NULL;
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+
+int matrixSparse_getCols(MATRIX_SPARSE hSp) {
+	MatrixSparse* pSp = hSp;
+	return pSp->cols;
+}
+
+
+Status matrixSparse_getEntry(MATRIX_SPARSE hSp, int row, int col, double* pEntry) {
+	MatrixSparse* pSp = hSp;
+	int major = (pSp->format == SPARSE_CSR) ? row : col;    // row or column the entry is stored in
+	int minor = (pSp->format == SPARSE_CSR) ? col : row;    // index of the entry within it
+	size_t lo, hi, mid;
+
+	*pEntry = 0;
+	if (row < 0 || row >= pSp->rows || col < 0 || col >= pSp->cols)
+		return FAILURE;
+
+	lo = pSp->starts[major];
+	hi = pSp->starts[major + 1];
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pSp->indices[mid] < minor)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < pSp->starts[major + 1] && pSp->indices[lo] == minor)
+		*pEntry = pSp->values[lo];
+
+	return SUCCESS;
+}
+
+
+SparseFormat matrixSparse_getFormat(MATRIX_SPARSE hSp) {
+	MatrixSparse* pSp = hSp;
+	return pSp->format;
+}
+
+
+size_t matrixSparse_getNnz(MATRIX_SPARSE hSp) {
+	MatrixSparse* pSp = hSp;
+	return pSp->starts[(pSp->format == SPARSE_CSR) ? pSp->rows : pSp->cols];
+}
+
+
+int matrixSparse_getRows(MATRIX_SPARSE hSp) {
+	MatrixSparse* pSp = hSp;
+	return pSp->rows;
+}
+
+
+MATRIX_SPARSE matrixSparse_initDense(MATRIX hMx, SparseFormat format) {
+	int rows = matrix_getRows(hMx);
+	int cols = matrix_getCols(hMx);
+	ptrdiff_t rs, cs;
+	const double* entries = matrix_internalGetEntries(hMx, &rs, &cs);
+	MatrixSparse* pSp = allocSparse(rows, cols, format);
+	MatrixSparse view;
+	size_t pos = 0;
+
+	if (!pSp)
+		return NULL;
+
+	// read the matrix by rows for CSR and by columns for CSC, which is reading its transpose by rows
+	view = csrView(pSp);
+	if (format == SPARSE_CSC) {
+		ptrdiff_t temp = rs;
+		rs = cs;
+		cs = temp;
+	}
+
+	// count the nonzeros of each row, then store them
+	pSp->starts[0] = 0;
+	for (int i = 0; i < view.rows; ++i) {
+		for (int j = 0; j < view.cols; ++j)
+			pos += (entries[i * rs + j * cs] != 0);
+		pSp->starts[i + 1] = pos;
+	}
+	if (!allocSparseEntries(pSp, pos)) {
+		freeSparse(pSp);
+		return NULL;
+	}
+	pos = 0;
+	for (int i = 0; i < view.rows; ++i) {
+		for (int j = 0; j < view.cols; ++j) {
+			if (entries[i * rs + j * cs] != 0) {
+				pSp->indices[pos] = j;
+				pSp->values[pos++] = entries[i * rs + j * cs];
+			}
+		}
+	}
+
+	return pSp;
+}
+
+
+MATRIX_SPARSE matrixSparse_initTriplets(const int* rowIdx, const int* colIdx, const double* values, size_t nnz, int rows, int cols, SparseFormat format) {
+	const int* majorIdx = (format == SPARSE_CSR) ? rowIdx : colIdx;    // row or column each triplet is stored in
+	const int* minorIdx = (format == SPARSE_CSR) ? colIdx : rowIdx;    // index of each triplet within it
+	int numMajor = (format == SPARSE_CSR) ? rows : cols;
+	int numMinor = (format == SPARSE_CSR) ? cols : rows;
+	MatrixSparse* pSp;
+	size_t* minorStarts = NULL;    // triplets bucketed by their minor index, the first pass of the counting sort
+	size_t* next = NULL;           // next free slot of each row in the second pass
+	int* bucketMajor = NULL;
+	double* bucketValues = NULL;
+	size_t pos, begin, end;
+
+
+	if (rows < 1 || cols < 1)
+		return NULL;
+	for (size_t k = 0; k < nnz; ++k) {
+		if (rowIdx[k] < 0 || rowIdx[k] >= rows || colIdx[k] < 0 || colIdx[k] >= cols)
+			return NULL;
+	}
+
+	if (!(pSp = allocSparse(rows, cols, format)) || !allocSparseEntries(pSp, nnz)
+	    || !(minorStarts = matrix_alloc(sizeof(*minorStarts) * ((size_t)numMinor + 1))) || !(next = matrix_alloc(sizeof(*next) * numMajor))
+	    || !(bucketMajor = matrix_alloc(sizeof(*bucketMajor) * (nnz ? nnz : 1))) || !(bucketValues = matrix_alloc(sizeof(*bucketValues) * (nnz ? nnz : 1)))) {
+		freeSparse(pSp);
+		matrix_free(minorStarts);
+		matrix_free(next);
+		matrix_free(bucketMajor);
+		return NULL;
+	}
+
+	// bucket the triplets by their minor index, keeping their order within each bucket
+	memset(minorStarts, 0, sizeof(*minorStarts) * ((size_t)numMinor + 1));
+	for (size_t k = 0; k < nnz; ++k)
+		++minorStarts[minorIdx[k] + 1];
+	for (int j = 0; j < numMinor; ++j)
+		minorStarts[j + 1] += minorStarts[j];
+	for (size_t k = 0; k < nnz; ++k) {
+		pos = minorStarts[minorIdx[k]]++;
+		bucketMajor[pos] = majorIdx[k];
+		bucketValues[pos] = values[k];
+	}
+
+	// scatter the buckets into their rows in order of the minor index, which leaves every row sorted (minorStarts[j] is now the end of bucket j)
+	memset(pSp->starts, 0, sizeof(*pSp->starts) * ((size_t)numMajor + 1));
+	for (size_t k = 0; k < nnz; ++k)
+		++pSp->starts[majorIdx[k] + 1];
+	for (int i = 0; i < numMajor; ++i) {
+		pSp->starts[i + 1] += pSp->starts[i];
+		next[i] = pSp->starts[i];
+	}
+	pos = 0;
+	for (int j = 0; j < numMinor; ++j) {
+		for (; pos < minorStarts[j]; ++pos) {
+			pSp->indices[next[bucketMajor[pos]]] = j;
+			pSp->values[next[bucketMajor[pos]]++] = bucketValues[pos];
+		}
+	}
+
+	// sum the duplicates, which are next to each other now, moving each row back over the ones removed before it
+	pos = 0;
+	begin = 0;
+	for (int i = 0; i < numMajor; ++i) {
+		end = pSp->starts[i + 1];
+		for (size_t k = begin; k < end; ++k) {
+			if (pos > pSp->starts[i] && pSp->indices[pos - 1] == pSp->indices[k])
+				pSp->values[pos - 1] += pSp->values[k];
+			else {
+				pSp->indices[pos] = pSp->indices[k];
+				pSp->values[pos++] = pSp->values[k];
+			}
+		}
+		begin = end;
+		pSp->starts[i + 1] = pos;
+	}
+
+	matrix_free(minorStarts);
+	matrix_free(next);
+	matrix_free(bucketMajor);
+	matrix_free(bucketValues);
+
+	return pSp;
+}
+
+
+Status matrixSparse_opAdd(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes) {
+	MatrixSparse* pSp1 = hSp1;
+	MatrixSparse* pSp2 = hSp2;
+	MatrixSparse* pConverted = NULL;    // hSp2 in the format of hSp1 if they differ
+	MatrixSparse* pRes;
+	MatrixSparse a, b;
+
+	if (pSp1->rows != pSp2->rows || pSp1->cols != pSp2->cols)
+		return FAILURE;
+	if (pSp2->format != pSp1->format && !(pSp2 = pConverted = convertFormat(pSp2)))
+		return FAILURE;
+
+	// A^T + B^T = (A + B)^T, so the CSR views of CSC terms give the CSC arrays of the sum
+	a = csrView(pSp1);
+	b = csrView(pSp2);
+	pRes = merge(&a, &b, 1);
+	freeSparse(pConverted);
+	if (!pRes)
+		return FAILURE;
+	if (pSp1->format == SPARSE_CSC)
+		transView(pRes);
+
+	replaceSparse(phSpRes, pRes);
+	return SUCCESS;
+}
+
+
+Status matrixSparse_opMult(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes) {
+	MatrixSparse* pSp1 = hSp1;
+	MatrixSparse* pSp2 = hSp2;
+	MatrixSparse* pConverted = NULL;    // hSp2 in the format of hSp1 if they differ
+	MatrixSparse* pRes;
+	MatrixSparse a, b;
+
+	if (pSp1->cols != pSp2->rows)
+		return FAILURE;
+	if (pSp2->format != pSp1->format && !(pSp2 = pConverted = convertFormat(pSp2)))
+		return FAILURE;
+
+	// B^T A^T = (A B)^T, so the product of the CSR views of CSC factors in reverse order gives the CSC arrays of the product
+	a = csrView(pSp1);
+	b = csrView(pSp2);
+	pRes = (pSp1->format == SPARSE_CSR) ? mult(&a, &b) : mult(&b, &a);
+	freeSparse(pConverted);
+	if (!pRes)
+		return FAILURE;
+	if (pSp1->format == SPARSE_CSC)
+		transView(pRes);
+
+	replaceSparse(phSpRes, pRes);
+	return SUCCESS;
+}
+
+
+Status matrixSparse_opMultDense(MATRIX_SPARSE hSp, MATRIX hMx, MATRIX* phMxRes) {
+	MatrixSparse* pSp = hSp;
+	MatrixSparse* pConverted = NULL;    // hSp in CSR if it's CSC
+	MultDenseJob job;
+	int numTasks;
+	int* bounds;
+	Status status;
+
+	if (pSp->cols != matrix_getRows(hMx))
+		return FAILURE;
+	if (pSp->format == SPARSE_CSC && !(pSp = pConverted = convertFormat(pSp)))
+		return FAILURE;
+
+	// split the rows of the product by the entries of the sparse matrix they read
+	if (!(bounds = splitRows(pSp->starts, pSp->rows, &numTasks)) || !matrix_internalAdjustDims(phMxRes, pSp->rows, matrix_getCols(hMx), FALSE)) {
+		matrix_free(bounds);
+		freeSparse(pConverted);
+		return FAILURE;
+	}
+
+	job.pA = pSp;
+	job.b = matrix_internalGetEntries(hMx, &job.rsb, &job.csb);
+	job.c = matrix_internalGetEntries(*phMxRes, &job.rsc, &job.csc);
+	job.cols = matrix_getCols(hMx);
+	job.bounds = bounds;
+	status = threadPool_run(multDenseTask, &job, numTasks);
+
+	matrix_free(bounds);
+	freeSparse(pConverted);
+	return status;
+}
+
+
+Status matrixSparse_opSub(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes) {
+	MatrixSparse* pSp1 = hSp1;
+	MatrixSparse* pSp2 = hSp2;
+	MatrixSparse* pConverted = NULL;    // hSp2 in the format of hSp1 if they differ
+	MatrixSparse* pRes;
+	MatrixSparse a, b;
+
+	if (pSp1->rows != pSp2->rows || pSp1->cols != pSp2->cols)
+		return FAILURE;
+	if (pSp2->format != pSp1->format && !(pSp2 = pConverted = convertFormat(pSp2)))
+		return FAILURE;
+
+	// A^T - B^T = (A - B)^T, so the CSR views of CSC terms give the CSC arrays of the difference
+	a = csrView(pSp1);
+	b = csrView(pSp2);
+	pRes = merge(&a, &b, -1);
+	freeSparse(pConverted);
+	if (!pRes)
+		return FAILURE;
+	if (pSp1->format == SPARSE_CSC)
+		transView(pRes);
+
+	replaceSparse(phSpRes, pRes);
+	return SUCCESS;
+}
+
+
+Status matrixSparse_opTrans(MATRIX_SPARSE hSp, MATRIX_SPARSE* phSpRes) {
+	MatrixSparse* pSp = hSp;
+	MatrixSparse* pRes;
+	int major = (pSp->format == SPARSE_CSR) ? pSp->rows : pSp->cols;
+	size_t nnz = pSp->starts[major];
+
+	// copy the arrays unchanged and relabel the copy as the transpose
+	if (!(pRes = allocSparse(pSp->rows, pSp->cols, pSp->format)) || !allocSparseEntries(pRes, nnz)) {
+		freeSparse(pRes);
+		return FAILURE;
+	}
+	memcpy(pRes->starts, pSp->starts, sizeof(*pSp->starts) * ((size_t)major + 1));
+	memcpy(pRes->indices, pSp->indices, sizeof(*pSp->indices) * nnz);
+	memcpy(pRes->values, pSp->values, sizeof(*pSp->values) * nnz);
+	transView(pRes);
+
+	replaceSparse(phSpRes, pRes);
+	return SUCCESS;
+}
+
+
+Status matrixSparse_setFormat(MATRIX_SPARSE hSp, SparseFormat format) {
+	MatrixSparse* pSp = hSp;
+	MatrixSparse* pConverted;
+
+	if (pSp->format == format)
+		return SUCCESS;
+	if (!(pConverted = convertFormat(pSp)))
+		return FAILURE;
+
+	replaceSparse(&hSp, pConverted);
+	return SUCCESS;
+}
+
+
+Status matrixSparse_toDense(MATRIX_SPARSE hSp, MATRIX* phMxRes) {
+	MatrixSparse* pSp = hSp;
+	MatrixSparse view = csrView(pSp);
+	double* entries;
+	ptrdiff_t rs, cs, temp;
+
+	if (!matrix_internalAdjustDims(phMxRes, pSp->rows, pSp->cols, TRUE))
+		return FAILURE;
+
+	// write the rows of the CSR view, which are the columns of the matrix if it's CSC
+	entries = matrix_internalGetEntries(*phMxRes, &rs, &cs);
+	if (pSp->format == SPARSE_CSC) {
+		temp = rs;
+		rs = cs;
+		cs = temp;
+	}
+	for (int i = 0; i < view.rows; ++i) {
+		for (size_t k = view.starts[i]; k < view.starts[i + 1]; ++k)
+			entries[i * rs + view.indices[k] * cs] = view.values[k];
+	}
+
+	return SUCCESS;
+}
+
+
+
+
+/********** Helper function definitions **********/
+static MatrixSparse* allocSparse(int rows, int cols, SparseFormat format) {
+	int major = (format == SPARSE_CSR) ? rows : cols;
+
+	MatrixSparse* pSp = matrix_alloc(sizeof(*pSp));
+	if (pSp) {
+		if (!(pSp->starts = matrix_alloc(sizeof(*pSp->starts) * ((size_t)major + 1)))) {
+			matrix_free(pSp);
+			return NULL;
+		}
+		pSp->rows = rows;
+		pSp->cols = cols;
+		pSp->format = format;
+		pSp->indices = NULL;
+		pSp->values = NULL;
+	}
+
+	return pSp;
+}
+
+
+static Status allocSparseEntries(MatrixSparse* pSp, size_t nnz) {
+	if (!nnz)
+		nnz = 1;
+
+	if (!(pSp->indices = matrix_alloc(sizeof(*pSp->indices) * nnz)))
+		return FAILURE;
+	if (!(pSp->values = matrix_alloc(sizeof(*pSp->values) * nnz))) {
+		matrix_free(pSp->indices);
+		pSp->indices = NULL;
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+
+static int compareInts(const void* a, const void* b) {
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+
+static MatrixSparse* convertFormat(const MatrixSparse* pSp) {
+	MatrixSparse src = csrView(pSp);    // the counting sort transposes this CSR, giving its CSC arrays, which are the arrays of pSp in the other format
+	MatrixSparse* pRes;
+	size_t nnz = src.starts[src.rows];
+	size_t* next;                       // next free slot of each new row
+
+	if (!(pRes = allocSparse(pSp->rows, pSp->cols, (pSp->format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR)) || !allocSparseEntries(pRes, nnz)
+	    || !(next = matrix_alloc(sizeof(*next) * src.cols))) {
+		freeSparse(pRes);
+		return NULL;
+	}
+
+	memset(pRes->starts, 0, sizeof(*pRes->starts) * ((size_t)src.cols + 1));
+	for (size_t k = 0; k < nnz; ++k)
+		++pRes->starts[src.indices[k] + 1];
+	for (int j = 0; j < src.cols; ++j) {
+		pRes->starts[j + 1] += pRes->starts[j];
+		next[j] = pRes->starts[j];
+	}
+	for (int i = 0; i < src.rows; ++i) {
+		for (size_t k = src.starts[i]; k < src.starts[i + 1]; ++k) {
+			pRes->indices[next[src.indices[k]]] = i;
+			pRes->values[next[src.indices[k]]++] = src.values[k];
+		}
+	}
+
+	matrix_free(next);
+	return pRes;
+}
+
+
+static Status countRows(MatrixSparse* pSp) {
+	int major = (pSp->format == SPARSE_CSR) ? pSp->rows : pSp->cols;
+
+	pSp->starts[0] = 0;
+	for (int i = 0; i < major; ++i)
+		pSp->starts[i + 1] += pSp->starts[i];
+
+	return allocSparseEntries(pSp, pSp->starts[major]);
+}
+
+
+static MatrixSparse csrView(const MatrixSparse* pSp) {
+	MatrixSparse view = *pSp;
+
+	if (pSp->format == SPARSE_CSC)
+		transView(&view);
+
+	return view;
+}
+
+
+static void freeSparse(MatrixSparse* pSp) {
+	if (pSp) {
+		matrix_free(pSp->starts);
+		matrix_free(pSp->indices);
+		matrix_free(pSp->values);
+		matrix_free(pSp);
+	}
+}
+
+
+static MatrixSparse* merge(const MatrixSparse* pA, const MatrixSparse* pB, double sign) {
+	MergeJob job = { pA, pB, sign, NULL, NULL };
+	int numTasks;
+	int* bounds;
+
+	// split the rows by the entries of A, B is assumed to be about as dense
+	if (!(bounds = splitRows(pA->starts, pA->rows, &numTasks)))
+		return NULL;
+	if (!(job.pRes = allocSparse(pA->rows, pA->cols, SPARSE_CSR))) {
+		matrix_free(bounds);
+		return NULL;
+	}
+	job.bounds = bounds;
+
+	threadPool_run(mergeTask, &job, numTasks);
+	if (!countRows(job.pRes)) {
+		freeSparse(job.pRes);
+		matrix_free(bounds);
+		return NULL;
+	}
+	threadPool_run(mergeTask, &job, numTasks);
+
+	matrix_free(bounds);
+	return job.pRes;
+}
+
+
+static size_t mergeRow(const MatrixSparse* pA, const MatrixSparse* pB, double sign, int row, int* indices, double* values) {
+	size_t ka = pA->starts[row], endA = pA->starts[row + 1];
+	size_t kb = pB->starts[row], endB = pB->starts[row + 1];
+	size_t count = 0;
+
+	while (ka < endA || kb < endB) {
+		int colA = (ka < endA) ? pA->indices[ka] : pA->cols;
+		int colB = (kb < endB) ? pB->indices[kb] : pB->cols;
+		if (indices) {
+			indices[count] = (colA < colB) ? colA : colB;
+			values[count] = ((colA <= colB) ? pA->values[ka] : 0) + ((colB <= colA) ? sign * pB->values[kb] : 0);
+		}
+		ka += (colA <= colB);
+		kb += (colB <= colA);
+		++count;
+	}
+
+	return count;
+}
+
+
+static Status mergeTask(void* arg, int taskIdx) {
+	MergeJob* pJob = arg;
+	MatrixSparse* pRes = pJob->pRes;
+
+	for (int i = pJob->bounds[taskIdx]; i < pJob->bounds[taskIdx + 1]; ++i) {
+		if (!pRes->indices)
+			pRes->starts[i + 1] = mergeRow(pJob->pA, pJob->pB, pJob->sign, i, NULL, NULL);
+		else
+			mergeRow(pJob->pA, pJob->pB, pJob->sign, i, pRes->indices + pRes->starts[i], pRes->values + pRes->starts[i]);
+	}
+
+	return SUCCESS;
+}
+
+
+static MatrixSparse* mult(const MatrixSparse* pA, const MatrixSparse* pB) {
+	MultJob job = { pA, pB, NULL, NULL };
+	size_t* work;    // multiply-adds before each row of the product, plus one per row so empty rows count too
+	int numTasks;
+	int* bounds;
+
+	if (!(work = matrix_alloc(sizeof(*work) * ((size_t)pA->rows + 1))))
+		return NULL;
+	work[0] = 0;
+	for (int i = 0; i < pA->rows; ++i) {
+		work[i + 1] = work[i] + 1;
+		for (size_t k = pA->starts[i]; k < pA->starts[i + 1]; ++k)
+			work[i + 1] += pB->starts[pA->indices[k] + 1] - pB->starts[pA->indices[k]];
+	}
+	bounds = splitRows(work, pA->rows, &numTasks);
+	matrix_free(work);
+	if (!bounds)
+		return NULL;
+	if (!(job.pRes = allocSparse(pA->rows, pB->cols, SPARSE_CSR))) {
+		matrix_free(bounds);
+		return NULL;
+	}
+	job.bounds = bounds;
+
+	if (!threadPool_run(multTask, &job, numTasks) || !countRows(job.pRes) || !threadPool_run(multTask, &job, numTasks)) {
+		freeSparse(job.pRes);
+		matrix_free(bounds);
+		return NULL;
+	}
+
+	matrix_free(bounds);
+	return job.pRes;
+}
+
+
+static Status multDenseTask(void* arg, int taskIdx) {
+	MultDenseJob* pJob = arg;
+	const MatrixSparse* pA = pJob->pA;
+	const double* bRow;
+	double* cRow;
+	double a;
+
+	for (int i = pJob->bounds[taskIdx]; i < pJob->bounds[taskIdx + 1]; ++i) {
+		cRow = pJob->c + i * pJob->rsc;
+
+		// a single column is a dot product of the row with the vector
+		if (pJob->cols == 1) {
+			double sum = 0;
+			for (size_t k = pA->starts[i]; k < pA->starts[i + 1]; ++k)
+				sum += pA->values[k] * pJob->b[pA->indices[k] * pJob->rsb];
+			cRow[0] = sum;
+			continue;
+		}
+
+		// otherwise the row of the product is a combination of rows of the dense matrix
+		for (int j = 0; j < pJob->cols; ++j)
+			cRow[j * pJob->csc] = 0;
+		for (size_t k = pA->starts[i]; k < pA->starts[i + 1]; ++k) {
+			a = pA->values[k];
+			bRow = pJob->b + pA->indices[k] * pJob->rsb;
+			if (pJob->csb == 1 && pJob->csc == 1) {
+				for (int j = 0; j < pJob->cols; ++j)
+					cRow[j] += a * bRow[j];
+			}
+			else {
+				for (int j = 0; j < pJob->cols; ++j)
+					cRow[j * pJob->csc] += a * bRow[j * pJob->csb];
+			}
+		}
+	}
+
+	return SUCCESS;
+}
+
+
+static Status multTask(void* arg, int taskIdx) {
+	MultJob* pJob = arg;
+	const MatrixSparse* pA = pJob->pA;
+	const MatrixSparse* pB = pJob->pB;
+	MatrixSparse* pRes = pJob->pRes;
+	Boolean count = !pRes->indices;    // counting pass
+	int* marker;                       // last row that touched each column of the product
+	double* acc = NULL;                // sum of each column of the current row
+	size_t pos;
+	int col;
+
+	if (!(marker = matrix_alloc(sizeof(*marker) * pB->cols)) || (!count && !(acc = matrix_alloc(sizeof(*acc) * pB->cols)))) {
+		matrix_free(marker);
+		return FAILURE;
+	}
+	for (int j = 0; j < pB->cols; ++j)
+		marker[j] = -1;
+
+	for (int i = pJob->bounds[taskIdx]; i < pJob->bounds[taskIdx + 1]; ++i) {
+		pos = count ? 0 : pRes->starts[i];
+		for (size_t ka = pA->starts[i]; ka < pA->starts[i + 1]; ++ka) {
+			double a = pA->values[ka];
+			int k = pA->indices[ka];
+			for (size_t kb = pB->starts[k]; kb < pB->starts[k + 1]; ++kb) {
+				col = pB->indices[kb];
+				if (marker[col] != i) {
+					marker[col] = i;
+					if (!count) {
+						pRes->indices[pos] = col;
+						acc[col] = a * pB->values[kb];
+					}
+					++pos;
+				}
+				else if (!count)
+					acc[col] += a * pB->values[kb];
+			}
+		}
+
+		if (count)
+			pRes->starts[i + 1] = pos;
+		else {
+			sortRow(pRes->indices + pRes->starts[i], pos - pRes->starts[i]);
+			for (size_t k = pRes->starts[i]; k < pos; ++k)
+				pRes->values[k] = acc[pRes->indices[k]];
+		}
+	}
+
+	matrix_free(marker);
+	matrix_free(acc);
+	return SUCCESS;
+}
+
+
+static void replaceSparse(MATRIX_SPARSE* phSpRes, MatrixSparse* pRes) {
+	MatrixSparse* pOld = *phSpRes;
+
+	if (!pOld) {
+		*phSpRes = pRes;
+		return;
+	}
+	matrix_free(pOld->starts);
+	matrix_free(pOld->indices);
+	matrix_free(pOld->values);
+	*pOld = *pRes;
+	matrix_free(pRes);
+}
+
+
+static void sortRow(int* indices, size_t count) {
+	int temp;
+	size_t j;
+
+	if (count > SPARSE_SORT_MIN) {
+		qsort(indices, count, sizeof(*indices), compareInts);
+		return;
+	}
+	for (size_t i = 1; i < count; ++i) {
+		temp = indices[i];
+		for (j = i; j > 0 && indices[j - 1] > temp; --j)
+			indices[j] = indices[j - 1];
+		indices[j] = temp;
+	}
+}
+
+
+static int* splitRows(const size_t* work, int rows, int* pNumTasks) {
+	int numTasks = 1;
+	int* bounds;
+	size_t target;
+	int lo, hi, mid;
+
+	if (work[rows] >= SPARSE_PARALLEL_MIN_WORK && threadPool_getNumThreads() > 1) {
+		numTasks = threadPool_getNumThreads() * SPARSE_TASKS_PER_THREAD;
+		if (numTasks > rows)
+			numTasks = rows;
+	}
+	if (!(bounds = matrix_alloc(sizeof(*bounds) * (numTasks + 1))))
+		return NULL;
+
+	// each range starts at the first row with at least its share of the work before it
+	bounds[0] = 0;
+	for (int t = 1; t < numTasks; ++t) {
+		target = (size_t)((double)work[rows] * t / numTasks);
+		lo = bounds[t - 1];
+		hi = rows;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (work[mid] < target)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		bounds[t] = lo;
+	}
+	bounds[numTasks] = rows;
+	*pNumTasks = numTasks;
+
+	return bounds;
+}
+
+
+static void transView(MatrixSparse* pSp) {
+	int temp = pSp->rows;
+	pSp->rows = pSp->cols;
+	pSp->cols = temp;
+	pSp->format = (pSp->format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR;
+}
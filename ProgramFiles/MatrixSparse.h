@@ -0,0 +1,389 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixSparse.h
+  Description:  Header file for the sparse matrix opaque object interface.
+                A sparse matrix stores only its nonzero entries in compressed sparse row (CSR) or compressed sparse column (CSC) form,
+                so its memory and the cost of its operations grow with the nonzeros instead of rows * columns.
+                It is built from triplet arrays or a matrix object, converts back to a matrix object, and multiplies with matrix objects.
+*/
+
+
+#ifndef MATRIX_SPARSE_H
+#define MATRIX_SPARSE_H
+
+#include <stddef.h>
+#include "Matrix.h"
+#include "Status.h"
+
+typedef void* MATRIX_SPARSE;    // opaque object handle for sparse matrix objects
+
+typedef enum sparseFormat { SPARSE_CSR, SPARSE_CSC } SparseFormat;    // nonzeros grouped by row or by column
+
+
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_destroy
+  - Purpose:  Destroy a sparse matrix.
+PRECONDITION
+  - phSp
+      Purpose:       Sparse matrix to destroy.
+      Restrictions:  Pointer to a handle to a valid sparse matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        The handle isn't NULL.
+  - Summary:       Frees the sparse matrix.
+  - Return value:  SUCCESS
+  - phSp:          The handle is set to NULL.
+Failure
+  - Reason:        The handle is NULL.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrixSparse_destroy(MATRIX_SPARSE* phSp);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_getCols
+  - Purpose:  Get the columns of a sparse matrix.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to get the columns of.
+      Restrictions:  Handle to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the columns.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int matrixSparse_getCols(MATRIX_SPARSE hSp);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_getEntry
+  - Purpose:  Get an entry of a sparse matrix with a binary search of its row or column.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to get the entry of.
+      Restrictions:  Handle to a valid sparse matrix object.
+  - row
+      Purpose:       Row of the entry counting from 0.
+      Restrictions:  Any integer >= 0.
+  - col
+      Purpose:       Column of the entry counting from 0.
+      Restrictions:  Any integer >= 0.
+  - pEntry
+      Purpose:       Store the entry.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        The entry is in bounds.
+  - Summary:       Gets the entry, which is 0 if it isn't stored.
+  - Return value:  SUCCESS
+  - pEntry:        Stores the entry.
+Failure
+  - Reason:        The entry is out of bounds.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - pEntry:        Stores 0.
+*/
+Status matrixSparse_getEntry(MATRIX_SPARSE hSp, int row, int col, double* pEntry);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_getFormat
+  - Purpose:  Get whether the nonzeros of a sparse matrix are grouped by row or by column.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to get the format of.
+      Restrictions:  Handle to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the format.
+  - Return value:  SPARSE_CSR or SPARSE_CSC.
+Failure
+  - N/A
+*/
+SparseFormat matrixSparse_getFormat(MATRIX_SPARSE hSp);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_getNnz
+  - Purpose:  Get the number of stored entries of a sparse matrix.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to count the stored entries of.
+      Restrictions:  Handle to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the number of stored entries.
+                   It can include entries that are 0, such as sums that cancel or triplets with the value 0, since the operations keep the pattern of their inputs.
+  - Return value:  Any integer >= 0.
+Failure
+  - N/A
+*/
+size_t matrixSparse_getNnz(MATRIX_SPARSE hSp);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_getRows
+  - Purpose:  Get the rows of a sparse matrix.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to get the rows of.
+      Restrictions:  Handle to a valid sparse matrix object.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the rows.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int matrixSparse_getRows(MATRIX_SPARSE hSp);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_initDense
+  - Purpose:  Initialize a sparse matrix with the nonzero entries of a matrix object.
+PRECONDITION
+  - hMx
+      Purpose:       Matrix to convert.
+      Restrictions:  Handle to a valid matrix object.
+  - format
+      Purpose:       Format of the new sparse matrix.
+      Restrictions:  SPARSE_CSR or SPARSE_CSC.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Initializes and returns a sparse matrix with the same dimensions that stores every entry of hMx that isn't 0.
+  - Return value:  Handle to a valid sparse matrix object.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_SPARSE matrixSparse_initDense(MATRIX hMx, SparseFormat format);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_initTriplets
+  - Purpose:  Initialize a sparse matrix from triplet arrays, the sparse counterpart of the array of entries of matrix_newMatrix.
+              Triplet k is the entry values[k] at row rowIdx[k] and column colIdx[k]. The triplets can be in any order and duplicates are summed.
+              They are sorted with two counting sorts, so the cost is O(nnz + rows + cols).
+PRECONDITION
+  - rowIdx, colIdx, values
+      Purpose:       Triplets of the entries.
+      Restrictions:  Arrays of size nnz, or NULL if nnz is 0.
+  - nnz
+      Purpose:       Number of triplets.
+      Restrictions:  Any integer >= 0.
+  - rows, cols
+      Purpose:       Dimensions of the sparse matrix.
+      Restrictions:  Any positive integers.
+  - format
+      Purpose:       Format of the new sparse matrix.
+      Restrictions:  SPARSE_CSR or SPARSE_CSC.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and every triplet is in bounds.
+  - Summary:       Initializes and returns the sparse matrix with an entry for every distinct position of the triplets.
+  - Return value:  Handle to a valid sparse matrix object.
+Failure
+  - Reason:        Memory allocation failure, a triplet is out of bounds, or the dimensions aren't positive.
+  - Summary:       Nothing of significance happens.
+  - Return value:  NULL
+*/
+MATRIX_SPARSE matrixSparse_initTriplets(const int* rowIdx, const int* colIdx, const double* values, size_t nnz, int rows, int cols, SparseFormat format);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_opAdd
+  - Purpose:  Add two sparse matrices by merging their rows or columns, split across the thread pool for large matrices.
+PRECONDITION
+  - hSp1, hSp2
+      Purpose:       Sparse matrices to add.
+      Restrictions:  Handles to valid sparse matrix objects with the same dimensions. If their formats differ, hSp2 is converted to the format of hSp1 first.
+  - phSpRes
+      Purpose:       Store the sum.
+      Restrictions:  Pointer to a handle to a valid sparse matrix object or NULL handle. May be a handle to hSp1 or hSp2.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the dimensions are the same.
+  - Summary:       Calculates the sum in the format of hSp1. An entry is stored wherever either matrix stores one.
+  - Return value:  SUCCESS
+  - phSpRes:       Stores the sum. If it was a NULL handle, a new sparse matrix gets created to store it.
+Failure
+  - Reason:        Memory allocation failure or the dimensions are different.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phSpRes:       The state of the sparse matrix before the function call is preserved, or the handle remains NULL.
+*/
+Status matrixSparse_opAdd(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_opMult
+  - Purpose:  Multiply two sparse matrices with Gustavson's algorithm, which combines the rows of the right matrix selected by each row of the left matrix.
+              The rows of the product are split across the thread pool by the work they take, first to count the entries of each row and then to compute them.
+PRECONDITION
+  - hSp1
+      Purpose:       Left matrix.
+      Restrictions:  Handle to a valid sparse matrix object whose columns equal the rows of hSp2.
+  - hSp2
+      Purpose:       Right matrix.
+      Restrictions:  Handle to a valid sparse matrix object. If its format differs from hSp1 it is converted to the format of hSp1 first.
+  - phSpRes
+      Purpose:       Store the product.
+      Restrictions:  Pointer to a handle to a valid sparse matrix object or NULL handle. May be a handle to hSp1 or hSp2.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the dimensions are compatible.
+  - Summary:       Calculates the product in the format of hSp1. An entry is stored wherever a product of stored entries contributes to it.
+  - Return value:  SUCCESS
+  - phSpRes:       Stores the product. If it was a NULL handle, a new sparse matrix gets created to store it.
+Failure
+  - Reason:        Memory allocation failure or the dimensions aren't compatible.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phSpRes:       The state of the sparse matrix before the function call is preserved, or the handle remains NULL.
+*/
+Status matrixSparse_opMult(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_opMultDense
+  - Purpose:  Multiply a sparse matrix by a matrix object, such as a vector or a block of vectors, split across the thread pool by rows of the product.
+              Each row of the product is a combination of the rows of the dense matrix selected by a row of the sparse matrix, so a CSC matrix is converted to CSR first.
+PRECONDITION
+  - hSp
+      Purpose:       Left matrix.
+      Restrictions:  Handle to a valid sparse matrix object whose columns equal the rows of hMx.
+  - hMx
+      Purpose:       Right matrix.
+      Restrictions:  Handle to a valid matrix object.
+  - phMxRes
+      Purpose:       Store the product.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle. Not a handle to hMx.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the dimensions are compatible.
+  - Summary:       Calculates the product.
+  - Return value:  SUCCESS
+  - phMxRes:       Stores the product, adjusting its dimensions like matrix_opMult. If it was a NULL handle, a new matrix gets created to store it.
+Failure
+  - Reason:        Memory allocation failure, the dimensions aren't compatible, or the result is a view of other dimensions.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phMxRes:       The state of the matrix before the function call is preserved, or the handle remains NULL.
+*/
+Status matrixSparse_opMultDense(MATRIX_SPARSE hSp, MATRIX hMx, MATRIX* phMxRes);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_opSub
+  - Purpose:  Subtract a sparse matrix from another, the same as matrixSparse_opAdd with the entries of hSp2 negated.
+PRECONDITION
+  - Same as matrixSparse_opAdd.
+POSTCONDITION
+  - Same as matrixSparse_opAdd with the difference hSp1 - hSp2 instead of the sum.
+*/
+Status matrixSparse_opSub(MATRIX_SPARSE hSp1, MATRIX_SPARSE hSp2, MATRIX_SPARSE* phSpRes);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_opTrans
+  - Purpose:  Transpose a sparse matrix.
+              The CSR arrays of a matrix are the CSC arrays of its transpose, so the result is a copy of the arrays in the other format.
+              Use matrixSparse_setFormat afterwards to get the transpose in the same format as the matrix.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to transpose.
+      Restrictions:  Handle to a valid sparse matrix object.
+  - phSpRes
+      Purpose:       Store the transpose.
+      Restrictions:  Pointer to a handle to a valid sparse matrix object or NULL handle. May be a handle to hSp.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Calculates the transpose in the other format.
+  - Return value:  SUCCESS
+  - phSpRes:       Stores the transpose. If it was a NULL handle, a new sparse matrix gets created to store it.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phSpRes:       The state of the sparse matrix before the function call is preserved, or the handle remains NULL.
+*/
+Status matrixSparse_opTrans(MATRIX_SPARSE hSp, MATRIX_SPARSE* phSpRes);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_setFormat
+  - Purpose:  Convert a sparse matrix between CSR and CSC with a counting sort of its entries, O(nnz + rows + cols).
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to convert.
+      Restrictions:  Handle to a valid sparse matrix object.
+  - format
+      Purpose:       New format.
+      Restrictions:  SPARSE_CSR or SPARSE_CSC.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Regroups the entries in the new format. Nothing happens if the sparse matrix is already in it.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+Status matrixSparse_setFormat(MATRIX_SPARSE hSp, SparseFormat format);
+
+
+/*
+FUNCTION
+  - Name:     matrixSparse_toDense
+  - Purpose:  Copy a sparse matrix into a matrix object.
+PRECONDITION
+  - hSp
+      Purpose:       Sparse matrix to convert.
+      Restrictions:  Handle to a valid sparse matrix object.
+  - phMxRes
+      Purpose:       Store the matrix.
+      Restrictions:  Pointer to a handle to a valid matrix object or NULL handle.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure and the result isn't a view of other dimensions.
+  - Summary:       Copies every entry, including the ones that are 0.
+  - Return value:  SUCCESS
+  - phMxRes:       Stores the matrix, adjusting its dimensions like matrix_copy. If it was a NULL handle, a new matrix gets created to store it.
+Failure
+  - Reason:        Memory allocation failure or the result is a view of other dimensions.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - phMxRes:       The state of the matrix before the function call is preserved, or the handle remains NULL.
+*/
+Status matrixSparse_toDense(MATRIX_SPARSE hSp, MATRIX* phMxRes);
+
+
+#endif
@@ -0,0 +1,491 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         MatrixSymmetric.c
+  Description:  Implementation file for the symmetric matrix functions of the matrix opaque object interface.
+*/
+
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "Matrix.h"
+#include "MatrixInternal.h"
+
+
+#define SYM_GRAM_BLOCK 128    // rows of the Gram matrix computed by each product, so the blocks below the diagonal it also computes are a small part of the work
+#define SYM_CHOL_BLOCK 64     // rows of R factored before the rest of the matrix is updated with them, so each row below stays in L1 while the panel is applied to it
+
+
+typedef struct matrixSymmetric {
+	int n;              // rows and columns
+	double* entries;    // the upper triangle row by row, n (n + 1) / 2 entries with entry (i, j) for i <= j at index i * n - i (i - 1) / 2 + j - i
+} MatrixSymmetric;
+
+
+
+
+/*********** Declarations for helper functions defined in this file **********/
+/*
+FUNCTION
+  - Name:     adjustSymmetric
+  - Purpose:  Make a symmetric matrix n x n, or create it if the handle is NULL, like adjustMatrixDims does for matrix objects.
+PRECONDITION
+  - phSym
+      Purpose:       Symmetric matrix to adjust.
+      Restrictions:  Pointer to a handle to a valid symmetric matrix object or NULL handle.
+  - n
+      Purpose:       Rows and columns.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       The matrix is n x n. Its entries are kept if it already was and are unspecified otherwise.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+*/
+static Status adjustSymmetric(MATRIX_SYMMETRIC* phSym, int n);
+
+
+/*
+FUNCTION
+  - Name:     choleskyFactorize
+  - Purpose:  Factor a symmetric matrix as A = R^T R with R upper triangular, stored packed like the matrix.
+              The rows of R are factored in panels of SYM_CHOL_BLOCK and each row below a panel is updated with all of it at once by choleskyUpdateRow,
+              so the trailing matrix is read once per panel instead of once per row. It takes n^3 / 3 operations, half as many as LU.
+              A pivot that isn't positive or is reduced to rounding noise relative to the diagonal entry it started from means A isn't positive definite.
+PRECONDITION
+  - pSym
+      Purpose:       Matrix to factor.
+      Restrictions:  Pointer to a valid symmetric matrix object.
+  - pR
+      Purpose:       Store the packed rows of R.
+      Restrictions:  Not NULL.
+  - pMxIsPosDef
+      Purpose:       Indicate if A is positive definite. TRUE means it is, the opposite sense of pMxIsInvertible, which is TRUE when a matrix can't be inverted.
+      Restrictions:  Not NULL.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Factors the matrix if it is positive definite.
+  - Return value:  SUCCESS
+  - pR:            Stores R, allocated from the scratch arena of the calling thread and released with the mark taken before the call,
+                   or NULL if A isn't positive definite.
+  - pMxIsPosDef:   The Boolean it points to is set to TRUE if A is positive definite and FALSE otherwise.
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Nothing of significance happens.
+  - Return value:  FAILURE
+  - pR:            Stores NULL.
+  - pMxIsPosDef:   The Boolean it points to is set to TRUE, since A isn't the reason for the failure.
+*/
+static Status choleskyFactorize(const MatrixSymmetric* pSym, double** pR, Boolean* pMxIsPosDef);
+
+
+/*
+FUNCTION
+  - Name:     choleskyUpdateRow
+  - Purpose:  Subtract the contributions of factored rows k0 to k1 - 1 of R from row i of the matrix being factored, four rows at a time
+              so row i is loaded and stored once for every four of them.
+PRECONDITION
+  - r
+      Purpose:       Packed rows of the matrix being factored.
+      Restrictions:  Rows k0 to k1 - 1 are rows of R.
+  - n
+      Purpose:       Rows and columns.
+      Restrictions:  Any positive integer.
+  - i
+      Purpose:       Row to update.
+      Restrictions:  Any integer >= k1 less than n.
+  - k0, k1
+      Purpose:       Rows of R to apply.
+      Restrictions:  0 <= k0 <= k1.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Subtracts R(k, i) times row k of R from row i for every k from k0 to k1 - 1.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void choleskyUpdateRow(double* r, int n, int i, int k0, int k1);
+
+
+/*
+FUNCTION
+  - Name:     packedIdx
+  - Purpose:  Find the index of entry (i, j) with i <= j in the packed upper triangle of an n x n matrix.
+PRECONDITION
+  - n
+      Purpose:       Rows and columns.
+      Restrictions:  Any positive integer.
+  - i, j
+      Purpose:       Row and column of the entry.
+      Restrictions:  0 <= i <= j < n.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the index.
+  - Return value:  The index of the entry.
+Failure
+  - N/A
+*/
+static ptrdiff_t packedIdx(int n, int i, int j);
+
+
+/*
+FUNCTION
+  - Name:     packedSize
+  - Purpose:  Find the number of entries in the packed upper triangle of an n x n matrix.
+PRECONDITION
+  - n
+      Purpose:       Rows and columns.
+      Restrictions:  Any positive integer.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns n (n + 1) / 2.
+  - Return value:  The number of entries.
+Failure
+  - N/A
+*/
+static size_t packedSize(int n);
+
+
+
+
+/********** Definitions for symmetric matrix interface functions declared in Matrix.h **********/
+Status matrix_opGram(MATRIX hMxA, MATRIX_SYMMETRIC* phSymRes) {
+	MatrixSymmetric* pSym;
+	const double* a;
+	double* block;       // rows of the Gram matrix from the diagonal to the last column, before they're packed
+	ptrdiff_t rs, cs;
+	int m = matrix_getRows(hMxA);
+	int n = matrix_getCols(hMxA);
+	int blockRows = (n < SYM_GRAM_BLOCK) ? n : SYM_GRAM_BLOCK;
+	size_t mark = matrix_internalScratchMark();
+
+
+	if (!(block = matrix_internalScratchAlloc(sizeof(*block) * (size_t)blockRows * n)) || !adjustSymmetric(phSymRes, n)) {
+		matrix_internalScratchRelease(mark);
+		return FAILURE;
+	}
+	pSym = *phSymRes;
+	a = matrix_internalGetEntries(hMxA, &rs, &cs);
+
+	// rows i0 to i0 + rows - 1 of A^T A from column i0 on are the product of those columns of A transposed and the columns from i0 on,
+	// so only the blocks on the diagonal compute entries below it and the product takes about half the operations of A^T times A
+	for (int i0 = 0; i0 < n; i0 += blockRows) {
+		int rows = (n - i0 < blockRows) ? n - i0 : blockRows;
+		int cols = n - i0;
+		if (!matrix_internalGemmParallel(rows, cols, m, a + i0 * cs, cs, rs, a + i0 * cs, rs, cs, block, cols, 1)) {
+			matrix_internalScratchRelease(mark);
+			return FAILURE;
+		}
+		for (int i = 0; i < rows; ++i)
+			memcpy(pSym->entries + packedIdx(n, i0 + i, i0 + i), block + (ptrdiff_t)i * cols + i, sizeof(*block) * (cols - i));
+	}
+	matrix_internalScratchRelease(mark);
+
+	return SUCCESS;
+}
+
+
+Status matrix_symmetricCholesky(MATRIX_SYMMETRIC hSym, Boolean* pMxIsPosDef, MATRIX* phMxR) {
+	MatrixSymmetric* pSym = hSym;
+	double* r;
+	double* entries;
+	ptrdiff_t rs, cs;
+	int n = pSym->n;
+	size_t mark = matrix_internalScratchMark();
+
+	if (!choleskyFactorize(pSym, &r, pMxIsPosDef) || !r)
+		return FAILURE;
+	if (!matrix_internalAdjustDims(phMxR, n, n, TRUE)) {
+		matrix_internalScratchRelease(mark);
+		return FAILURE;
+	}
+
+	entries = matrix_internalGetEntries(*phMxR, &rs, &cs);
+	for (int i = 0; i < n; ++i) {
+		const double* ri = r + packedIdx(n, i, i);
+		for (int j = i; j < n; ++j)
+			entries[i * rs + j * cs] = ri[j - i];
+	}
+	matrix_internalScratchRelease(mark);
+
+	return SUCCESS;
+}
+
+
+Status matrix_symmetricDestroy(MATRIX_SYMMETRIC* phSym) {
+	MatrixSymmetric* pSym = *phSym;
+	if (pSym) {
+		matrix_free(pSym->entries);
+		matrix_free(pSym);
+		*phSym = NULL;
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+
+Status matrix_symmetricGetEntry(MATRIX_SYMMETRIC hSym, int row, int col, double* pEntry) {
+	MatrixSymmetric* pSym = hSym;
+
+	*pEntry = 0;
+	if (row < 0 || row >= pSym->n || col < 0 || col >= pSym->n)
+		return FAILURE;
+	*pEntry = (row <= col) ? pSym->entries[packedIdx(pSym->n, row, col)] : pSym->entries[packedIdx(pSym->n, col, row)];
+
+	return SUCCESS;
+}
+
+
+int matrix_symmetricGetRows(MATRIX_SYMMETRIC hSym) {
+	MatrixSymmetric* pSym = hSym;
+	return pSym->n;
+}
+
+
+MATRIX_SYMMETRIC matrix_symmetricInit(int n) {
+	MatrixSymmetric* pSym;
+
+	if (n < 1)
+		return NULL;
+	if (!(pSym = matrix_alloc(sizeof(*pSym))))
+		return NULL;
+	if (!(pSym->entries = matrix_alloc(sizeof(*pSym->entries) * packedSize(n)))) {
+		matrix_free(pSym);
+		return NULL;
+	}
+	memset(pSym->entries, 0, sizeof(*pSym->entries) * packedSize(n));
+	pSym->n = n;
+
+	return pSym;
+}
+
+
+MATRIX_SYMMETRIC matrix_symmetricInitDense(MATRIX hMx) {
+	MatrixSymmetric* pSym;
+	const double* entries;
+	ptrdiff_t rs, cs;
+	int n = matrix_getRows(hMx);
+
+	if (matrix_getCols(hMx) != n || !(pSym = matrix_symmetricInit(n)))
+		return NULL;
+
+	// only the upper triangle is read, the entries below the diagonal are taken to be its mirror
+	entries = matrix_internalGetEntries(hMx, &rs, &cs);
+	for (int i = 0; i < n; ++i) {
+		double* row = pSym->entries + packedIdx(n, i, i);
+		for (int j = i; j < n; ++j)
+			row[j - i] = entries[i * rs + j * cs];
+	}
+
+	return pSym;
+}
+
+
+Status matrix_symmetricSetEntry(MATRIX_SYMMETRIC hSym, int row, int col, double entry) {
+	MatrixSymmetric* pSym = hSym;
+
+	if (row < 0 || row >= pSym->n || col < 0 || col >= pSym->n)
+		return FAILURE;
+	if (row <= col)
+		pSym->entries[packedIdx(pSym->n, row, col)] = entry;
+	else
+		pSym->entries[packedIdx(pSym->n, col, row)] = entry;
+
+	return SUCCESS;
+}
+
+
+Status matrix_symmetricSolve(MATRIX_SYMMETRIC hSym, MATRIX hMxB, Boolean* pMxIsPosDef, MATRIX* phMxX) {
+	MatrixSymmetric* pSym = hSym;
+	const double* b;
+	double* r;
+	double* x;
+	ptrdiff_t rsb, csb, rs, cs;
+	int n = pSym->n;
+	int cols = matrix_getCols(hMxB);
+	size_t mark = matrix_internalScratchMark();
+
+
+	*pMxIsPosDef = TRUE;    // assume A is positive definite
+	if (matrix_getRows(hMxB) != n || !choleskyFactorize(pSym, &r, pMxIsPosDef) || !r)
+		return FAILURE;
+
+	// solve in the result matrix, starting from a copy of B unless it is B
+	if (!matrix_internalAdjustDims(phMxX, n, cols, FALSE)) {
+		matrix_internalScratchRelease(mark);
+		return FAILURE;
+	}
+	b = matrix_internalGetEntries(hMxB, &rsb, &csb);
+	x = matrix_internalGetEntries(*phMxX, &rs, &cs);
+	if (*phMxX != hMxB) {
+		for (int i = 0; i < n; ++i) {
+			for (int c = 0; c < cols; ++c)
+				x[i * rs + c * cs] = b[i * rsb + c * csb];
+		}
+	}
+
+	// R^T y = b from the first row down, row k of R is column k of R^T so each solved entry is eliminated from the rows below it
+	for (int k = 0; k < n; ++k) {
+		const double* rk = r + packedIdx(n, k, k);
+		double* xk = x + k * rs;
+		for (int c = 0; c < cols; ++c)
+			xk[c * cs] /= rk[0];
+		for (int j = k + 1; j < n; ++j) {
+			double* xj = x + j * rs;
+			if (rk[j - k] != 0) {
+				for (int c = 0; c < cols; ++c)
+					xj[c * cs] -= rk[j - k] * xk[c * cs];
+			}
+		}
+	}
+
+	// R x = y from the last row up
+	for (int i = n - 1; i >= 0; --i) {
+		const double* ri = r + packedIdx(n, i, i);
+		double* xi = x + i * rs;
+		for (int j = i + 1; j < n; ++j) {
+			const double* xj = x + j * rs;
+			if (ri[j - i] != 0) {
+				for (int c = 0; c < cols; ++c)
+					xi[c * cs] -= ri[j - i] * xj[c * cs];
+			}
+		}
+		for (int c = 0; c < cols; ++c)
+			xi[c * cs] /= ri[0];
+	}
+	matrix_internalScratchRelease(mark);
+
+	return SUCCESS;
+}
+
+
+Status matrix_symmetricToDense(MATRIX_SYMMETRIC hSym, MATRIX* phMxRes) {
+	MatrixSymmetric* pSym = hSym;
+	double* entries;
+	ptrdiff_t rs, cs;
+	int n = pSym->n;
+
+	if (!matrix_internalAdjustDims(phMxRes, n, n, FALSE))
+		return FAILURE;
+
+	entries = matrix_internalGetEntries(*phMxRes, &rs, &cs);
+	for (int i = 0; i < n; ++i) {
+		const double* row = pSym->entries + packedIdx(n, i, i);
+		for (int j = i; j < n; ++j)
+			entries[i * rs + j * cs] = entries[j * rs + i * cs] = row[j - i];
+	}
+
+	return SUCCESS;
+}
+
+
+
+
+/********** Helper function definitions **********/
+static Status adjustSymmetric(MATRIX_SYMMETRIC* phSym, int n) {
+	MatrixSymmetric* pSym = *phSym;
+	double* entries;
+
+	if (!pSym)
+		return (*phSym = matrix_symmetricInit(n)) != NULL;
+	if (pSym->n != n) {
+		if (!(entries = matrix_alloc(sizeof(*entries) * packedSize(n))))
+			return FAILURE;
+		matrix_free(pSym->entries);
+		pSym->entries = entries;
+		pSym->n = n;
+	}
+
+	return SUCCESS;
+}
+
+
+static Status choleskyFactorize(const MatrixSymmetric* pSym, double** pR, Boolean* pMxIsPosDef) {
+	int n = pSym->n;
+	double* r;
+	size_t mark = matrix_internalScratchMark();
+
+	*pR = NULL;
+	*pMxIsPosDef = TRUE;
+	if (!(r = matrix_internalScratchAlloc(sizeof(*r) * packedSize(n)))) {
+		matrix_internalScratchRelease(mark);
+		return FAILURE;
+	}
+	memcpy(r, pSym->entries, sizeof(*r) * packedSize(n));
+
+	for (int k0 = 0; k0 < n; k0 += SYM_CHOL_BLOCK) {
+		int k1 = (n - k0 < SYM_CHOL_BLOCK) ? n : k0 + SYM_CHOL_BLOCK;
+
+		// factor the rows of the panel, applying each one only to the rows of the panel below it
+		for (int k = k0; k < k1; ++k) {
+			double* rk = r + packedIdx(n, k, k);
+			double pivot = rk[0];
+			double scale;
+
+			// the negation also catches a pivot that is NaN
+			if (!(pivot > n * DBL_EPSILON * pSym->entries[packedIdx(n, k, k)])) {
+				*pMxIsPosDef = FALSE;
+				matrix_internalScratchRelease(mark);
+				return SUCCESS;
+			}
+			rk[0] = sqrt(pivot);
+			scale = 1 / rk[0];
+			for (int j = 1; j < n - k; ++j)
+				rk[j] *= scale;
+			for (int i = k + 1; i < k1; ++i)
+				choleskyUpdateRow(r, n, i, k, k + 1);
+		}
+
+		// then apply the whole panel to each row below it
+		for (int i = k1; i < n; ++i)
+			choleskyUpdateRow(r, n, i, k0, k1);
+	}
+	*pR = r;
+
+	return SUCCESS;
+}
+
+
+static void choleskyUpdateRow(double* r, int n, int i, int k0, int k1) {
+	double* restrict ri = r + packedIdx(n, i, i);
+	int len = n - i;
+	int k = k0;
+
+	// rk points at entry (k, i) of R, so rk[j] is entry (k, i + j) and lines up with ri[j]
+	for (; k + 4 <= k1; k += 4) {
+		const double* restrict r0 = r + packedIdx(n, k, i);
+		const double* restrict r1 = r + packedIdx(n, k + 1, i);
+		const double* restrict r2 = r + packedIdx(n, k + 2, i);
+		const double* restrict r3 = r + packedIdx(n, k + 3, i);
+		double f0 = r0[0], f1 = r1[0], f2 = r2[0], f3 = r3[0];
+		for (int j = 0; j < len; ++j)
+			ri[j] -= f0 * r0[j] + f1 * r1[j] + f2 * r2[j] + f3 * r3[j];
+	}
+	for (; k < k1; ++k) {
+		const double* restrict rk = r + packedIdx(n, k, i);
+		double f = rk[0];
+		if (f != 0) {
+			for (int j = 0; j < len; ++j)
+				ri[j] -= f * rk[j];
+		}
+	}
+}
+
+
+static ptrdiff_t packedIdx(int n, int i, int j) {
+	return (ptrdiff_t)i * n - (ptrdiff_t)i * (i - 1) / 2 + j - i;
+}
+
+
+static size_t packedSize(int n) {
+	return (size_t)n * (n + 1) / 2;
+}
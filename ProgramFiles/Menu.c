@@ -26,6 +26,7 @@ const MenuOptionMessages menuOptionMessages[] = {
 	{ TRANS, "Transpose" },
 	{ DET,   "Determinant" },
 	{ INV,   "Inverse" },
+	{ SOLVE, "Solve A X = B" },
 };
 const int menuOptionMessagesSize = sizeof(menuOptionMessages) / sizeof(*menuOptionMessages);
 
@@ -35,7 +36,7 @@ const int menuOptionMessagesSize = sizeof(menuOptionMessages) / sizeof(*menuOpti
 
 
 /*********** Declarations for helper functions defined in Matrix.c **********/
-int at2(int rows, int cols, int row, int col);
+ptrdiff_t at2(int rows, int cols, int row, int col);
 
 
 
@@ -99,8 +100,8 @@ PRECONDITION
       Purpose:       Indicate which matrix operation is being performed.
       Restrictions:  Not QUIT.
   - pMxNum
-      Purpose:       Indicate if "1st" or "2nd" should be printed for multiplication.
-      Restrictions:  If operation is multiplication, the integer it points to is 1 or 2.
+      Purpose:       Indicate if "1st" or "2nd" should be printed for multiplication or "A" or "B" for solving a linear system.
+      Restrictions:  If operation is multiplication or solving a linear system, the integer it points to is 1 or 2.
 		     NULL if otherwise.
 POSTCONDITION
 Success
@@ -305,6 +306,35 @@ Failure
 static void displayResultsMatrixOpPow(MATRIX hMx, int power, MATRIX hMxRes);
 
 
+/*
+FUNCTION
+  - Name:     displayResultsMatrixOpSolve
+  - Purpose:  Display the result of solving a linear system.
+PRECONDITION
+  - The linear system has been solved.
+  - hMxA
+      Purpose:       The coefficient matrix A.
+      Restrictions:  Handle to a valid matrix object.
+  - hMxB
+      Purpose:       The right-hand side B.
+      Restrictions:  Handle to a valid matrix object.
+  - mxIsInvertible
+      Purpose:       Indicate if A was invertible.
+      Restrictions:  N/A
+  - hMxX
+      Purpose:       The solution X if A was vertible.
+      Restrictions:  Handle to a valid matrix object or NULL if A was invertible.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Displays the result of solving the linear system.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void displayResultsMatrixOpSolve(MATRIX hMxA, MATRIX hMxB, Boolean mxIsInvertible, MATRIX hMxX);
+
+
 /*
 FUNCTION
   - Name:     displayResultsMatrixOpSub
@@ -506,6 +536,10 @@ PRECONDITION
   - op
       Purpose:       Indicate which matrix operation is being performed.
       Restrictions:  Not QUIT.
+  - pMxNum
+      Purpose:       Indicate which matrix of a linear system the dimensions are for.
+      Restrictions:  If operation is solving a linear system, the integer it points to is 1 for A or 2 for B.
+                     NULL if otherwise.
   - pRows
       Purpose:       Store the rows.
       Restrictions:  Not NULL.
@@ -516,7 +550,7 @@ POSTCONDITION
 Success
   - Reason:        All cases.
   - Summary:       Prompts the user to enter the dimensions.
-                   Validates that the input is two valid positive integers, and for power, determinant, and inverse, that the rows equal the columns.
+                   Validates that the input is two valid positive integers, and for power, determinant, inverse, and A in a linear system, that the rows equal the columns.
 				   Stores the inputs in the row and column.
   - Return value:  N/A
   - pRows          The integer it points to is set to the rows.
@@ -524,7 +558,7 @@ Success
 Failure
   - N/A
 */
-static void userInputGetDims(MenuOption op, int* pRows, int* pCols);
+static void userInputGetDims(MenuOption op, const int* pMxNum, int* pRows, int* pCols);
 
 
 /*
@@ -669,6 +703,10 @@ Status menu_implementUserChoice(MenuOption userChoice) {
 		if (!menu_matrixOpInv())
 			status = FAILURE;
 		break;
+	case SOLVE:
+		if (!menu_matrixOpSolve())
+			status = FAILURE;
+		break;
 	default: // QUIT
 		break;
 	}
@@ -692,12 +730,12 @@ Status menu_matrixOpAdd(void) {
 
 	// get the dimensions of each matrix (all are the same)
 	displayDimsPrompt(ADD, NULL);
-	userInputGetDims(ADD, &rows, &cols);
+	userInputGetDims(ADD, NULL, &rows, &cols);
 
 	// create the matrices being added and the result matrix
 	if (!(hMxRes = matrix_initDims(rows, cols)))
 		return FAILURE;
-	if (!(hMxs = calloc(numMxs, sizeof(*hMxs)))) {
+	if (!(hMxs = matrix_alloc(sizeof(*hMxs) * numMxs))) {
 		matrix_destroy(&hMxRes);
 		return FAILURE;
 	}
@@ -707,7 +745,7 @@ Status menu_matrixOpAdd(void) {
 				for (; i >= 0; --i)
 					matrix_destroy(&hMxs[i]);
 			}
-			free(hMxs);
+			matrix_free(hMxs);
 			matrix_destroy(&hMxRes);
 			return FAILURE;
 		}
@@ -718,7 +756,7 @@ Status menu_matrixOpAdd(void) {
 	if (!(entries = entriesInitDims(rows, cols))) {
 		for (int i = 0; i < numMxs; ++i)
 			matrix_destroy(&hMxs[i]);
-		free(hMxs);
+		matrix_free(hMxs);
 		matrix_destroy(&hMxRes);
 		return FAILURE;
 	}
@@ -730,9 +768,9 @@ Status menu_matrixOpAdd(void) {
 		if (!matrix_newMatrix(hMxs[i], entries, rows, cols)) {
 			for (int i = 0; i < numMxs; ++i)
 				matrix_destroy(&hMxs[i]);
-			free(hMxs);
+			matrix_free(hMxs);
 			matrix_destroy(&hMxRes);
-			free(entries);
+			matrix_free(entries);
 			return FAILURE;
 		}
 	}
@@ -741,9 +779,9 @@ Status menu_matrixOpAdd(void) {
 	if (!matrix_opAdd(hMxs, numMxs, &hMxRes)) {
 		for (int i = 0; i < numMxs; ++i)
 			matrix_destroy(&hMxs[i]);
-		free(hMxs);
+		matrix_free(hMxs);
 		matrix_destroy(&hMxRes);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -753,9 +791,9 @@ Status menu_matrixOpAdd(void) {
 	// clean up memory
 	for (int i = 0; i < numMxs; ++i)
 		matrix_destroy(&hMxs[i]);
-	free(hMxs);
+	matrix_free(hMxs);
 	matrix_destroy(&hMxRes);
-	free(entries);
+	matrix_free(entries);
 
 	return SUCCESS;
 }
@@ -771,7 +809,7 @@ Status menu_matrixOpInv(void) {
 
 	// get the dimensions of the matrix from user input
 	displayDimsPrompt(INV, NULL);
-	userInputGetDims(INV, &rows, &cols);
+	userInputGetDims(INV, NULL, &rows, &cols);
 
 	// create the matrix from the dimensions
 	if (!(hMx = matrix_initDims(rows, cols)))
@@ -787,7 +825,7 @@ Status menu_matrixOpInv(void) {
 	userInputGetEntries(entries, rows, cols);
 	if (!matrix_newMatrix(hMx, entries, rows, cols)) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -797,7 +835,7 @@ Status menu_matrixOpInv(void) {
 		if (!mxIsInvertible) {
 			matrix_destroy(&hMx);
 			matrix_destroy(&hMxRes);
-			free(entries);
+			matrix_free(entries);
 			return FAILURE;
 		}
 	}
@@ -808,7 +846,106 @@ Status menu_matrixOpInv(void) {
 	// clean up memory
 	matrix_destroy(&hMx);
 	matrix_destroy(&hMxRes);
-	free(entries);
+	matrix_free(entries);
+
+	return SUCCESS;
+}
+
+
+Status menu_matrixOpSolve(void) {
+	MATRIX hMxA;                       // coefficient matrix
+	MATRIX hMxB;                       // right-hand side
+	MATRIX hMxX = NULL;                // solution
+	double *entriesA, *entriesB;       // entries of A and B
+	int rowsA, colsA, rowsB, colsB;    // dimensions of A and B
+	int mxNum;                         // indicates which matrix is being used during user input
+	Boolean mxIsInvertible;            // indicate if A is invertible while solving
+	Boolean canBeSolved;               // indicates if the dimensions of A and B match
+
+
+	// get the dimensions of the matrices from user input
+	do {
+		mxNum = 1;
+		displayDimsPrompt(SOLVE, &mxNum);
+		userInputGetDims(SOLVE, &mxNum, &rowsA, &colsA);
+
+		mxNum = 2;
+		displayDimsPrompt(SOLVE, &mxNum);
+		userInputGetDims(SOLVE, &mxNum, &rowsB, &colsB);
+
+		canBeSolved = dimsCanBeMultiplied(colsA, rowsB);
+		if (!canBeSolved) {
+			printf("Input error. The rows of B must equal the rows of A in order to solve A X = B.\n"
+                   "Re-enter the dimensions starting with A.\n");
+		}
+	} while (!canBeSolved);
+
+
+	// create A and B
+	if (!(hMxA = matrix_initDims(rowsA, colsA)))
+		return FAILURE;
+	if (!(hMxB = matrix_initDims(rowsB, colsB))) {
+		matrix_destroy(&hMxA);
+		return FAILURE;
+	}
+
+	// get the entries of the matrices from user input and fill up the matrices
+	// A
+	if (!(entriesA = entriesInitDims(rowsA, colsA))) {
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+		return FAILURE;
+	}
+
+	displayEntriesPrompt(SOLVE, NULL, rowsA, colsA);
+	userInputGetEntries(entriesA, rowsA, colsA);
+	if (!matrix_newMatrix(hMxA, entriesA, rowsA, colsA)) {
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+		matrix_free(entriesA);
+		return FAILURE;
+	}
+
+	// B
+	if (!(entriesB = entriesInitDims(rowsB, colsB))) {
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+		matrix_free(entriesA);
+		return FAILURE;
+	}
+
+	displayEntriesPrompt(SOLVE, NULL, rowsB, colsB);
+	userInputGetEntries(entriesB, rowsB, colsB);
+	if (!matrix_newMatrix(hMxB, entriesB, rowsB, colsB)) {
+		matrix_destroy(&hMxA);
+		matrix_destroy(&hMxB);
+		matrix_free(entriesA);
+		matrix_free(entriesB);
+		return FAILURE;
+	}
+
+	// solve the system
+	if (!matrix_opSolve(hMxA, hMxB, &mxIsInvertible, &hMxX)) {
+		// memory allocation failure - status would have returned FAILURE but invertible boolean would be FALSE
+		if (!mxIsInvertible) {
+			matrix_destroy(&hMxA);
+			matrix_destroy(&hMxB);
+			matrix_destroy(&hMxX);
+			matrix_free(entriesA);
+			matrix_free(entriesB);
+			return FAILURE;
+		}
+	}
+
+	// display results
+	displayResultsMatrixOpSolve(hMxA, hMxB, mxIsInvertible, hMxX);
+
+	// clean up memory
+	matrix_destroy(&hMxA);
+	matrix_destroy(&hMxB);
+	matrix_destroy(&hMxX);
+	matrix_free(entriesA);
+	matrix_free(entriesB);
 
 	return SUCCESS;
 }
@@ -828,11 +965,11 @@ Status menu_matrixOpMult(void) {
 	do {
 		mxNum = 1;
 		displayDimsPrompt(MULT, &mxNum);
-		userInputGetDims(MULT, &rows1, &cols1);
+		userInputGetDims(MULT, &mxNum, &rows1, &cols1);
 
 		mxNum = 2;
 		displayDimsPrompt(MULT, &mxNum);
-		userInputGetDims(MULT, &rows2, &cols2);
+		userInputGetDims(MULT, &mxNum, &rows2, &cols2);
 
 		canBeMultiplied = dimsCanBeMultiplied(cols1, rows2);
 		if (!canBeMultiplied) {
@@ -863,7 +1000,7 @@ Status menu_matrixOpMult(void) {
 	if (!matrix_newMatrix(hMx1, entries1, rows1, cols1)) {
 		matrix_destroy(&hMx1);
 		matrix_destroy(&hMx2);
-		free(entries1);
+		matrix_free(entries1);
 		return FAILURE;
 	}
 
@@ -871,7 +1008,7 @@ Status menu_matrixOpMult(void) {
 	if (!(entries2 = entriesInitDims(rows2, cols2))) {
 		matrix_destroy(&hMx1);
 		matrix_destroy(&hMx2);
-		free(entries1);
+		matrix_free(entries1);
 		return FAILURE;
 	}
 
@@ -880,8 +1017,8 @@ Status menu_matrixOpMult(void) {
 	if (!matrix_newMatrix(hMx2, entries2, rows2, cols2)) {
 		matrix_destroy(&hMx1);
 		matrix_destroy(&hMx2);
-		free(entries1);
-		free(entries2);
+		matrix_free(entries1);
+		matrix_free(entries2);
 		return FAILURE;
 	}
 
@@ -890,8 +1027,8 @@ Status menu_matrixOpMult(void) {
 		matrix_destroy(&hMx1);
 		matrix_destroy(&hMx2);
 		matrix_destroy(&hMxRes);
-		free(entries1);
-		free(entries2);
+		matrix_free(entries1);
+		matrix_free(entries2);
 		return FAILURE;
 	}
 
@@ -902,8 +1039,8 @@ Status menu_matrixOpMult(void) {
 	matrix_destroy(&hMx1);
 	matrix_destroy(&hMx2);
 	matrix_destroy(&hMxRes);
-	free(entries1);
-	free(entries2);
+	matrix_free(entries1);
+	matrix_free(entries2);
 
 	return SUCCESS;
 }
@@ -923,7 +1060,7 @@ Status menu_matrixOpPow(void) {
 
 	// get the dimensions of the matrix from user input
 	displayDimsPrompt(POW, NULL);
-	userInputGetDims(POW, &rows, &cols);
+	userInputGetDims(POW, NULL, &rows, &cols);
 
 	// create the matrix to be used in the power operation
 	if (!(hMx = matrix_initDims(rows, cols)))
@@ -939,7 +1076,7 @@ Status menu_matrixOpPow(void) {
 	userInputGetEntries(entries, rows, cols);
 	if (!matrix_newMatrix(hMx, entries, rows, cols)) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -955,7 +1092,7 @@ Status menu_matrixOpPow(void) {
 	// clean up memory
 	matrix_destroy(&hMx);
 	matrix_destroy(&hMxRes);
-	free(entries);
+	matrix_free(entries);
 
 	return SUCCESS;
 }
@@ -976,12 +1113,12 @@ Status menu_matrixOpSub(void) {
 
 	// get the dimensions of each matrix (all are the same)
 	displayDimsPrompt(SUB, NULL);
-	userInputGetDims(SUB, &rows, &cols);
+	userInputGetDims(SUB, NULL, &rows, &cols);
 
 	// create the result matrix and the matrix array
 	if (!(hMxRes = matrix_initDims(rows, cols)))
 		return FAILURE;
-	if (!(hMxs = calloc(numMxs, sizeof(*hMxs)))) {
+	if (!(hMxs = matrix_alloc(sizeof(*hMxs) * numMxs))) {
 		matrix_destroy(&hMxRes);
 		return FAILURE;
 	}
@@ -991,7 +1128,7 @@ Status menu_matrixOpSub(void) {
 				for (; i >= 0; --i)
 					matrix_destroy(&hMxs[i]);
 			}
-			free(hMxs);
+			matrix_free(hMxs);
 			matrix_destroy(&hMxRes);
 			return FAILURE;
 		}
@@ -1001,7 +1138,7 @@ Status menu_matrixOpSub(void) {
 	if (!(entries = entriesInitDims(rows, cols))) {
 		for (int i = 0; i < numMxs; ++i)
 			matrix_destroy(&hMxs[i]);
-		free(hMxs);
+		matrix_free(hMxs);
 		matrix_destroy(&hMxRes);
 		return FAILURE;
 	}
@@ -1013,9 +1150,9 @@ Status menu_matrixOpSub(void) {
 		if (!matrix_newMatrix(hMxs[i], entries, rows, cols)) {
 			for (int i = 0; i < numMxs; ++i)
 				matrix_destroy(&hMxs[i]);
-			free(hMxs);
+			matrix_free(hMxs);
 			matrix_destroy(&hMxRes);
-			free(entries);
+			matrix_free(entries);
 			return FAILURE;
 		}
 	}
@@ -1024,9 +1161,9 @@ Status menu_matrixOpSub(void) {
 	if (!matrix_opSub(hMxs, numMxs, &hMxRes)) {
 		for (int i = 0; i < numMxs; ++i)
 			matrix_destroy(&hMxs[i]);
-		free(hMxs);
+		matrix_free(hMxs);
 		matrix_destroy(&hMxRes);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -1036,9 +1173,9 @@ Status menu_matrixOpSub(void) {
 	// clean up memory
 	for (int i = 0; i < numMxs; ++i)
 		matrix_destroy(&hMxs[i]);
-	free(hMxs);
+	matrix_free(hMxs);
 	matrix_destroy(&hMxRes);
-	free(entries);
+	matrix_free(entries);
 
 	return SUCCESS;
 }
@@ -1053,7 +1190,7 @@ Status menu_matrixOpTrans(void) {
 
 	// get the dimensions of the matrix from user input
 	displayDimsPrompt(TRANS, NULL);
-	userInputGetDims(TRANS, &rows, &cols);
+	userInputGetDims(TRANS, NULL, &rows, &cols);
 
 	// create the matrix to be tranposed
 	if (!(hMx = matrix_initDims(rows, cols)))
@@ -1069,14 +1206,14 @@ Status menu_matrixOpTrans(void) {
 	userInputGetEntries(entries, rows, cols);
 	if (!matrix_newMatrix(hMx, entries, rows, cols)) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
 	// perform the transpose operation
 	if (!matrix_opTrans(hMx, &hMxRes)) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -1086,7 +1223,7 @@ Status menu_matrixOpTrans(void) {
 	// clean up memory
 	matrix_destroy(&hMxRes);
 	matrix_destroy(&hMx);
-	free(entries);
+	matrix_free(entries);
 
 	return SUCCESS;
 }
@@ -1102,7 +1239,7 @@ Status menu_matrixOpDet(void) {
 
 	// get the dimensions of the matrix from user input
 	displayDimsPrompt(DET, NULL);
-	userInputGetDims(DET, &rows, &cols);
+	userInputGetDims(DET, NULL, &rows, &cols);
 
 	// create the matrix to calculate the determinant of
 	if (!(hMx = matrix_initDims(rows, cols)))
@@ -1118,7 +1255,7 @@ Status menu_matrixOpDet(void) {
 	userInputGetEntries(entries, rows, cols);
 	if (!matrix_newMatrix(hMx, entries, rows, cols)) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -1127,7 +1264,7 @@ Status menu_matrixOpDet(void) {
 	res = matrix_opDet(hMx, &mem);
 	if (!mem) {
 		matrix_destroy(&hMx);
-		free(entries);
+		matrix_free(entries);
 		return FAILURE;
 	}
 
@@ -1136,7 +1273,7 @@ Status menu_matrixOpDet(void) {
 
 	// clean up memory
 	matrix_destroy(&hMx);
-	free(entries);
+	matrix_free(entries);
 
 	return SUCCESS;
 }
@@ -1179,6 +1316,8 @@ static void displayDimsPrompt(MenuOption op, const int *pMxNum) {
 		printf("matrix");
 	else if (op == ADD || op == SUB)
 		printf("matrices");
+	else if (op == SOLVE)
+		printf("matrix %s in A X = B", (*pMxNum == 1) ? "A" : "B");
 	else { // MULT
 		createOrdinalNum(ordNum, *pMxNum);
 		printf("%s matrix", ordNum);
@@ -1195,6 +1334,16 @@ static void displayDimsPrompt(MenuOption op, const int *pMxNum) {
 			strcpy(opStr, "inverse");
 		printf("For the matrix %s operation, the rows must equal the columns.\n", opStr);
 	}
+	else if (op == SOLVE) {
+		if (*pMxNum == 1) {
+			cols = 3;
+			printf("To solve a linear system, the rows of A must equal the columns of A.\n");
+		}
+		else {
+			cols = 2;
+			printf("To solve a linear system, the rows of B must equal the rows of A. Each column of B is a separate right-hand side.\n");
+		}
+	}
 	else { // MULT, ADD, SUB, TRANS
 		cols = 5;
 		if (op == MULT)
@@ -1290,6 +1439,26 @@ static void displayResultsMatrixOpPow(MATRIX hMx, int power, MATRIX hMxRes) {
 }
 
 
+static void displayResultsMatrixOpSolve(MATRIX hMxA, MATRIX hMxB, Boolean mxIsInvertible, MATRIX hMxX) {
+	if (!mxIsInvertible) {
+		printf("\n\nThe system A X = B where A is\n");
+		matrix_print(hMxA);
+		printf("\n\n");
+		printf("and B is\n");
+		matrix_print(hMxB);
+		printf("\n\n");
+		printf("has the solution X\n");
+		matrix_print(hMxX);
+		printf("\n\n");
+	}
+	else {
+		printf("\n\nThe determinant of the following matrix A is 0. Therefore, A X = B has no unique solution.\n");
+		matrix_print(hMxA);
+		printf("\n\n");
+	}
+}
+
+
 static void displayResultsMatrixOpSub(MATRIX* hMxs, int hMxsSize, MATRIX hMxRes) {
 	printf("\n\nThe %d matrices being subtracted are\n", hMxsSize);
 	for (int i = 0; i < hMxsSize; ++i) {
@@ -1325,7 +1494,9 @@ static void displayRoundMessage(const MenuOptionMessages menuOptionMessages[], i
 
 
 static double* entriesInitDims(int rows, int cols) {
-	double *entries = calloc(rows * cols, sizeof(*entries));
+	double *entries = matrix_alloc(sizeof(*entries) * rows * cols);
+	if (entries)
+		memset(entries, 0, sizeof(*entries) * rows * cols);
 	return entries;
 }
 
@@ -1561,7 +1732,7 @@ static Boolean inputsAreValidPositiveInts(const char* input, int expectedNums) {
 }
 
 
-static void userInputGetDims(MenuOption op, int* pRows, int* pCols) {
+static void userInputGetDims(MenuOption op, const int* pMxNum, int* pRows, int* pCols) {
 	char input[INPUT_BUF_CAP];
 	Boolean areValidDims;
 
@@ -1575,8 +1746,8 @@ static void userInputGetDims(MenuOption op, int* pRows, int* pCols) {
 			areValidDims = FALSE;
 		} else {
 			sscanf(input, "%d%d", pRows, pCols);
-			// if power, determinant, or inverse, the rows must equal the columns
-			if ((op == POW || op == DET|| op == INV) && *pRows != *pCols) {
+			// if power, determinant, inverse, or A in a linear system, the rows must equal the columns
+			if ((op == POW || op == DET|| op == INV || (op == SOLVE && *pMxNum == 1)) && *pRows != *pCols) {
 				printf("Error - the dimensions entered are not valid. The rows must equal the columns. Enter again.\n");
 				areValidDims = FALSE;
 			}
@@ -20,7 +20,8 @@ typedef enum menuOption {
     POW,    // power
     TRANS,  // transpose
     DET,    // determinant
-    INV     // inverse
+    INV,    // inverse
+    SOLVE   // solve a linear system
 } MenuOption;
 
 
@@ -186,6 +187,30 @@ Failure
 Status menu_matrixOpPow(void);
 
 
+/*
+NOTES
+  - Name:     menu_matrixOpSolve
+  - Purpose:  Implements solving a linear system.
+              A X = B for X where A is a matrix whose rows equal its columns and B is a matrix with the same rows as A.
+PRECONDITION
+  - User has selected to solve a linear system.
+POSTCONDITION
+Success
+  - Reason:        No memory allocation failure.
+  - Summary:       Implements solving a linear system.
+                     - Prompts the user to enter the dimensions and entries of A and B.
+                     - Solves the system.
+                     - Displays the results.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation failure.
+  - Summary:       Doesn't implement solving a linear system.
+                   Much or little could've happened up until the point of failure because it can happen on numerous occasions.
+  - Return value:  FAILURE
+*/
+Status menu_matrixOpSolve(void);
+
+
 /*
 NOTES
   - Name:     menu_matrixOpSub
@@ -0,0 +1,332 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         ThreadPool.c
+  Description:  Implementation file for the worker thread pool shared by the matrix operations.
+*/
+
+
+#define _POSIX_C_SOURCE 200809L    // sysconf
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+
+typedef struct threadPool {
+	pthread_t* workers;                   // threads other than the one that calls threadPool_run
+	int numWorkers;                       // workers that are running
+	int numThreads;                       // threads per job including the caller, 0 until first use
+	Status (*task)(void* arg, int taskIdx);    // task function of the current job
+	void* arg;                            // argument of the current job
+	int numTasks;                         // tasks in the current job
+	int nextTask;                         // next task of the current job that no thread has taken
+	int activeWorkers;                    // workers that haven't finished the current job
+	unsigned long job;                    // incremented for every job so a worker can tell a new job from a spurious wakeup
+	unsigned long startJob;               // value of job when the workers were started, so a worker that starts late still runs the next job
+	Status status;                        // FAILURE if a task of the current job failed
+	Boolean shutdown;                     // tells the workers to exit
+	void (*workerStart)(void);            // run by each worker when it starts, NULL for none
+} ThreadPool;
+
+
+
+
+/*********** Declarations for helper functions defined in this file **********/
+/*
+FUNCTION
+  - Name:     defaultNumThreads
+  - Purpose:  Get the number of threads to use when it hasn't been set with threadPool_setNumThreads.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Reads the environment variable MATRIX_NUM_THREADS, falling back to the number of online processors.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+static int defaultNumThreads(void);
+
+
+/*
+FUNCTION
+  - Name:     runTasks
+  - Purpose:  Take and run unstarted tasks of the current job until there are none left.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Runs tasks and records a failure in the pool.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void runTasks(void);
+
+
+/*
+FUNCTION
+  - Name:     startWorkers
+  - Purpose:  Start one fewer workers than the number of threads if they aren't already running.
+              Must be called with runLock held.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        No memory allocation or thread creation failure.
+  - Summary:       The workers are running and waiting for a job.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        Memory allocation or thread creation failure.
+  - Summary:       No workers are running.
+  - Return value:  FAILURE
+*/
+static Status startWorkers(void);
+
+
+/*
+FUNCTION
+  - Name:     stopWorkers
+  - Purpose:  Stop the workers and wait for them to exit.
+              Must be called with runLock held.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       No workers are running.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+static void stopWorkers(void);
+
+
+/*
+FUNCTION
+  - Name:     workerMain
+  - Purpose:  Run the worker start function if one is set, then wait for jobs and run their tasks until the pool shuts down.
+PRECONDITION
+  - unused
+      Purpose:       Required by pthread_create.
+      Restrictions:  N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns when the pool shuts down.
+  - Return value:  NULL
+Failure
+  - N/A
+*/
+static void* workerMain(void* unused);
+
+
+static ThreadPool pool = { NULL, 0, 0, NULL, NULL, 0, 0, 0, 0, 0, SUCCESS, FALSE, NULL };
+static pthread_mutex_t runLock = PTHREAD_MUTEX_INITIALIZER;    // held while a job runs or the workers are resized
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;       // guards the fields of pool
+static pthread_cond_t jobReady = PTHREAD_COND_INITIALIZER;     // signaled when a job is posted or the pool shuts down
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;      // signaled when the last worker finishes a job
+
+
+
+
+/********** Definitions for thread pool functions declared in ThreadPool.h **********/
+int threadPool_getNumThreads(void) {
+	int numThreads;
+
+	pthread_mutex_lock(&lock);
+	if (!pool.numThreads)
+		pool.numThreads = defaultNumThreads();
+	numThreads = pool.numThreads;
+	pthread_mutex_unlock(&lock);
+
+	return numThreads;
+}
+
+
+Status threadPool_run(Status (*task)(void* arg, int taskIdx), void* arg, int numTasks) {
+	Status status = SUCCESS;
+
+
+	// run the job on the pool unless it's busy, e.g. a task is itself trying to run a job
+	if (numTasks > 1 && threadPool_getNumThreads() > 1 && !pthread_mutex_trylock(&runLock)) {
+		if (startWorkers()) {
+			pthread_mutex_lock(&lock);
+			pool.task = task;
+			pool.arg = arg;
+			pool.numTasks = numTasks;
+			pool.nextTask = 0;
+			pool.activeWorkers = pool.numWorkers;
+			pool.status = SUCCESS;
+			++pool.job;
+			pthread_cond_broadcast(&jobReady);
+			pthread_mutex_unlock(&lock);
+
+			// the calling thread works on the job too
+			runTasks();
+
+			pthread_mutex_lock(&lock);
+			while (pool.activeWorkers)
+				pthread_cond_wait(&jobDone, &lock);
+			status = pool.status;
+			pthread_mutex_unlock(&lock);
+			pthread_mutex_unlock(&runLock);
+			return status;
+		}
+		pthread_mutex_unlock(&runLock);
+	}
+
+	// run the job on the calling thread
+	for (int i = 0; i < numTasks; ++i) {
+		if (!task(arg, i))
+			status = FAILURE;
+	}
+
+	return status;
+}
+
+
+Status threadPool_setNumThreads(int numThreads) {
+	if (numThreads < 1)
+		return FAILURE;
+
+	pthread_mutex_lock(&runLock);
+	stopWorkers();
+	pthread_mutex_lock(&lock);
+	pool.numThreads = numThreads;
+	pthread_mutex_unlock(&lock);
+	pthread_mutex_unlock(&runLock);
+
+	return SUCCESS;
+}
+
+
+void threadPool_setWorkerStart(void (*start)(void)) {
+	pthread_mutex_lock(&runLock);
+	stopWorkers();
+	pthread_mutex_lock(&lock);
+	pool.workerStart = start;
+	pthread_mutex_unlock(&lock);
+	pthread_mutex_unlock(&runLock);
+}
+
+
+
+
+/********** Helper function definitions **********/
+static int defaultNumThreads(void) {
+	const char* env = getenv("MATRIX_NUM_THREADS");
+	long numThreads;
+	char* end;
+
+	if (env) {
+		numThreads = strtol(env, &end, 10);
+		if (end != env && !*end && numThreads > 0 && numThreads <= 4096)
+			return numThreads;
+	}
+	numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return numThreads > 0 ? numThreads : 1;
+}
+
+
+static void runTasks(void) {
+	Status (*task)(void* arg, int taskIdx);
+	void* arg;
+	int taskIdx;
+
+	for (;;) {
+		pthread_mutex_lock(&lock);
+		if (pool.nextTask >= pool.numTasks) {
+			pthread_mutex_unlock(&lock);
+			return;
+		}
+		taskIdx = pool.nextTask++;
+		task = pool.task;
+		arg = pool.arg;
+		pthread_mutex_unlock(&lock);
+
+		if (!task(arg, taskIdx)) {
+			pthread_mutex_lock(&lock);
+			pool.status = FAILURE;
+			pthread_mutex_unlock(&lock);
+		}
+	}
+}
+
+
+static Status startWorkers(void) {
+	int numWorkers = threadPool_getNumThreads() - 1;
+
+	if (pool.numWorkers == numWorkers)
+		return SUCCESS;
+	stopWorkers();
+
+	if (!(pool.workers = malloc(sizeof(*pool.workers) * numWorkers)))
+		return FAILURE;
+	pthread_mutex_lock(&lock);
+	pool.startJob = pool.job;
+	pthread_mutex_unlock(&lock);
+	for (; pool.numWorkers < numWorkers; ++pool.numWorkers) {
+		if (pthread_create(&pool.workers[pool.numWorkers], NULL, workerMain, NULL)) {
+			stopWorkers();
+			return FAILURE;
+		}
+	}
+
+	return SUCCESS;
+}
+
+
+static void stopWorkers(void) {
+	pthread_mutex_lock(&lock);
+	pool.shutdown = TRUE;
+	pthread_cond_broadcast(&jobReady);
+	pthread_mutex_unlock(&lock);
+
+	for (int i = 0; i < pool.numWorkers; ++i)
+		pthread_join(pool.workers[i], NULL);
+	free(pool.workers);
+	pool.workers = NULL;
+	pool.numWorkers = 0;
+
+	pthread_mutex_lock(&lock);
+	pool.shutdown = FALSE;
+	pthread_mutex_unlock(&lock);
+}
+
+
+static void* workerMain(void* unused) {
+	unsigned long lastJob;    // last job this worker ran
+	void (*start)(void);
+	(void)unused;
+
+	pthread_mutex_lock(&lock);
+	start = pool.workerStart;
+	pthread_mutex_unlock(&lock);
+	if (start)
+		start();
+
+	pthread_mutex_lock(&lock);
+	lastJob = pool.startJob;
+	for (;;) {
+		while (pool.job == lastJob && !pool.shutdown)
+			pthread_cond_wait(&jobReady, &lock);
+		if (pool.shutdown)
+			break;
+		lastJob = pool.job;
+		pthread_mutex_unlock(&lock);
+
+		runTasks();
+
+		pthread_mutex_lock(&lock);
+		if (!--pool.activeWorkers)
+			pthread_cond_signal(&jobDone);
+	}
+	pthread_mutex_unlock(&lock);
+
+	return NULL;
+}
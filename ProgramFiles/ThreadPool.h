@@ -0,0 +1,110 @@
+/*
+  Author:       Benjamin G. Friedman
+  Date:         05/20/2021
+  File:         ThreadPool.h
+  Description:  Header file for the worker thread pool shared by the matrix operations.
+                The pool is created on first use and its workers wait between jobs instead of being created for every operation.
+*/
+
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "Status.h"
+
+
+
+
+/*
+FUNCTION
+  - Name:     threadPool_getNumThreads
+  - Purpose:  Get the number of threads that run a job, counting the thread that calls threadPool_run.
+              Unless set with threadPool_setNumThreads, on first use it is read from the environment variable MATRIX_NUM_THREADS
+              or, if that isn't a positive integer, set to the number of online processors.
+PRECONDITION
+  - N/A
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Returns the number of threads.
+  - Return value:  Any positive integer.
+Failure
+  - N/A
+*/
+int threadPool_getNumThreads(void);
+
+
+/*
+FUNCTION
+  - Name:     threadPool_run
+  - Purpose:  Run tasks 0 to numTasks - 1 of a job on the pool and wait for all of them to finish.
+              Idle threads take the next unstarted task so uneven tasks balance out.
+              If the pool is already running a job (from another thread or from inside a task) or its workers can't be started, the tasks run one after another on the calling thread.
+PRECONDITION
+  - task
+      Purpose:       Run one task of the job.
+      Restrictions:  Returns SUCCESS or FAILURE. Tasks of the same job may run at the same time so they must not write to the same memory.
+  - arg
+      Purpose:       Passed to every task.
+      Restrictions:  N/A
+  - numTasks
+      Purpose:       Number of tasks in the job.
+      Restrictions:  Any integer >= 0.
+POSTCONDITION
+Success
+  - Reason:        Every task returns SUCCESS.
+  - Summary:       All the tasks have run.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        A task returns FAILURE.
+  - Summary:       All the tasks have run.
+  - Return value:  FAILURE
+*/
+Status threadPool_run(Status (*task)(void* arg, int taskIdx), void* arg, int numTasks);
+
+
+/*
+FUNCTION
+  - Name:     threadPool_setNumThreads
+  - Purpose:  Set the number of threads that run a job, counting the thread that calls threadPool_run.
+              Waits for a running job to finish, then stops the current workers. The new workers start with the next job.
+              Must not be called from inside a task.
+PRECONDITION
+  - numThreads
+      Purpose:       Number of threads.
+      Restrictions:  Any integer.
+POSTCONDITION
+Success
+  - Reason:        numThreads is positive.
+  - Summary:       Sets the number of threads.
+  - Return value:  SUCCESS
+Failure
+  - Reason:        numThreads isn't positive.
+  - Summary:       The number of threads is preserved.
+  - Return value:  FAILURE
+*/
+Status threadPool_setNumThreads(int numThreads);
+
+
+/*
+FUNCTION
+  - Name:     threadPool_setWorkerStart
+  - Purpose:  Set a function every worker runs when it starts, before it waits for its first job, e.g. to set up memory its tasks reuse.
+              Waits for a running job to finish, then stops the current workers so the ones started with the next job run it.
+              Must not be called from inside a task.
+PRECONDITION
+  - start
+      Purpose:       Run on each worker when it starts.
+      Restrictions:  NULL for none.
+POSTCONDITION
+Success
+  - Reason:        All cases.
+  - Summary:       Sets the function.
+  - Return value:  N/A
+Failure
+  - N/A
+*/
+void threadPool_setWorkerStart(void (*start)(void));
+
+
+#endif